@@ -0,0 +1,306 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file bench.h
+ * @brief
+ *
+ * This file provides the harness of the benchmark suite. A benchmark is
+ * registered with its name, element type and size, and a setup function
+ * returning the code to time; the setup runs only for the selected
+ * benchmarks and is not timed. Every benchmark is warmed up, then timed
+ * over a few samples, each sample calling it until min_time is spent,
+ * the median time per call is reported. The inputs are made from fixed
+ * seeds, two runs time the same work.
+ *
+ * Options of a benchmark program:
+ *
+ *     --filter TEXT    run the benchmarks whose name contains TEXT
+ *     --min-time S     seconds per sample, 0.05
+ *     --samples N      samples per benchmark, 5
+ *     --json FILE      write the results to FILE
+ *     --compare FILE   compare with results written by --json, exit status
+ *                      1 if a benchmark is slower than in FILE by more
+ *                      than the threshold
+ *     --threshold R    allowed slowdown, 0.10 for 10%
+ *     --list           print the names of the benchmarks
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <map>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+#include "thread_pool.h"
+
+namespace bench
+{
+    /**
+     * Keeps a result alive so the compiler doesn't drop its computation
+     */
+    template <typename T>
+    inline void keep(const T &val)
+    {
+        asm volatile("" : : "r"(&val) : "memory");
+    }
+
+    struct result
+    {
+        std::string name;
+        std::string group;
+        std::string type;
+        long long size;
+        /**
+         * median and minimum nanoseconds per call
+         */
+        double ns;
+        double min_ns;
+        long long iterations;
+        /**
+         * what work counts (flop, element, byte...), and how much per call
+         */
+        std::string unit;
+        double work;
+    };
+
+    class suite
+    {
+    public:
+      using runner = std::function<void()>;
+
+      /**
+         * Registers a benchmark named group/type/size
+         * @param unit what work counts, work is done per call
+         * @param setup makes the inputs, returns the code to time
+         */
+      void add(const std::string &group, const std::string &type, long long size,
+               const std::string &unit, double work, std::function<runner()> setup)
+      {
+        entries.push_back({group + "/" + type + "/" + std::to_string(size), group, type, size,
+                           unit, work, std::move(setup)});
+      }
+
+      /**
+         * Runs the benchmarks selected by the options
+         * @returns the exit status of the program
+         */
+      int run(int argc, char **argv)
+      {
+        std::string filter, json, baseline;
+        double min_time = 0.05, threshold = 0.10;
+        int samples = 5;
+        bool list = false;
+        for (int i = 1; i < argc; i++)
+        {
+          const std::string arg = argv[i];
+          const bool has_value = i + 1 < argc;
+          if (arg == "--filter" && has_value)
+            filter = argv[++i];
+          else if (arg == "--min-time" && has_value)
+            min_time = std::atof(argv[++i]);
+          else if (arg == "--samples" && has_value)
+            samples = std::max(1, std::atoi(argv[++i]));
+          else if (arg == "--json" && has_value)
+            json = argv[++i];
+          else if (arg == "--compare" && has_value)
+            baseline = argv[++i];
+          else if (arg == "--threshold" && has_value)
+            threshold = std::atof(argv[++i]);
+          else if (arg == "--list")
+            list = true;
+          else
+          {
+            std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return 2;
+          }
+        }
+
+        std::map<std::string, double> base;
+        if (!baseline.empty() && !read_json(baseline, base))
+        {
+          std::fprintf(stderr, "cannot read %s\n", baseline.c_str());
+          return 2;
+        }
+
+        std::vector<result> results;
+        if (!list)
+          std::printf("%-36s %14s %14s %12s\n", "benchmark", "median", "min", "rate");
+        for (const entry &e : entries)
+        {
+          if (e.name.find(filter) == std::string::npos)
+            continue;
+          if (list)
+          {
+            std::printf("%s\n", e.name.c_str());
+            continue;
+          }
+          result res = measure(e, min_time, samples);
+          std::printf("%-36s %14s %14s %8.3g G%s/s\n", res.name.c_str(), format_time(res.ns).c_str(),
+                      format_time(res.min_ns).c_str(), res.work / res.ns, res.unit.c_str());
+          std::fflush(stdout);
+          results.push_back(std::move(res));
+        }
+
+        if (!json.empty() && !write_json(json, results, min_time, samples))
+        {
+          std::fprintf(stderr, "cannot write %s\n", json.c_str());
+          return 2;
+        }
+        return baseline.empty() ? 0 : compare(results, base, threshold);
+      }
+
+    private:
+      struct entry
+      {
+        std::string name;
+        std::string group;
+        std::string type;
+        long long size;
+        std::string unit;
+        double work;
+        std::function<runner()> setup;
+      };
+
+      using clock = std::chrono::steady_clock;
+
+      static double seconds(const runner &fn, long long iterations)
+      {
+        const clock::time_point start = clock::now();
+        for (long long i = 0; i < iterations; i++)
+          fn();
+        return std::chrono::duration<double>(clock::now() - start).count();
+      }
+
+      static result measure(const entry &e, double min_time, int samples)
+      {
+        const runner fn = e.setup();
+        fn();
+        // double the calls until a tenth of a sample, then scale
+        long long iterations = 1;
+        double t;
+        while ((t = seconds(fn, iterations)) < min_time / 10)
+          iterations *= 2;
+        iterations = std::max(1LL, static_cast<long long>(iterations * min_time / t));
+
+        std::vector<double> times;
+        for (int s = 0; s < samples; s++)
+          times.push_back(seconds(fn, iterations) * 1e9 / iterations);
+        std::sort(times.begin(), times.end());
+        return {e.name, e.group, e.type, e.size, times[times.size() / 2], times[0], iterations, e.unit, e.work};
+      }
+
+      static std::string format_time(double ns)
+      {
+        char buf[32];
+        if (ns < 1e3)
+          std::snprintf(buf, sizeof(buf), "%.1f ns", ns);
+        else if (ns < 1e6)
+          std::snprintf(buf, sizeof(buf), "%.2f us", ns / 1e3);
+        else if (ns < 1e9)
+          std::snprintf(buf, sizeof(buf), "%.2f ms", ns / 1e6);
+        else
+          std::snprintf(buf, sizeof(buf), "%.2f s", ns / 1e9);
+        return buf;
+      }
+
+      /**
+         * One result per line, read back by read_json
+         */
+      static bool write_json(const std::string &path, const std::vector<result> &results, double min_time, int samples)
+      {
+        std::ofstream out(path);
+        if (!out)
+          return false;
+        out << "{\n  \"context\": {\"threads\": " << matrix_parallel::get_num_threads()
+            << ", \"compiler\": \"" << __VERSION__ << "\", \"min_time\": " << min_time
+            << ", \"samples\": " << samples << "},\n  \"results\": [\n";
+        char line[512];
+        for (std::size_t i = 0; i < results.size(); i++)
+        {
+          const result &r = results[i];
+          std::snprintf(line, sizeof(line),
+                        "    {\"name\": \"%s\", \"group\": \"%s\", \"type\": \"%s\", \"size\": %lld, "
+                        "\"ns\": %.6g, \"min_ns\": %.6g, \"iterations\": %lld, \"unit\": \"%s\", \"work\": %.6g}%s\n",
+                        r.name.c_str(), r.group.c_str(), r.type.c_str(), r.size, r.ns, r.min_ns,
+                        r.iterations, r.unit.c_str(), r.work, i + 1 < results.size() ? "," : "");
+          out << line;
+        }
+        out << "  ]\n}\n";
+        return static_cast<bool>(out);
+      }
+
+      /**
+         * Reads the name and median time of the results of a file
+         * written by write_json
+         */
+      static bool read_json(const std::string &path, std::map<std::string, double> &times)
+      {
+        std::ifstream in(path);
+        if (!in)
+          return false;
+        const std::string name_tag = "\"name\": \"", ns_tag = "\"ns\": ";
+        std::string line;
+        while (std::getline(in, line))
+        {
+          const std::size_t name = line.find(name_tag);
+          const std::size_t ns = line.find(ns_tag);
+          if (name == std::string::npos || ns == std::string::npos)
+            continue;
+          const std::size_t first = name + name_tag.size();
+          const std::size_t last = line.find('"', first);
+          times[line.substr(first, last - first)] = std::strtod(line.c_str() + ns + ns_tag.size(), nullptr);
+        }
+        return true;
+      }
+
+      static int compare(const std::vector<result> &results, const std::map<std::string, double> &base, double threshold)
+      {
+        std::printf("\n%-36s %14s %14s %8s\n", "benchmark", "baseline", "now", "ratio");
+        int regressions = 0;
+        for (const result &r : results)
+        {
+          auto found = base.find(r.name);
+          if (found == base.end())
+          {
+            std::printf("%-36s %14s %14s %8s  new\n", r.name.c_str(), "-", format_time(r.ns).c_str(), "-");
+            continue;
+          }
+          const double ratio = r.ns / found->second;
+          const char *verdict = "";
+          if (ratio > 1 + threshold)
+          {
+            verdict = "  REGRESSION";
+            regressions++;
+          }
+          else if (ratio < 1 - threshold)
+            verdict = "  faster";
+          std::printf("%-36s %14s %14s %8.3f%s\n", r.name.c_str(), format_time(found->second).c_str(),
+                      format_time(r.ns).c_str(), ratio, verdict);
+        }
+        std::printf("\n%d regression(s) over %.0f%%\n", regressions, threshold * 100);
+        return regressions ? 1 : 0;
+      }
+
+      std::vector<entry> entries;
+    };
+}
+
+#endif // End of the file
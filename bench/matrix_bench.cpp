@@ -0,0 +1,255 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_bench.cpp
+ * @brief
+ *
+ * The benchmark suite of the hot paths, for float, double and
+ * complex<float> across sizes:
+ *
+ *     multiply, transpose, invert, determinant, determinant_recursive,
+ *     back_substitution          n x n matrices
+ *     add, mul, compound_add     element-wise operators of matrices
+ *     vec_add, vec_fused, dot    vector_arithmetic
+ *     parse                      parse_input of an n x n matrix literal
+ *
+ * The result cache is turned off, the operations are computed every call.
+ * The options are those of bench.h, e.g.
+ *
+ *     ./bench/matrix_bench.out --filter invert/double --json now.json
+ *     ./bench/matrix_bench.out --compare bench/baseline.json
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+#include <random>
+#include <string>
+#include <vector>
+#include <complex>
+#include <type_traits>
+
+#include "bench.h"
+#include "matrix.h"
+#include "parsing.h"
+#include "vector_arithmetic.h"
+
+using std::complex;
+using std::string;
+using std::vector;
+
+template <typename T>
+struct type_name;
+
+template <>
+struct type_name<float>
+{
+    static constexpr const char *value = "float";
+};
+
+template <>
+struct type_name<double>
+{
+    static constexpr const char *value = "double";
+};
+
+template <>
+struct type_name<complex<float>>
+{
+    static constexpr const char *value = "complex_float";
+};
+
+/**
+ * value in [-1, 1), both parts of a complex one
+ */
+template <typename T>
+static T random_value(std::mt19937 &gen)
+{
+    std::uniform_real_distribution<float> dist(-1, 1);
+    if constexpr (std::is_same<T, complex<float>>::value)
+    {
+        const float re = dist(gen);
+        return T(re, dist(gen));
+    }
+    else
+        return static_cast<T>(dist(gen));
+}
+
+/**
+ * n x n matrix of a fixed seed, diagonally dominant so that it can be
+ * inverted and factorized without trouble
+ */
+template <typename T>
+static matrix<T> random_matrix(int n, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    matrix<T> mat(n, n);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+            mat[i][j] = random_value<T>(gen);
+        mat[i][i] += static_cast<T>(n);
+    }
+    return mat;
+}
+
+template <typename T>
+static vector<T> random_vector(std::size_t n, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    vector<T> vec(n);
+    for (T &val : vec)
+        val = random_value<T>(gen);
+    return vec;
+}
+
+/**
+ * the calculator syntax of a random n x n matrix
+ */
+template <typename T>
+static string random_literal(int n, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> digits(-99999, 99999);
+    string text = "[";
+    char buf[64];
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            if constexpr (std::is_same<T, complex<float>>::value)
+                snprintf(buf, sizeof(buf), "%.3f%+.3fi", digits(gen) / 1000.0, digits(gen) / 1000.0);
+            else
+                snprintf(buf, sizeof(buf), "%.3f", digits(gen) / 1000.0);
+            text += buf;
+            if (j < n - 1)
+                text += ' ';
+        }
+        if (i < n - 1)
+            text += ';';
+    }
+    return text + "]";
+}
+
+template <typename T>
+static void add_matrix_benchmarks(bench::suite &suite)
+{
+    // the FLOP models of the profiler, the rates of both agree
+    namespace flops = matrix_profile::flops;
+    const string type = type_name<T>::value;
+
+    for (int n : {16, 64, 256})
+    {
+        suite.add("multiply", type, n, "flop", flops::gemm(n, n, n), [n] {
+            return [a = random_matrix<T>(n, 1), b = random_matrix<T>(n, 2)]() mutable {
+                bench::keep(a.multiply(b));
+            };
+        });
+        suite.add("invert", type, n, "flop", flops::inverse(n), [n] {
+            return [a = random_matrix<T>(n, 1)]() mutable { bench::keep(a.invert()); };
+        });
+        suite.add("determinant", type, n, "flop", flops::lu(n), [n] {
+            return [a = random_matrix<T>(n, 1)] { bench::keep(determinant(a)); };
+        });
+        // floating point matrices above the subset kernel are given to the LU
+        const bool by_lu = n > matrix_kernels::det_subset_max && matrix_kernels::det_is_inexact<T>::value;
+        suite.add("determinant_recursive", type, n, "flop", by_lu ? flops::lu(n) : flops::det_division_free(n), [n] {
+            return [a = random_matrix<T>(n, 1)] { bench::keep(determinant_recursive(a)); };
+        });
+        suite.add("back_substitution", type, n, "flop", flops::solve(n), [n] {
+            return [a = random_matrix<T>(n, 1), b = random_vector<T>(n, 2)] {
+                bench::keep(back_substitution(a, b));
+            };
+        });
+    }
+
+    for (int n : {64, 256, 1024})
+    {
+        const double elements = static_cast<double>(n) * n;
+        suite.add("transpose", type, n, "elem", elements, [n] {
+            return [a = random_matrix<T>(n, 1)]() mutable { bench::keep(a.transpose()); };
+        });
+        suite.add("add", type, n, "elem", elements, [n] {
+            return [a = random_matrix<T>(n, 1), b = random_matrix<T>(n, 2), c = matrix<T>(n, n)]() mutable {
+                c = a + b;
+                bench::keep(c);
+            };
+        });
+        suite.add("mul", type, n, "elem", elements, [n] {
+            return [a = random_matrix<T>(n, 1), b = random_matrix<T>(n, 2), c = matrix<T>(n, n)]() mutable {
+                c = a * b;
+                bench::keep(c);
+            };
+        });
+        suite.add("compound_add", type, n, "elem", elements, [n] {
+            return [a = random_matrix<T>(n, 1), b = random_matrix<T>(n, 2)]() mutable {
+                a += b;
+                bench::keep(a);
+            };
+        });
+    }
+}
+
+template <typename T>
+static void add_vector_benchmarks(bench::suite &suite)
+{
+    using namespace vector_arithmetic_operations;
+    const string type = type_name<T>::value;
+
+    for (long long n : {1024LL, 65536LL, 1048576LL})
+    {
+        suite.add("vec_add", type, n, "elem", n, [n] {
+            return [a = random_vector<T>(n, 1), b = random_vector<T>(n, 2)]() mutable {
+                a += b;
+                bench::keep(a);
+            };
+        });
+        suite.add("vec_fused", type, n, "elem", n, [n] {
+            return [a = random_vector<T>(n, 1), b = random_vector<T>(n, 2), c = random_vector<T>(n, 3)] {
+                vector<T> res = a + b * c;
+                bench::keep(res);
+            };
+        });
+        suite.add("dot", type, n, "elem", n, [n] {
+            return [a = random_vector<T>(n, 1), b = random_vector<T>(n, 2)] {
+                bench::keep(dot_product(a, b));
+            };
+        });
+    }
+}
+
+template <typename T>
+static void add_parse_benchmarks(bench::suite &suite)
+{
+    for (int n : {16, 64, 256})
+    {
+        const string text = random_literal<T>(n, 1);
+        suite.add("parse", type_name<T>::value, n, "byte", text.size(), [text] {
+            return [text] { bench::keep(parse_input<T>(text)); };
+        });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // every call computes its result
+    matrix_cache::set_capacity(0);
+    matrix_cache::set_spill_dir("");
+
+    bench::suite suite;
+    add_matrix_benchmarks<float>(suite);
+    add_matrix_benchmarks<double>(suite);
+    add_matrix_benchmarks<complex<float>>(suite);
+    add_vector_benchmarks<float>(suite);
+    add_vector_benchmarks<double>(suite);
+    add_vector_benchmarks<complex<float>>(suite);
+    add_parse_benchmarks<float>(suite);
+    add_parse_benchmarks<double>(suite);
+    add_parse_benchmarks<complex<float>>(suite);
+    return suite.run(argc, argv);
+}
@@ -0,0 +1,268 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file parse_bench.cpp
+ * @brief
+ *
+ * Micro-benchmark of the number conversion of the parser, in tokens per
+ * second, for real and complex tokens:
+ *
+ *     atof     the old path, atof on std::string tokens, complex tokens
+ *              scanned with find("i"), find("+"), find("-", 1)
+ *     strtof   strtof on the token range, complex split at the last sign
+ *     lexer    lex_real / lex_complex of number_lexer.h, float and double
+ *
+ * and the whole parse_input of one line holding all the tokens.
+ *
+ * Use: make bench/parse_bench.out && ./bench/parse_bench.out [tokens]
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#include "parsing.h"
+#include "number_lexer.h"
+
+using std::complex;
+using std::string;
+using std::vector;
+
+/**
+ * the tokens, as strings for the old path and as ranges of one line
+ */
+struct token_set
+{
+    vector<string> tokens;
+    string line;
+    vector<std::pair<std::size_t, std::size_t>> ranges;
+};
+
+static string random_real(std::mt19937 &gen)
+{
+    char buf[32];
+    switch (gen() % 3)
+    {
+    case 0:
+        snprintf(buf, sizeof(buf), "%d", static_cast<int>(gen() % 2000) - 1000);
+        break;
+    case 1:
+        snprintf(buf, sizeof(buf), "%.4g", (static_cast<int>(gen() % 200000) - 100000) / 100.0);
+        break;
+    default:
+        snprintf(buf, sizeof(buf), "%.3e", (gen() % 100000) / 7.0);
+        break;
+    }
+    return buf;
+}
+
+static string random_complex(std::mt19937 &gen)
+{
+    const string re = random_real(gen);
+    string im = random_real(gen);
+    switch (gen() % 4)
+    {
+    case 0:
+        return re;
+    case 1:
+        return im + "i";
+    default:
+        if (im[0] != '-')
+            im = "+" + im;
+        return re + im + "i";
+    }
+}
+
+static token_set make_tokens(std::size_t count, bool complex_tokens)
+{
+    std::mt19937 gen(42);
+    token_set set;
+    set.line = "[";
+    for (std::size_t i = 0; i < count; i++)
+    {
+        string tok = complex_tokens ? random_complex(gen) : random_real(gen);
+        set.ranges.emplace_back(set.line.size(), set.line.size() + tok.size());
+        set.line += tok;
+        set.line += ' ';
+        set.tokens.push_back(std::move(tok));
+    }
+    set.line += "]";
+    return set;
+}
+
+/**
+ * The old conversion of a complex token
+ */
+static complex<float> atof_complex(string s)
+{
+    if (s.find("i") != string::npos)
+    {
+        if (s.find("+") != string::npos || s.find("-", 1) != string::npos)
+        {
+            float r = atof(s.c_str());
+            std::ostringstream os;
+            os << r;
+            s.replace(0, os.str().length(), "");
+            float i = atof(s.c_str());
+            if (i == 0 && s.find("+") != string::npos) i = 1;
+            if (i == 0 && s.find("-") != string::npos) i = -1;
+            return complex<float>(r, i);
+        }
+        float i = atof(s.c_str());
+        if (i == 0 && s.length() == 1) i = 1;
+        if (i == 0 && s.length() == 2) i = -1;
+        return complex<float>(0, i);
+    }
+    return complex<float>(atof(s.c_str()), 0);
+}
+
+static complex<float> strtof_complex(const char *first, const char *last)
+{
+    if (last[-1] != 'i')
+        return complex<float>(strtof(first, nullptr), 0);
+    const char *imag_last = last - 1;
+    const char *split = first;
+    for (const char *p = imag_last - 1; p > first; p--)
+    {
+        if ((*p == '+' || *p == '-') && p[-1] != 'e' && p[-1] != 'E')
+        {
+            split = p;
+            break;
+        }
+    }
+    const float re = split == first ? 0 : strtof(first, nullptr);
+    float im;
+    if (split == imag_last)
+        im = 1;
+    else if (imag_last - split == 1)
+        im = *split == '-' ? -1 : 1;
+    else
+        im = strtof(split, nullptr);
+    return complex<float>(re, im);
+}
+
+/**
+ * runs fn over all the tokens until 0.2s are spent,
+ * @returns tokens per second
+ */
+template <typename Function>
+static double tokens_per_second(std::size_t count, Function fn)
+{
+    using clock = std::chrono::steady_clock;
+    std::size_t rounds = 0;
+    const clock::time_point start = clock::now();
+    double elapsed = 0;
+    do
+    {
+        fn();
+        rounds++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < 0.2);
+    return count * rounds / elapsed;
+}
+
+static volatile double sink;
+
+static void report(const char *kind, const char *path, double rate, double base)
+{
+    printf("%-8s %-16s %10.2f Mtok/s  %6.2fx\n", kind, path, rate / 1e6, rate / base);
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    const token_set reals = make_tokens(count, false);
+    const char *line = reals.line.data();
+
+    const double atof_rate = tokens_per_second(count, [&] {
+        double sum = 0;
+        for (const string &tok : reals.tokens)
+            sum += atof(tok.c_str());
+        sink = sum;
+    });
+    report("real", "atof", atof_rate, atof_rate);
+    report("real", "strtof", tokens_per_second(count, [&] {
+               double sum = 0;
+               for (const auto &r : reals.ranges)
+                   sum += strtof(line + r.first, nullptr);
+               sink = sum;
+           }), atof_rate);
+    report("real", "lexer float", tokens_per_second(count, [&] {
+               double sum = 0;
+               for (const auto &r : reals.ranges)
+               {
+                   float val = 0;
+                   lex_real(line + r.first, line + r.second, val);
+                   sum += val;
+               }
+               sink = sum;
+           }), atof_rate);
+    report("real", "lexer double", tokens_per_second(count, [&] {
+               double sum = 0;
+               for (const auto &r : reals.ranges)
+               {
+                   double val = 0;
+                   lex_real(line + r.first, line + r.second, val);
+                   sum += val;
+               }
+               sink = sum;
+           }), atof_rate);
+    report("real", "parse_input", tokens_per_second(count, [&] {
+               sink = parse_input<float>(reals.line)[0][0];
+           }), atof_rate);
+
+    const token_set complexes = make_tokens(count, true);
+    line = complexes.line.data();
+
+    const double old_rate = tokens_per_second(count, [&] {
+        double sum = 0;
+        for (const string &tok : complexes.tokens)
+            sum += atof_complex(tok).imag();
+        sink = sum;
+    });
+    report("complex", "atof", old_rate, old_rate);
+    report("complex", "strtof", tokens_per_second(count, [&] {
+               double sum = 0;
+               for (const auto &r : complexes.ranges)
+                   sum += strtof_complex(line + r.first, line + r.second).imag();
+               sink = sum;
+           }), old_rate);
+    report("complex", "lexer float", tokens_per_second(count, [&] {
+               double sum = 0;
+               for (const auto &r : complexes.ranges)
+               {
+                   complex<float> val;
+                   lex_complex(line + r.first, line + r.second, val);
+                   sum += val.imag();
+               }
+               sink = sum;
+           }), old_rate);
+    report("complex", "lexer double", tokens_per_second(count, [&] {
+               double sum = 0;
+               for (const auto &r : complexes.ranges)
+               {
+                   complex<double> val;
+                   lex_complex(line + r.first, line + r.second, val);
+                   sum += val.imag();
+               }
+               sink = sum;
+           }), old_rate);
+    report("complex", "parse_input", tokens_per_second(count, [&] {
+               sink = parse_input<complex<float>>(complexes.line)[0][0].imag();
+           }), old_rate);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file calculator.h
+ * @brief
+ *
+ * This file exports the complex matrix calculator run by main.cpp.
+ *
+ * The input starts with a "start" line and ends with an "end" line. In
+ * between, every block is a matrix line, an operator line, and the second
+ * operand of + - * / on the next line or the exponent of ^:
+ *
+ *     [1 2; 3 4]          [1 2; 3 4]          [1 2; 3 4]
+ *     *                   ^                   I
+ *     [5 6; 7 8]          3
+ *
+ * A block can also be a statement line (see expression_graph.h), an
+ * assignment or an expression to print:
+ *
+ *     A = [1 2; 3 4]
+ *     inv(A) * A' + A ^ 2
+ *
+ * The result of every block but an assignment is printed on one line. An
+ * invalid operator or an error stops the calculator.
+ *
+ * The batch mode reads the blocks in a thread, evaluates them in parallel
+ * and writes the results in input order, the output is the one of the
+ * serial mode. Statements are compiled by the reader, in input order, and
+ * a block waits only for the nodes it shares with the blocks before it.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+#ifndef _CALCULATOR_H_
+#define _CALCULATOR_H_
+
+#include <string>
+#include <istream>
+#include <ostream>
+
+#include "expression_graph.h"
+
+/**
+ * The lines of one block of the input
+ */
+struct calc_block
+{
+    std::string lhs;
+    std::string op;
+    std::string rhs;
+    int power = 0;
+    /**
+     * lhs is a statement line, compiled into statement
+     */
+    bool is_statement = false;
+    calc_statement statement;
+};
+
+/**
+ * Skips the input up to the "start" line
+ * @returns false if there is none
+ */
+bool skip_to_start(std::istream &in);
+
+/**
+ * Reads the next block, empty lines before it are skipped. A statement is
+ * compiled with the variables of graph.
+ * @returns false at the "end" line or at the end of the input
+ */
+bool read_block(std::istream &in, expression_graph &graph, calc_block &block);
+
+/**
+ * Evaluates a block and writes its result to out, as text followed by a
+ * line break, or as a binary matrix record, an assignment writes nothing.
+ * An invalid operator or an error writes its message instead, to out as
+ * text and to err with binary records, which out keeps readable.
+ * @returns true if the calculator must stop after this block
+ */
+bool evaluate_block(const calc_block &block, std::ostream &out, std::ostream &err, bool binary);
+
+/**
+ * Reads, evaluates and writes the blocks one after the other
+ */
+void run_serial(std::istream &in, std::ostream &out, std::ostream &err, bool binary);
+
+/**
+ * Pipelined version of run_serial: a reader thread, workers evaluating
+ * the blocks in parallel and the calling thread writing the results in
+ * input order. At most 16 blocks per worker, plus 16, are held at once.
+ * When a block stops the calculator before the end of the input, the
+ * call returns without waiting for the reader, which stays blocked until
+ * in gives its next line: in must outlive it, as std::cin does.
+ * @param workers number of worker threads, at least 1
+ */
+void run_batch(std::istream &in, std::ostream &out, std::ostream &err, bool binary, int workers);
+
+#endif // End of the file
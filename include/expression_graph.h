@@ -0,0 +1,131 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file expression_graph.h
+ * @brief
+ *
+ * This file exports the variables and expressions of the calculator.
+ *
+ * A statement is one line, an assignment or an expression to print:
+ *
+ *     A = [1 2; 3 4]
+ *     B = inv(A) * A' + A ^ 2
+ *     det(B) - B / A
+ *
+ * with + - * and / (a / b is a * inv(b)), unary -, ^ an integer power,
+ * ' the transpose, the functions inv, det (a 1x1 matrix) and trans, and
+ * parentheses. Operands are matrix literals and variables.
+ *
+ * Statements are compiled into a DAG. A variable is the node of its last
+ * assignment and identical subexpressions, the same operation on the same
+ * nodes or the same literal text, are one node, evaluated once. A node
+ * gives its operands up once evaluated, nodes live as long as a variable
+ * or a statement refers to them.
+ *
+ * Evaluation runs the pending nodes level by level, the independent nodes
+ * of a level in parallel. Nodes can be shared by statements evaluated on
+ * different threads, a node is computed by one of them and the others
+ * wait for its value.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+#ifndef _EXPRESSION_GRAPH_H_
+#define _EXPRESSION_GRAPH_H_
+
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <complex>
+#include <exception>
+#include <string_view>
+#include <unordered_map>
+
+#include "matrix.h"
+
+struct expr_node;
+
+/**
+ * A compiled statement
+ */
+struct calc_statement
+{
+    /**
+     * assigned variable, empty for an expression to print
+     */
+    std::string name;
+    std::shared_ptr<expr_node> root;
+    /**
+     * syntax error or unknown variable, thrown by evaluate_statement
+     */
+    std::exception_ptr error;
+};
+
+/**
+ * @returns false for a line holding a matrix literal alone, the first
+ *          line of an operator block, true for a statement
+ */
+bool is_statement(std::string_view line);
+
+/**
+ * Evaluates the nodes the statement depends on and the statement itself
+ * @returns the value of the statement
+ * @throw the error of the statement or of one of its nodes
+ */
+const matrix<std::complex<float>> &evaluate_statement(const calc_statement &statement);
+
+/**
+ * The variables of a calculator session and the table of its nodes.
+ * Compiling is done by one thread at a time, the statements it returns
+ * can be evaluated by any thread.
+ */
+class expression_graph
+{
+public:
+  expression_graph() = default;
+
+  expression_graph(const expression_graph &) = delete;
+
+  expression_graph &operator=(const expression_graph &) = delete;
+
+  /**
+     * Compiles a statement line, an assignment binds its variable now.
+     * A syntax error or an unknown variable is kept in the statement.
+     */
+  calc_statement compile(std::string_view line);
+
+private:
+  struct node_key
+  {
+    int op;
+    int power;
+    std::uint64_t lhs;
+    std::uint64_t rhs;
+    std::string text;
+
+    bool operator==(const node_key &key) const;
+  };
+
+  struct node_hash
+  {
+    std::size_t operator()(const node_key &key) const;
+  };
+
+  class parser;
+
+  std::shared_ptr<expr_node> make_node(node_key key, std::shared_ptr<expr_node> lhs,
+                                       std::shared_ptr<expr_node> rhs);
+
+  std::unordered_map<std::string, std::shared_ptr<expr_node>> variables;
+  std::unordered_map<node_key, std::weak_ptr<expr_node>, node_hash> nodes;
+  std::size_t swept_size = 0;
+  std::uint64_t next_id = 1;
+};
+
+#endif // End of the file
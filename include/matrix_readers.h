@@ -0,0 +1,106 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_readers.h
+ * @brief
+ *
+ * This file exports streaming readers of matrix files in the text formats
+ * other tools write, filling a matrix or a sparse_matrix directly:
+ *
+ *     CSV             one row per line, fields separated by a delimiter,
+ *                     real (1.5) or complex (1+2i) fields
+ *     Matrix Market   %%MatrixMarket matrix coordinate|array
+ *                     real|double|integer|complex|pattern
+ *                     general|symmetric|skew-symmetric|hermitian
+ *
+ * The file is read in chunks of read_options::chunk_size bytes cut on line
+ * boundaries, only one chunk is held in memory besides the result. A chunk
+ * is split in pieces of whole lines parsed in parallel, the pieces are
+ * merged in file order. Malformed input throws a read_error telling the
+ * line of the problem.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+#ifndef _MATRIX_READERS_H_
+#define _MATRIX_READERS_H_
+
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+
+#include "matrix.h"
+
+/**
+ * Thrown when a file can't be read or is malformed, line() is the
+ * 1-based line of the problem, 0 if it's not about a line
+ */
+class read_error : public std::runtime_error
+{
+public:
+  read_error(const std::string &path, std::size_t line, const std::string &msg);
+
+  std::size_t line() const { return line_number; }
+
+private:
+  std::size_t line_number;
+};
+
+struct read_options
+{
+  /**
+     * bytes read at once, a line longer than this grows the chunk
+     */
+  std::size_t chunk_size = 1 << 22;
+
+  /**
+     * field separator of CSV files
+     */
+  char delimiter = ',';
+
+  /**
+     * true if the first line of a CSV file names the columns
+     */
+  bool header = false;
+};
+
+/**
+ * Reads a CSV file into a matrix of ValueType: float, double,
+ * complex<float> or complex<double>. Empty lines are skipped.
+ * @throw read_error if the file can't be read, a field is not a number
+ *        or the rows have different lengths
+ */
+template <typename ValueType>
+matrix<ValueType> read_csv(const std::string &path, const read_options &options = read_options());
+
+/**
+ * Reads a CSV file into a sparse matrix, keeping the nonzero fields
+ * @throw read_error like read_csv
+ */
+template <typename ValueType>
+sparse_matrix<ValueType> read_csv_sparse(const std::string &path, const read_options &options = read_options());
+
+/**
+ * Reads a Matrix Market file into a matrix, in coordinate or array
+ * format. Symmetric files are expanded, duplicate entries summed.
+ * @throw read_error if the file can't be read or is malformed, or if it's
+ *        complex and ValueType is not
+ */
+template <typename ValueType>
+matrix<ValueType> read_matrix_market(const std::string &path, const read_options &options = read_options());
+
+/**
+ * Reads a Matrix Market file into a sparse matrix
+ * @throw read_error like read_matrix_market
+ */
+template <typename ValueType>
+sparse_matrix<ValueType> read_matrix_market_sparse(const std::string &path,
+                                                   const read_options &options = read_options());
+
+#endif // End of the file
@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file number_lexer.h
+ * @brief
+ *
+ * This file provides the number lexer of the parser, built on
+ * std::from_chars: locale free, no allocation, no terminating null needed.
+ *
+ * lex_real reads  a, +a, -a           (a in decimal or scientific form)
+ * lex_complex reads the real forms and bi, i, -i, a+bi, a-bi, a+i, a-i
+ *
+ * Both read the characters once, left to right, and return one past the
+ * last character read, or nullptr if no number starts at first. The caller
+ * checks the returned pointer is the end of the token.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+#ifndef _NUMBER_LEXER_H_
+#define _NUMBER_LEXER_H_
+
+#include <charconv>
+#include <complex>
+#include <system_error>
+
+/**
+ * Reads an unsigned or '-' signed number, the form from_chars accepts
+ * @returns one past the number, nullptr if there is none
+ */
+template <typename ValueType>
+inline const char *lex_unsigned(const char *first, const char *last, ValueType &value)
+{
+    const std::from_chars_result res = std::from_chars(first, last, value, std::chars_format::general);
+    return res.ec == std::errc() ? res.ptr : nullptr;
+}
+
+/**
+ * Reads a real number with an optional sign
+ * @returns one past the number, nullptr if there is none
+ */
+template <typename ValueType>
+inline const char *lex_real(const char *first, const char *last, ValueType &value)
+{
+    // from_chars takes no '+', and "+-1" is not a number
+    if (first < last && *first == '+')
+    {
+        if (++first < last && *first == '-')
+            return nullptr;
+    }
+    return lex_unsigned(first, last, value);
+}
+
+/**
+ * Reads a real, imaginary or complex number
+ * @returns one past the number, nullptr if there is none
+ */
+template <typename ValueType>
+const char *lex_complex(const char *first, const char *last, std::complex<ValueType> &value)
+{
+    ValueType re;
+    const char *p = lex_real(first, last, re);
+    if (!p)
+    {
+        // i, +i, -i
+        ValueType sign = 1;
+        if (first < last && (*first == '+' || *first == '-'))
+            sign = *first++ == '-' ? -1 : 1;
+        if (first == last || *first != 'i')
+            return nullptr;
+        value = std::complex<ValueType>(0, sign);
+        return first + 1;
+    }
+    if (p == last || (*p != 'i' && *p != '+' && *p != '-'))
+    {
+        value = std::complex<ValueType>(re, 0);
+        return p;
+    }
+    if (*p == 'i')
+    {
+        value = std::complex<ValueType>(0, re);
+        return p + 1;
+    }
+
+    // a+bi, a-bi, a+i, a-i
+    const bool negative = *p++ == '-';
+    ValueType im = 1;
+    if (p < last && *p != 'i')
+    {
+        if (*p == '-')
+            return nullptr;
+        p = lex_unsigned(p, last, im);
+        if (!p)
+            return nullptr;
+    }
+    if (p == last || *p != 'i')
+        return nullptr;
+    value = std::complex<ValueType>(re, negative ? -im : im);
+    return p + 1;
+}
+
+/**
+ * Reads a number of the type of value, lex_real or lex_complex
+ * @returns one past the number, nullptr if there is none
+ */
+template <typename ValueType>
+inline const char *lex_number(const char *first, const char *last, ValueType &value)
+{
+    return lex_real(first, last, value);
+}
+
+template <typename ValueType>
+inline const char *lex_number(const char *first, const char *last, std::complex<ValueType> &value)
+{
+    return lex_complex(first, last, value);
+}
+
+#endif // End of the file
@@ -7,70 +7,80 @@
  *****************************************************************************/
 /**
  * @file parsing.h
- * @brief 
- * 
+ * @brief
+ *
  * This file exports helper funtions to parse matrices in C++
  *
+ * The input syntax is the one of the calculator:
+ *
+ *     [1 2.5; -3 4e2]            real matrix
+ *     [1+2i 3-i; 4i -i]          complex matrix
+ *
+ * rows are separated by ';', elements by one or more spaces. A complex
+ * element is a real number, an imaginary one (an optional number followed
+ * by i) or a real number followed by a signed imaginary one.
+ *
+ * The input is read in one pass, the elements are converted in place by
+ * the locale free lexer of number_lexer.h, no string is built on the way. Malformed input
+ * throws a parse_error telling where the problem is.
+ *
  * @author Hassan El-shazly
- * @date Last Edit Jul-2020
+ * @date Last Edit Oct-2026
  *
  */
 #ifndef _PARSING_H_
 #define _PARSING_H_
 
 #include <vector>
-#include <utility>
-#include <cstdlib>
+#include <cstddef>
 #include <complex>
 #include <string>
-#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+
+#include "matrix.h"
 
 using std::vector;
 using std::string;
 using std::complex;
 using std::ostream;
-using std::ostringstream;
-
 
 /**
- * remove leading and laging spaces a given string
+ * Thrown on malformed input, column() is the 1-based position
+ * of the offending character in the parsed text
  */
-string strip(const string& input);
+class parse_error : public std::runtime_error
+{
+public:
+  parse_error(std::size_t column, const string &msg);
 
-/**
- * remove leading and laging spaces from vector of strings
- */
-vector<string> strip(const vector<string>& input);
+  std::size_t column() const { return col; }
 
-/**
- * split string based on a given char
- */
-vector<string> split(const string& s, char b);
-
-/**
- * reomove repeated spaces in a given string
- */
-string clear_spaces(const string& s);
-
-/**
- * transform vector of strings to vector of floats
- */
-vector<float> to_float(const vector<string>& input);
+private:
+  std::size_t col;
+};
 
 /**
- * transform vector of strings to vector of complex numbers
+ * transform string input into a matrix of ValueType: float, double,
+ * complex<float> or complex<double>, the numbers are read with the
+ * precision of ValueType
+ * @throw parse_error if the input is malformed
  */
-vector<complex<float>> to_complex(const vector<string>& input);
+template <typename ValueType>
+matrix<ValueType> parse_input(std::string_view input);
 
 /**
  * transform string input into float matrix
+ * @throw parse_error if the input is malformed
  */
-vector<vector<float>> parse_float_input(string& input);
+matrix<float> parse_float_input(std::string_view input);
 
 /**
  * transform string input into complex matrix
+ * @throw parse_error if the input is malformed
  */
-vector<vector<complex<float>>> parse_complex_input(string& input);
+matrix<complex<float>> parse_complex_input(std::string_view input);
 
 
 /**
@@ -78,4 +88,4 @@ vector<vector<complex<float>>> parse_complex_input(string& input);
  */
 ostream& operator<<(ostream& os, complex<float> c);
 
-#endif // End of the file
\ No newline at end of file
+#endif // End of the file
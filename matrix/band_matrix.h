@@ -0,0 +1,350 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file band_matrix.h
+ * @brief
+ *
+ * This file provides the <code>band_matrix</code> class, a square matrix
+ * whose nonzeros are within kl diagonals below and ku diagonals above the
+ * main one (kl = ku = 1 is a tridiagonal matrix). Every row stores the
+ * kl + ku + 1 elements of the band, row i holds columns [i - kl, i + ku].
+ *
+ * det and solve use the LU with partial pivoting on a copy of the band.
+ * Row swaps widen the upper part of U to kl + ku diagonals and nothing
+ * else, so they cost O(n x kl x (kl + ku)): O(n) for a tridiagonal matrix.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _BAND_MATRIX_H_
+#define _BAND_MATRIX_H_
+
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "matrix_def.h"
+#include "matrix_arena.h"
+#include "thread_pool.h"
+#include "simd_kernels.h"
+#include "structured_matrix.h"
+
+template <typename ValueType>
+class band_matrix : public structured_matrix<band_matrix<ValueType>, ValueType>
+{
+public:
+  /**
+     * Constructs an (n x n) matrix of zeros with kl diagonals
+     * below and ku diagonals above the main one
+     * @throw length_error if kl or ku is negative
+     * @bigoh O(n x (kl + ku))
+     */
+  explicit band_matrix(int n = 0, int kl = 0, int ku = 0);
+
+  /**
+     * Keeps the band of a square dense matrix
+     * @throw length_error if it's not a square matrix
+     * @bigoh O(n x (kl + ku))
+     */
+  template <typename Allocator>
+  band_matrix(const matrix<ValueType, Allocator> &mat, int kl, int ku);
+
+  bool operator==(const band_matrix &mat) const
+  {
+    return size == mat.size && kl == mat.kl && ku == mat.ku && elements == mat.elements;
+  }
+
+  bool operator!=(const band_matrix &mat) const { return !(*this == mat); }
+
+  /**
+     * @returns element (i, j), zero outside the band, no bounds checking
+     */
+  ValueType operator()(int i, int j) const
+  {
+    return (j - i <= ku && i - j <= kl) ? elements[index(i, j)] : ValueType();
+  }
+
+  /**
+     * @returns a reference to element (i, j)
+     * @throw out_of_range if (i, j) is outside the band
+     */
+  ValueType &at(int i, int j);
+
+  /**
+     * Multiply with a vector or a dense matrix
+     * @throw   length_error if the dimensions don't match
+     * @bigoh O(n x (kl + ku)), times mat.columns for a dense matrix
+     */
+  vector<ValueType> multiply(const vector<ValueType> &vec) const;
+
+  template <typename Allocator>
+  matrix<ValueType> multiply(const matrix<ValueType, Allocator> &mat) const;
+
+  /**
+     * @returns the determinant
+     * @bigoh O(n x kl x (kl + ku))
+     */
+  ValueType det() const;
+
+  /**
+     * @throw   out_of_range if determinant = zero
+     * @returns the inverse, a dense matrix
+     * @bigoh O(n^2 x (kl + ku))
+     */
+  matrix<ValueType> invert() const;
+
+  /**
+     * Solves A x = vec
+     * @throw   length_error if vec.size() != n
+     * @throw   out_of_range if determinant = zero
+     * @bigoh O(n x kl x (kl + ku))
+     */
+  vector<ValueType> solve(const vector<ValueType> &vec) const;
+
+  /**
+     * Solves A X = mat for every column of mat
+     * @throw   length_error if mat.rows != n
+     * @throw   out_of_range if determinant = zero
+     * @bigoh O(n x kl x (kl + ku) x mat.columns)
+     */
+  template <typename Allocator>
+  matrix<ValueType> solve(const matrix<ValueType, Allocator> &mat) const;
+
+  int get_rows() const { return size; }
+
+  int get_cols() const { return size; }
+
+  int lower_bandwidth() const { return kl; }
+
+  int upper_bandwidth() const { return ku; }
+
+private:
+  /**
+     * The band LU: L multipliers on the kl diagonals below the main one,
+     * U on the main one and kl + ku above it, row r was swapped with
+     * row pivots[r] at step r
+     */
+  struct factorization
+  {
+    int kl;
+    int width;
+    vector<ValueType, arena_allocator<ValueType>> elements;
+    vector<int, arena_allocator<int>> pivots;
+    bool singular;
+    int sign;
+
+    ValueType &at(int i, int j) { return elements[static_cast<std::size_t>(i) * width + (j - i + kl)]; }
+  };
+
+  std::size_t index(int i, int j) const
+  {
+    return static_cast<std::size_t>(i) * (kl + ku + 1) + (j - i + kl);
+  }
+
+  factorization factorize() const;
+
+  /**
+     * Applies the factorization to columns [0, cols) of x, in place
+     */
+  static void substitute(factorization &f, int n, ValueType *x, std::size_t ldx, int cols);
+
+  int size;
+  int kl;
+  int ku;
+  vector<ValueType> elements;
+};
+
+template <typename ValueType>
+band_matrix<ValueType>::band_matrix(int n, int kl, int ku)
+    : size(n), kl(kl), ku(ku)
+{
+    if (kl < 0 || ku < 0)
+        throw std::length_error("band_matrix -> bandwidths must not be negative");
+    elements.resize(static_cast<std::size_t>(n) * (kl + ku + 1));
+}
+
+template <typename ValueType>
+template <typename Allocator>
+band_matrix<ValueType>::band_matrix(const matrix<ValueType, Allocator> &mat, int kl, int ku)
+    : band_matrix(mat.get_rows(), kl, ku)
+{
+    if (mat.get_rows() != mat.get_cols())
+        throw std::length_error("band_matrix -> matrix must be square");
+    for (int i = 0; i < size; i++)
+        for (int j = std::max(0, i - kl); j <= std::min(size - 1, i + ku); j++)
+            elements[index(i, j)] = mat[i][j];
+}
+
+template <typename ValueType>
+ValueType &band_matrix<ValueType>::at(int i, int j)
+{
+    if (i < 0 || i >= size || j < 0 || j >= size || j - i > ku || i - j > kl)
+        throw std::out_of_range("band_matrix::at -> index out of range");
+    return elements[index(i, j)];
+}
+
+template <typename ValueType>
+vector<ValueType> band_matrix<ValueType>::multiply(const vector<ValueType> &vec) const
+{
+    if (vec.size() != static_cast<std::size_t>(size))
+        throw std::length_error("band_matrix::multiply -> vector.size() must be equal to matrix::cols");
+    vector<ValueType> res(size);
+    matrix_parallel::parallel_for(0, size, elements.size(), [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            const int j0 = std::max(0, i - kl);
+            const int j1 = std::min(size - 1, i + ku);
+            res[i] = matrix_kernels::vec_dot(j1 - j0 + 1, elements.data() + index(i, j0), vec.data() + j0);
+        }
+    });
+    return res;
+}
+
+template <typename ValueType>
+template <typename Allocator>
+matrix<ValueType> band_matrix<ValueType>::multiply(const matrix<ValueType, Allocator> &mat) const
+{
+    if (mat.get_rows() != size)
+        throw std::length_error("band_matrix::multiply -> check matrices dimentions");
+    const int cols = mat.get_cols();
+    matrix<ValueType> res(size, cols);
+    matrix_parallel::parallel_for(0, size, elements.size() * cols, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+            for (int j = std::max(0, i - kl); j <= std::min(size - 1, i + ku); j++)
+                matrix_kernels::vec_axpy(cols, elements[index(i, j)], mat[j].data(), res[i].data());
+    });
+    return res;
+}
+
+template <typename ValueType>
+typename band_matrix<ValueType>::factorization band_matrix<ValueType>::factorize() const
+{
+    using std::abs;
+
+    // U gets kl + ku diagonals above the main one, the extra kl start at zero
+    const int ku_f = kl + ku;
+    factorization f{kl, kl + ku_f + 1, {}, {}, false, 1};
+    f.elements.assign(static_cast<std::size_t>(size) * f.width, ValueType());
+    f.pivots.resize(size);
+    for (int i = 0; i < size; i++)
+        std::copy_n(elements.data() + static_cast<std::size_t>(i) * (kl + ku + 1), kl + ku + 1,
+                    f.elements.data() + static_cast<std::size_t>(i) * f.width);
+
+    for (int k = 0; k < size; k++)
+    {
+        const int last_row = std::min(size - 1, k + kl);
+        const int last_col = std::min(size - 1, k + ku_f);
+        int pivot = k;
+        for (int i = k + 1; i <= last_row; i++)
+            if (abs(f.at(i, k)) > abs(f.at(pivot, k)))
+                pivot = i;
+        f.pivots[k] = pivot;
+        if (pivot != k)
+        {
+            // both rows store columns [k, last_col]
+            std::swap_ranges(&f.at(k, k), &f.at(k, last_col) + 1, &f.at(pivot, k));
+            f.sign = -f.sign;
+        }
+        const ValueType diag = f.at(k, k);
+        if (diag == static_cast<ValueType>(0))
+        {
+            f.singular = true;
+            continue;
+        }
+        for (int i = k + 1; i <= last_row; i++)
+        {
+            ValueType &l = f.at(i, k);
+            l /= diag;
+            matrix_kernels::vec_axpy(last_col - k, -l, &f.at(k, k + 1), &f.at(i, k + 1));
+        }
+    }
+    return f;
+}
+
+template <typename ValueType>
+void band_matrix<ValueType>::substitute(factorization &f, int n, ValueType *x, std::size_t ldx, int cols)
+{
+    const int kl = f.kl;
+    const int ku_f = f.width - kl - 1;
+    // L y = P b, the swaps and the eliminations in the order they were made
+    for (int k = 0; k < n; k++)
+    {
+        ValueType *xk = x + static_cast<std::size_t>(k) * ldx;
+        if (f.pivots[k] != k)
+            std::swap_ranges(xk, xk + cols, x + static_cast<std::size_t>(f.pivots[k]) * ldx);
+        for (int i = k + 1; i <= std::min(n - 1, k + kl); i++)
+            matrix_kernels::vec_axpy(cols, -f.at(i, k), xk, x + static_cast<std::size_t>(i) * ldx);
+    }
+    // U x = y
+    for (int i = n - 1; i >= 0; i--)
+    {
+        ValueType *xi = x + static_cast<std::size_t>(i) * ldx;
+        for (int j = i + 1; j <= std::min(n - 1, i + ku_f); j++)
+            matrix_kernels::vec_axpy(cols, -f.at(i, j), x + static_cast<std::size_t>(j) * ldx, xi);
+        matrix_kernels::vec_div_scalar(cols, xi, f.at(i, i));
+    }
+}
+
+template <typename ValueType>
+ValueType band_matrix<ValueType>::det() const
+{
+    factorization f = factorize();
+    if (f.singular)
+        return static_cast<ValueType>(0);
+    ValueType det_val = static_cast<ValueType>(1);
+    for (int i = 0; i < size; i++)
+        det_val *= f.at(i, i);
+    return f.sign < 0 ? -det_val : det_val;
+}
+
+template <typename ValueType>
+vector<ValueType> band_matrix<ValueType>::solve(const vector<ValueType> &vec) const
+{
+    if (vec.size() != static_cast<std::size_t>(size))
+        throw std::length_error("band_matrix::solve -> vector.size() must be equal to matrix::rows");
+    factorization f = factorize();
+    if (f.singular)
+        throw std::out_of_range("band_matrix::solve -> Determinant equal zero");
+    vector<ValueType> x(vec);
+    substitute(f, size, x.data(), 1, 1);
+    return x;
+}
+
+template <typename ValueType>
+template <typename Allocator>
+matrix<ValueType> band_matrix<ValueType>::solve(const matrix<ValueType, Allocator> &mat) const
+{
+    if (mat.get_rows() != size)
+        throw std::length_error("band_matrix::solve -> check matrix dimentions");
+    factorization f = factorize();
+    if (f.singular)
+        throw std::out_of_range("band_matrix::solve -> Determinant equal zero");
+    matrix<ValueType> x(mat);
+    substitute(f, size, x.data(), x.get_stride(), x.get_cols());
+    return x;
+}
+
+template <typename ValueType>
+matrix<ValueType> band_matrix<ValueType>::invert() const
+{
+    factorization f = factorize();
+    if (f.singular)
+        throw std::out_of_range("band_matrix::invert -> Determinant equal zero");
+    matrix<ValueType> x(size, size);
+    for (int i = 0; i < size; i++)
+        x[i][i] = static_cast<ValueType>(1);
+    substitute(f, size, x.data(), x.get_stride(), size);
+    return x;
+}
+
+#endif // End of the file
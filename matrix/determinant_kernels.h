@@ -0,0 +1,195 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file determinant_kernels.h
+ * @brief
+ *
+ * This file provides the division free determinant kernels behind
+ * <code>determinant_recursive</code>. They only use + - and * of the
+ * element type, like the cofactor expansion they replace, so they stay
+ * exact for integer-like types:
+ *
+ *  - closed forms for 1x1 to 4x4 matrices, no allocation
+ *  - a subset dynamic programming over column masks, O(2^n x n), that
+ *    sums exactly the products of the cofactor expansion
+ *  - the Berkowitz algorithm, O(n^4), for larger matrices
+ *
+ * Berkowitz builds powers of the matrix and is not numerically stable,
+ * so callers use the pivoted LU for large floating point matrices
+ * (see <code>det_is_inexact</code>).
+ *
+ * All of them read a row-major n x n block with leading dimension lda.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _DETERMINANT_KERNELS_H_
+#define _DETERMINANT_KERNELS_H_
+
+#include <vector>
+#include <cstddef>
+#include <complex>
+#include <utility>
+#include <type_traits>
+
+#include "matrix_arena.h"
+
+namespace matrix_kernels
+{
+    /**
+     * Largest size handled by the subset dynamic programming,
+     * the table holds 2^n elements
+     */
+    constexpr int det_subset_max = 16;
+
+    /**
+     * True for floating point (and complex floating point) types, for which
+     * dividing by a pivot is harmless and more accurate than Berkowitz
+     */
+    template <typename T>
+    struct det_is_inexact : std::is_floating_point<T>
+    {
+    };
+
+    template <typename T>
+    struct det_is_inexact<std::complex<T>> : std::is_floating_point<T>
+    {
+    };
+
+    template <typename T>
+    T det_small(int n, const T *a, std::size_t lda)
+    {
+        const T *r0 = a, *r1 = a + lda, *r2 = a + 2 * lda, *r3 = a + 3 * lda;
+        switch (n)
+        {
+        case 1:
+            return r0[0];
+        case 2:
+            return r0[0] * r1[1] - r0[1] * r1[0];
+        case 3:
+            return r0[0] * (r1[1] * r2[2] - r1[2] * r2[1]) -
+                   r0[1] * (r1[0] * r2[2] - r1[2] * r2[0]) +
+                   r0[2] * (r1[0] * r2[1] - r1[1] * r2[0]);
+        default:
+        {
+            // expansion by the 2x2 minors of the top and bottom row pairs
+            const T s0 = r0[0] * r1[1] - r0[1] * r1[0];
+            const T s1 = r0[0] * r1[2] - r0[2] * r1[0];
+            const T s2 = r0[0] * r1[3] - r0[3] * r1[0];
+            const T s3 = r0[1] * r1[2] - r0[2] * r1[1];
+            const T s4 = r0[1] * r1[3] - r0[3] * r1[1];
+            const T s5 = r0[2] * r1[3] - r0[3] * r1[2];
+            const T c0 = r2[0] * r3[1] - r2[1] * r3[0];
+            const T c1 = r2[0] * r3[2] - r2[2] * r3[0];
+            const T c2 = r2[0] * r3[3] - r2[3] * r3[0];
+            const T c3 = r2[1] * r3[2] - r2[2] * r3[1];
+            const T c4 = r2[1] * r3[3] - r2[3] * r3[1];
+            const T c5 = r2[2] * r3[3] - r2[3] * r3[2];
+            return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        }
+        }
+    }
+
+    /**
+     * dp[mask] is the determinant of the first popcount(mask) rows restricted
+     * to the columns in mask, expanded along its last row
+     */
+    template <typename T>
+    T det_subset(int n, const T *a, std::size_t lda)
+    {
+        const unsigned full = (1u << n) - 1;
+        std::vector<T, arena_allocator<T>> dp(static_cast<std::size_t>(full) + 1);
+        dp[0] = static_cast<T>(1);
+        for (unsigned mask = 1; mask <= full; mask++)
+        {
+            const int k = __builtin_popcount(mask);
+            const T *row = a + static_cast<std::size_t>(k - 1) * lda;
+            T det = T();
+            int pos = 0;
+            for (int j = 0; j < n; j++)
+            {
+                if (!(mask & (1u << j)))
+                    continue;
+                const T term = row[j] * dp[mask ^ (1u << j)];
+                if ((k - 1 + pos) & 1)
+                    det -= term;
+                else
+                    det += term;
+                pos++;
+            }
+            dp[mask] = det;
+        }
+        return dp[full];
+    }
+
+    /**
+     * Berkowitz algorithm: the characteristic polynomial of every leading
+     * submatrix is obtained from the previous one by a Toeplitz product,
+     * the determinant is its constant term
+     */
+    template <typename T>
+    T det_berkowitz(int n, const T *a, std::size_t lda)
+    {
+        std::vector<T, arena_allocator<T>> poly{static_cast<T>(1), -a[0]};
+        std::vector<T, arena_allocator<T>> next, toeplitz, v(n), av(n);
+        for (int r = 1; r < n; r++)
+        {
+            const T *row_r = a + static_cast<std::size_t>(r) * lda;
+            toeplitz.assign(r + 2, T());
+            toeplitz[0] = static_cast<T>(1);
+            toeplitz[1] = -row_r[r];
+            // toeplitz[k + 2] = -R x A^k x C
+            for (int i = 0; i < r; i++)
+                v[i] = a[static_cast<std::size_t>(i) * lda + r];
+            for (int k = 0; k < r; k++)
+            {
+                T dot = T();
+                for (int i = 0; i < r; i++)
+                    dot += row_r[i] * v[i];
+                toeplitz[k + 2] = -dot;
+                if (k + 1 == r)
+                    break;
+                for (int i = 0; i < r; i++)
+                {
+                    const T *row_i = a + static_cast<std::size_t>(i) * lda;
+                    T sum = T();
+                    for (int j = 0; j < r; j++)
+                        sum += row_i[j] * v[j];
+                    av[i] = sum;
+                }
+                std::swap(v, av);
+            }
+            next.assign(r + 2, T());
+            for (int i = 0; i < r + 2; i++)
+                for (int j = 0; j <= i && j < r + 1; j++)
+                    next[i] += toeplitz[i - j] * poly[j];
+            std::swap(poly, next);
+        }
+        return (n & 1) ? -poly[n] : poly[n];
+    }
+
+    /**
+     * @returns the determinant of the n x n block at a, without divisions
+     */
+    template <typename T>
+    T det_division_free(int n, const T *a, std::size_t lda)
+    {
+        // the empty product, as the LU gives for a 0x0 matrix
+        if (n <= 0)
+            return static_cast<T>(1);
+        if (n <= 4)
+            return det_small(n, a, lda);
+        if (n <= det_subset_max)
+            return det_subset(n, a, lda);
+        return det_berkowitz(n, a, lda);
+    }
+}
+
+#endif // End of the file
@@ -0,0 +1,248 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file diagonal_matrix.h
+ * @brief
+ *
+ * This file provides the <code>diagonal_matrix</code> class, a square
+ * matrix that stores its diagonal only. Products, det, invert and
+ * solve are O(n) (O(n x columns) against a dense matrix).
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _DIAGONAL_MATRIX_H_
+#define _DIAGONAL_MATRIX_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+
+#include "matrix_def.h"
+#include "simd_kernels.h"
+#include "structured_matrix.h"
+
+template <typename ValueType>
+class diagonal_matrix : public structured_matrix<diagonal_matrix<ValueType>, ValueType>
+{
+public:
+  /**
+     * Constructs an (n x n) matrix of zeros
+     * @bigoh O(n)
+     */
+  explicit diagonal_matrix(int n = 0);
+
+  /**
+     * Constructs the matrix with the given diagonal
+     * @bigoh O(n)
+     */
+  explicit diagonal_matrix(vector<ValueType> diag);
+
+  /**
+     * Keeps the diagonal of a square dense matrix
+     * @throw length_error if it's not a square matrix
+     * @bigoh O(n)
+     */
+  template <typename Allocator>
+  explicit diagonal_matrix(const matrix<ValueType, Allocator> &mat);
+
+  /**
+     * @returns the (n x n) identity matrix
+     */
+  static diagonal_matrix identity(int n);
+
+  bool operator==(const diagonal_matrix &mat) const { return diag == mat.diag; }
+
+  bool operator!=(const diagonal_matrix &mat) const { return diag != mat.diag; }
+
+  /**
+     * @returns element (i, j), no bounds checking
+     */
+  ValueType operator()(int i, int j) const
+  {
+    return i == j ? diag[i] : ValueType();
+  }
+
+  /**
+     * @returns a reference to element (i, i)
+     * @throw out_of_range if i is outside the matrix
+     */
+  ValueType &at(int i);
+
+  /**
+     * Multiply with a vector, a dense matrix or another diagonal matrix
+     * @throw   length_error if the dimensions don't match
+     * @bigoh O(n), O(n x mat.columns) for a dense matrix
+     */
+  vector<ValueType> multiply(const vector<ValueType> &vec) const;
+
+  template <typename Allocator>
+  matrix<ValueType> multiply(const matrix<ValueType, Allocator> &mat) const;
+
+  diagonal_matrix multiply(const diagonal_matrix &mat) const;
+
+  /**
+     * @returns the determinant, the product of the diagonal
+     * @bigoh O(n)
+     */
+  ValueType det() const;
+
+  /**
+     * @throw   out_of_range if determinant = zero
+     * @returns the inverse, a diagonal matrix
+     * @bigoh O(n)
+     */
+  diagonal_matrix invert() const;
+
+  /**
+     * Solves A x = vec
+     * @throw   length_error if vec.size() != n
+     * @throw   out_of_range if determinant = zero
+     * @bigoh O(n)
+     */
+  vector<ValueType> solve(const vector<ValueType> &vec) const;
+
+  /**
+     * Solves A X = mat for every column of mat
+     * @throw   length_error if mat.rows != n
+     * @throw   out_of_range if determinant = zero
+     * @bigoh O(n x mat.columns)
+     */
+  template <typename Allocator>
+  matrix<ValueType> solve(const matrix<ValueType, Allocator> &mat) const;
+
+  int get_rows() const { return static_cast<int>(diag.size()); }
+
+  int get_cols() const { return static_cast<int>(diag.size()); }
+
+  const vector<ValueType> &diagonal() const { return diag; }
+
+private:
+  void check_singular(const char *name) const;
+
+  vector<ValueType> diag;
+};
+
+template <typename ValueType>
+diagonal_matrix<ValueType>::diagonal_matrix(int n) : diag(n)
+{
+}
+
+template <typename ValueType>
+diagonal_matrix<ValueType>::diagonal_matrix(vector<ValueType> diag) : diag(std::move(diag))
+{
+}
+
+template <typename ValueType>
+template <typename Allocator>
+diagonal_matrix<ValueType>::diagonal_matrix(const matrix<ValueType, Allocator> &mat)
+    : diag(mat.get_rows())
+{
+    if (mat.get_rows() != mat.get_cols())
+        throw std::length_error("diagonal_matrix -> matrix must be square");
+    for (int i = 0; i < get_rows(); i++)
+        diag[i] = mat[i][i];
+}
+
+template <typename ValueType>
+diagonal_matrix<ValueType> diagonal_matrix<ValueType>::identity(int n)
+{
+    return diagonal_matrix(vector<ValueType>(n, static_cast<ValueType>(1)));
+}
+
+template <typename ValueType>
+ValueType &diagonal_matrix<ValueType>::at(int i)
+{
+    if (i < 0 || i >= get_rows())
+        throw std::out_of_range("diagonal_matrix::at -> index out of range");
+    return diag[i];
+}
+
+template <typename ValueType>
+vector<ValueType> diagonal_matrix<ValueType>::multiply(const vector<ValueType> &vec) const
+{
+    if (vec.size() != diag.size())
+        throw std::length_error("diagonal_matrix::multiply -> vector.size() must be equal to matrix::cols");
+    vector<ValueType> res(vec);
+    matrix_kernels::vec_mul(res.size(), res.data(), diag.data());
+    return res;
+}
+
+template <typename ValueType>
+template <typename Allocator>
+matrix<ValueType> diagonal_matrix<ValueType>::multiply(const matrix<ValueType, Allocator> &mat) const
+{
+    if (mat.get_rows() != get_rows())
+        throw std::length_error("diagonal_matrix::multiply -> check matrices dimentions");
+    matrix<ValueType> res(mat);
+    for (int i = 0; i < get_rows(); i++)
+        matrix_kernels::vec_mul_scalar(res.get_cols(), res[i].data(), diag[i]);
+    return res;
+}
+
+template <typename ValueType>
+diagonal_matrix<ValueType> diagonal_matrix<ValueType>::multiply(const diagonal_matrix &mat) const
+{
+    return diagonal_matrix(mat.multiply(diag));
+}
+
+template <typename ValueType>
+ValueType diagonal_matrix<ValueType>::det() const
+{
+    ValueType det_val = static_cast<ValueType>(1);
+    for (const auto &d : diag)
+        det_val *= d;
+    return det_val;
+}
+
+template <typename ValueType>
+void diagonal_matrix<ValueType>::check_singular(const char *name) const
+{
+    for (const auto &d : diag)
+        if (d == static_cast<ValueType>(0))
+            throw std::out_of_range(std::string(name) + " -> Determinant equal zero");
+}
+
+template <typename ValueType>
+diagonal_matrix<ValueType> diagonal_matrix<ValueType>::invert() const
+{
+    check_singular("diagonal_matrix::invert");
+    vector<ValueType> inv(diag.size());
+    for (std::size_t i = 0; i < diag.size(); i++)
+        inv[i] = static_cast<ValueType>(1) / diag[i];
+    return diagonal_matrix(std::move(inv));
+}
+
+template <typename ValueType>
+vector<ValueType> diagonal_matrix<ValueType>::solve(const vector<ValueType> &vec) const
+{
+    if (vec.size() != diag.size())
+        throw std::length_error("diagonal_matrix::solve -> vector.size() must be equal to matrix::rows");
+    check_singular("diagonal_matrix::solve");
+    vector<ValueType> res(vec);
+    matrix_kernels::vec_div(res.size(), res.data(), diag.data());
+    return res;
+}
+
+template <typename ValueType>
+template <typename Allocator>
+matrix<ValueType> diagonal_matrix<ValueType>::solve(const matrix<ValueType, Allocator> &mat) const
+{
+    if (mat.get_rows() != get_rows())
+        throw std::length_error("diagonal_matrix::solve -> check matrix dimentions");
+    check_singular("diagonal_matrix::solve");
+    matrix<ValueType> res(mat);
+    for (int i = 0; i < get_rows(); i++)
+        matrix_kernels::vec_div_scalar(res.get_cols(), res[i].data(), diag[i]);
+    return res;
+}
+
+#endif // End of the file
@@ -0,0 +1,519 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file fixed_matrix.h
+ * @brief
+ *
+ * This file provides the <code>fixed_matrix</code> class, a matrix whose
+ * dimensions are template parameters. The elements live in an
+ * <code>std::array</code> inside the object (no heap allocation), the
+ * dimensions of every operation are checked at compile time, and the
+ * loops of multiply, transpose, det and invert are unrolled. It is meant
+ * for small (2x2 to 8x8) transforms and converts explicitly from and to
+ * the dynamic <code>matrix</code>.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _FIXED_MATRIX_H_
+#define _FIXED_MATRIX_H_
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <utility>
+#include <ostream>
+#include <stdexcept>
+#include <initializer_list>
+
+#include "matrix_def.h"
+#include "matrix_storage.h"
+#include "determinant_kernels.h"
+
+namespace matrix_kernels
+{
+    template <typename Function, int... I>
+    inline void unroll_impl(Function &&fn, std::integer_sequence<int, I...>)
+    {
+        (fn(I), ...);
+    }
+
+    /**
+     * Calls fn(0), fn(1), ..., fn(N - 1), unrolled at compile time
+     */
+    template <int N, typename Function>
+    inline void unroll(Function &&fn)
+    {
+        unroll_impl(fn, std::make_integer_sequence<int, N>());
+    }
+}
+
+template <typename ValueType, int Rows, int Cols>
+class fixed_matrix
+{
+  static_assert(Rows > 0 && Cols > 0, "fixed_matrix dimensions must be positive");
+
+public:
+  /**
+     * Constructs a matrix of zeros
+     * @bigoh O(1)
+     */
+  fixed_matrix();
+
+  /**
+     * Constructs the matrix from its rows, {{1, 2}, {3, 4}}
+     * @throw length_error if the number of rows or columns is not right
+     * @bigoh O(1)
+     */
+  fixed_matrix(std::initializer_list<std::initializer_list<ValueType>> list);
+
+  /**
+     * Copies a dynamic matrix
+     * @throw length_error if its dimensions are not Rows x Cols
+     * @bigoh O(1)
+     */
+  explicit fixed_matrix(const matrix<ValueType> &mat);
+
+  /**
+     * Converts to a dynamic matrix
+     * @bigoh O(1)
+     */
+  explicit operator matrix<ValueType>() const;
+
+  /**
+     * @returns the identity matrix
+     */
+  static fixed_matrix identity();
+
+  bool operator==(const fixed_matrix &mat) const;
+
+  bool operator!=(const fixed_matrix &mat) const;
+
+  /**
+     * Element-wise operations with a matrix of the same dimensions
+     */
+  fixed_matrix &operator+=(const fixed_matrix &mat);
+
+  fixed_matrix &operator-=(const fixed_matrix &mat);
+
+  fixed_matrix &operator*=(const fixed_matrix &mat);
+
+  fixed_matrix &operator/=(const fixed_matrix &mat);
+
+  /**
+     * Operations of every item with val
+     */
+  fixed_matrix &operator+=(const ValueType &val);
+
+  fixed_matrix &operator-=(const ValueType &val);
+
+  fixed_matrix &operator*=(const ValueType &val);
+
+  fixed_matrix &operator/=(const ValueType &val);
+
+  /**
+     * @returns a reference to row(rowIndex), no bounds checking
+     */
+  matrix_row<ValueType> operator[](int rowIndex);
+
+  matrix_row<const ValueType> operator[](int rowIndex) const;
+
+  /**
+     * Multiply the two matrices, the inner dimensions are checked
+     * at compile time
+     * @returns a new matrix results from multiplication
+     * @bigoh O(Rows x Cols x K), unrolled
+     */
+  template <int K>
+  fixed_matrix<ValueType, Rows, K> multiply(const fixed_matrix<ValueType, Cols, K> &mat) const;
+
+  /**
+     * @returns the transposed matrix
+     * @bigoh O(Rows x Cols), unrolled
+     */
+  fixed_matrix<ValueType, Cols, Rows> transpose() const;
+
+  /**
+     * @returns the determinant, closed forms up to 4x4 and
+     *          elimination with partial pivoting above
+     * @bigoh O(Rows^3), unrolled
+     */
+  ValueType det() const;
+
+  /**
+     * Matrix inverse, closed forms up to 3x3 and Gauss-Jordan
+     * elimination with partial pivoting above
+     * @throw   out_of_range if determinant = zero
+     * @returns a new matrix results from inverting
+     * @bigoh O(Rows^3), unrolled
+     */
+  fixed_matrix invert() const;
+
+  static constexpr int get_rows() { return Rows; }
+
+  static constexpr int get_cols() { return Cols; }
+
+  ValueType *data() { return elements.data(); }
+
+  const ValueType *data() const { return elements.data(); }
+
+private:
+  ValueType &at(int i, int j) { return elements[i * Cols + j]; }
+
+  const ValueType &at(int i, int j) const { return elements[i * Cols + j]; }
+
+  template <typename Function>
+  fixed_matrix &apply(Function fn);
+
+  std::array<ValueType, Rows * Cols> elements;
+};
+
+template <typename ValueType, int Rows, int Cols>
+fixed_matrix<ValueType, Rows, Cols>::fixed_matrix() : elements()
+{
+}
+
+template <typename ValueType, int Rows, int Cols>
+fixed_matrix<ValueType, Rows, Cols>::fixed_matrix(
+    std::initializer_list<std::initializer_list<ValueType>> list)
+    : elements()
+{
+    if (list.size() != static_cast<size_t>(Rows))
+        throw std::length_error("fixed_matrix -> wrong number of rows");
+    int i = 0;
+    for (const auto &row : list)
+    {
+        if (row.size() != static_cast<size_t>(Cols))
+            throw std::length_error("fixed_matrix -> wrong number of columns");
+        std::copy(row.begin(), row.end(), elements.begin() + i++ * Cols);
+    }
+}
+
+template <typename ValueType, int Rows, int Cols>
+fixed_matrix<ValueType, Rows, Cols>::fixed_matrix(const matrix<ValueType> &mat)
+{
+    if (mat.get_rows() != Rows || mat.get_cols() != Cols)
+        throw std::length_error("fixed_matrix -> matrix dimentions must be the same");
+    for (int i = 0; i < Rows; i++)
+        std::copy(mat[i].begin(), mat[i].end(), elements.begin() + i * Cols);
+}
+
+template <typename ValueType, int Rows, int Cols>
+fixed_matrix<ValueType, Rows, Cols>::operator matrix<ValueType>() const
+{
+    matrix<ValueType> res(Rows, Cols);
+    for (int i = 0; i < Rows; i++)
+        std::copy(elements.begin() + i * Cols, elements.begin() + (i + 1) * Cols, res[i].begin());
+    return res;
+}
+
+template <typename ValueType, int Rows, int Cols>
+fixed_matrix<ValueType, Rows, Cols> fixed_matrix<ValueType, Rows, Cols>::identity()
+{
+    static_assert(Rows == Cols, "fixed_matrix::identity -> matrix must be square");
+    fixed_matrix res;
+    matrix_kernels::unroll<Rows>([&](int i) { res.at(i, i) = static_cast<ValueType>(1); });
+    return res;
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline bool fixed_matrix<ValueType, Rows, Cols>::operator==(const fixed_matrix &mat) const
+{
+    return elements == mat.elements;
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline bool fixed_matrix<ValueType, Rows, Cols>::operator!=(const fixed_matrix &mat) const
+{
+    return elements != mat.elements;
+}
+
+template <typename ValueType, int Rows, int Cols>
+template <typename Function>
+inline fixed_matrix<ValueType, Rows, Cols> &fixed_matrix<ValueType, Rows, Cols>::apply(Function fn)
+{
+    matrix_kernels::unroll<Rows * Cols>([&](int i) { fn(elements[i], i); });
+    return *this;
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline fixed_matrix<ValueType, Rows, Cols> &fixed_matrix<ValueType, Rows, Cols>::operator+=(const fixed_matrix &mat)
+{
+    return apply([&](ValueType &x, int i) { x += mat.elements[i]; });
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline fixed_matrix<ValueType, Rows, Cols> &fixed_matrix<ValueType, Rows, Cols>::operator-=(const fixed_matrix &mat)
+{
+    return apply([&](ValueType &x, int i) { x -= mat.elements[i]; });
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline fixed_matrix<ValueType, Rows, Cols> &fixed_matrix<ValueType, Rows, Cols>::operator*=(const fixed_matrix &mat)
+{
+    return apply([&](ValueType &x, int i) { x *= mat.elements[i]; });
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline fixed_matrix<ValueType, Rows, Cols> &fixed_matrix<ValueType, Rows, Cols>::operator/=(const fixed_matrix &mat)
+{
+    return apply([&](ValueType &x, int i) { x /= mat.elements[i]; });
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline fixed_matrix<ValueType, Rows, Cols> &fixed_matrix<ValueType, Rows, Cols>::operator+=(const ValueType &val)
+{
+    return apply([&](ValueType &x, int) { x += val; });
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline fixed_matrix<ValueType, Rows, Cols> &fixed_matrix<ValueType, Rows, Cols>::operator-=(const ValueType &val)
+{
+    return apply([&](ValueType &x, int) { x -= val; });
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline fixed_matrix<ValueType, Rows, Cols> &fixed_matrix<ValueType, Rows, Cols>::operator*=(const ValueType &val)
+{
+    return apply([&](ValueType &x, int) { x *= val; });
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline fixed_matrix<ValueType, Rows, Cols> &fixed_matrix<ValueType, Rows, Cols>::operator/=(const ValueType &val)
+{
+    return apply([&](ValueType &x, int) { x /= val; });
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline matrix_row<ValueType> fixed_matrix<ValueType, Rows, Cols>::operator[](int rowIndex)
+{
+    return matrix_row<ValueType>(elements.data() + rowIndex * Cols, Cols);
+}
+
+template <typename ValueType, int Rows, int Cols>
+inline matrix_row<const ValueType> fixed_matrix<ValueType, Rows, Cols>::operator[](int rowIndex) const
+{
+    return matrix_row<const ValueType>(elements.data() + rowIndex * Cols, Cols);
+}
+
+template <typename ValueType, int Rows, int Cols>
+template <int K>
+fixed_matrix<ValueType, Rows, K>
+fixed_matrix<ValueType, Rows, Cols>::multiply(const fixed_matrix<ValueType, Cols, K> &mat) const
+{
+    fixed_matrix<ValueType, Rows, K> res;
+    ValueType *dst = res.data();
+    const ValueType *b = mat.data();
+    matrix_kernels::unroll<Rows>([&](int i) {
+        matrix_kernels::unroll<Cols>([&](int t) {
+            const ValueType a_it = at(i, t);
+            matrix_kernels::unroll<K>([&](int j) { dst[i * K + j] += a_it * b[t * K + j]; });
+        });
+    });
+    return res;
+}
+
+template <typename ValueType, int Rows, int Cols>
+fixed_matrix<ValueType, Cols, Rows> fixed_matrix<ValueType, Rows, Cols>::transpose() const
+{
+    fixed_matrix<ValueType, Cols, Rows> res;
+    ValueType *dst = res.data();
+    matrix_kernels::unroll<Rows>([&](int i) {
+        matrix_kernels::unroll<Cols>([&](int j) { dst[j * Rows + i] = at(i, j); });
+    });
+    return res;
+}
+
+template <typename ValueType, int Rows, int Cols>
+ValueType fixed_matrix<ValueType, Rows, Cols>::det() const
+{
+    static_assert(Rows == Cols, "fixed_matrix::det -> matrix must be square");
+    constexpr int n = Rows;
+    if constexpr (n <= 4)
+    {
+        return matrix_kernels::det_small(n, elements.data(), n);
+    }
+    else
+    {
+        using std::abs;
+        std::array<ValueType, n * n> a = elements;
+        ValueType det_val = static_cast<ValueType>(1);
+        bool singular = false;
+        matrix_kernels::unroll<n>([&](int k) {
+            if (singular)
+                return;
+            int index_max = k;
+            for (int i = k + 1; i < n; i++)
+                if (abs(a[i * n + k]) > abs(a[index_max * n + k]))
+                    index_max = i;
+            if (a[index_max * n + k] == static_cast<ValueType>(0))
+            {
+                singular = true;
+                return;
+            }
+            if (index_max != k)
+            {
+                std::swap_ranges(a.begin() + k * n, a.begin() + (k + 1) * n, a.begin() + index_max * n);
+                det_val = -det_val;
+            }
+            const ValueType pivot = a[k * n + k];
+            det_val *= pivot;
+            for (int i = k + 1; i < n; i++)
+            {
+                const ValueType factor = a[i * n + k] / pivot;
+                for (int j = k + 1; j < n; j++)
+                    a[i * n + j] -= factor * a[k * n + j];
+            }
+        });
+        return singular ? static_cast<ValueType>(0) : det_val;
+    }
+}
+
+template <typename ValueType, int Rows, int Cols>
+fixed_matrix<ValueType, Rows, Cols> fixed_matrix<ValueType, Rows, Cols>::invert() const
+{
+    static_assert(Rows == Cols, "fixed_matrix::invert -> matrix must be square");
+    constexpr int n = Rows;
+    fixed_matrix res;
+    if constexpr (n <= 3)
+    {
+        const ValueType det_val = det();
+        if (det_val == static_cast<ValueType>(0))
+            throw std::out_of_range("fixed_matrix::invert -> Determinant equal zero");
+        const ValueType *a = elements.data();
+        ValueType *r = res.data();
+        if constexpr (n == 1)
+        {
+            r[0] = static_cast<ValueType>(1) / det_val;
+        }
+        else if constexpr (n == 2)
+        {
+            r[0] = a[3] / det_val;
+            r[1] = -a[1] / det_val;
+            r[2] = -a[2] / det_val;
+            r[3] = a[0] / det_val;
+        }
+        else
+        {
+            // adjugate: transposed cofactors
+            matrix_kernels::unroll<3>([&](int i) {
+                matrix_kernels::unroll<3>([&](int j) {
+                    const int r0 = (j + 1) % 3, r1 = (j + 2) % 3;
+                    const int c0 = (i + 1) % 3, c1 = (i + 2) % 3;
+                    r[i * 3 + j] = (a[r0 * 3 + c0] * a[r1 * 3 + c1] - a[r0 * 3 + c1] * a[r1 * 3 + c0]) / det_val;
+                });
+            });
+        }
+        return res;
+    }
+    else
+    {
+        using std::abs;
+        std::array<ValueType, n * n> a = elements;
+        res = identity();
+        ValueType *r = res.data();
+        matrix_kernels::unroll<n>([&](int k) {
+            int index_max = k;
+            for (int i = k + 1; i < n; i++)
+                if (abs(a[i * n + k]) > abs(a[index_max * n + k]))
+                    index_max = i;
+            if (a[index_max * n + k] == static_cast<ValueType>(0))
+                throw std::out_of_range("fixed_matrix::invert -> Determinant equal zero");
+            if (index_max != k)
+            {
+                std::swap_ranges(a.begin() + k * n, a.begin() + (k + 1) * n, a.begin() + index_max * n);
+                std::swap_ranges(r + k * n, r + (k + 1) * n, r + index_max * n);
+            }
+            const ValueType pivot = a[k * n + k];
+            matrix_kernels::unroll<n>([&](int j) {
+                a[k * n + j] /= pivot;
+                r[k * n + j] /= pivot;
+            });
+            matrix_kernels::unroll<n>([&](int i) {
+                if (i == k)
+                    return;
+                const ValueType factor = a[i * n + k];
+                matrix_kernels::unroll<n>([&](int j) {
+                    a[i * n + j] -= factor * a[k * n + j];
+                    r[i * n + j] -= factor * r[k * n + j];
+                });
+            });
+        });
+        return res;
+    }
+}
+
+/**
+ * Element-wise operators, the dimensions are checked at compile time
+ */
+template <typename T, int R, int C>
+inline fixed_matrix<T, R, C> operator+(fixed_matrix<T, R, C> lhs, const fixed_matrix<T, R, C> &rhs)
+{
+    return lhs += rhs;
+}
+
+template <typename T, int R, int C>
+inline fixed_matrix<T, R, C> operator-(fixed_matrix<T, R, C> lhs, const fixed_matrix<T, R, C> &rhs)
+{
+    return lhs -= rhs;
+}
+
+template <typename T, int R, int C>
+inline fixed_matrix<T, R, C> operator*(fixed_matrix<T, R, C> lhs, const fixed_matrix<T, R, C> &rhs)
+{
+    return lhs *= rhs;
+}
+
+template <typename T, int R, int C>
+inline fixed_matrix<T, R, C> operator/(fixed_matrix<T, R, C> lhs, const fixed_matrix<T, R, C> &rhs)
+{
+    return lhs /= rhs;
+}
+
+template <typename T, int R, int C>
+inline fixed_matrix<T, R, C> operator+(fixed_matrix<T, R, C> lhs, const T &val)
+{
+    return lhs += val;
+}
+
+template <typename T, int R, int C>
+inline fixed_matrix<T, R, C> operator-(fixed_matrix<T, R, C> lhs, const T &val)
+{
+    return lhs -= val;
+}
+
+template <typename T, int R, int C>
+inline fixed_matrix<T, R, C> operator*(fixed_matrix<T, R, C> lhs, const T &val)
+{
+    return lhs *= val;
+}
+
+template <typename T, int R, int C>
+inline fixed_matrix<T, R, C> operator/(fixed_matrix<T, R, C> lhs, const T &val)
+{
+    return lhs /= val;
+}
+
+/**
+ * Overloads << operator to print the matrix in the standard format
+ */
+template <typename T, int R, int C>
+std::ostream &operator<<(std::ostream &os, const fixed_matrix<T, R, C> &mat)
+{
+    for (int i = 0; i < R; i++)
+    {
+        for (const auto &element : mat[i])
+            os << element << " ";
+        os << std::endl;
+    }
+    return os;
+}
+
+#endif // End of the file
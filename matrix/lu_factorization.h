@@ -0,0 +1,397 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file lu_factorization.h
+ * @brief
+ *
+ * This file provides the <code>lu_factorization</code> class, the LU
+ * decomposition with partial pivoting (P x A = L x U) of a square
+ * <code>matrix</code>. The matrix is factorized once in O(n^3) and the
+ * factorization then answers determinant, inverse and linear system
+ * queries without touching the original matrix again.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _LU_FACTORIZATION_H_
+#define _LU_FACTORIZATION_H_
+
+#include <cmath>
+#include <vector>
+#include <complex>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "matrix_def.h"
+#include "matrix_view.h"
+#include "matrix_arena.h"
+#include "matrix_gemm.h"
+#include "thread_pool.h"
+#include "simd_kernels.h"
+
+template <typename ValueType, typename Allocator>
+class lu_factorization
+{
+public:
+  /**
+     * Factorizes the given matrix
+     * @throw   length_error if it's not a squre matrix
+     * @bigoh   O(rows^3)
+     */
+  template <typename OtherAllocator>
+  explicit lu_factorization(const matrix<ValueType, OtherAllocator> &mat);
+
+  /**
+     * Factorizes the given matrix, reusing its buffer
+     * @throw   length_error if it's not a squre matrix
+     * @bigoh   O(rows^3)
+     */
+  explicit lu_factorization(matrix<ValueType, Allocator> &&mat);
+
+  /**
+     * Factorizes the viewed matrix (a block, a transpose...)
+     * @throw   length_error if it's not a squre matrix
+     * @bigoh   O(rows^3)
+     */
+  template <typename ViewType>
+  explicit lu_factorization(const matrix_view<ViewType> &view);
+
+  /**
+     * @returns the determinant of the factorized matrix
+     * @bigoh   O(rows)
+     */
+  ValueType det() const;
+
+  /**
+     * @returns the inverse of the factorized matrix
+     * @throw   out_of_range if the matrix is singular
+     * @bigoh   O(rows^3)
+     */
+  matrix<ValueType, Allocator> inverse() const;
+
+  /**
+     * Solves A x = vec
+     * @throw   length_error if vec.size() != rows
+     * @throw   out_of_range if the matrix is singular
+     * @returns the solution x
+     * @bigoh   O(rows^2)
+     */
+  vector<ValueType> solve(const vector<ValueType> &vec) const;
+
+  /**
+     * Solves A X = mat for every column of mat
+     * @throw   length_error if mat.rows != rows
+     * @throw   out_of_range if the matrix is singular
+     * @returns the solution X
+     * @bigoh   O(rows^2 x mat.columns)
+     */
+  template <typename OtherAllocator>
+  matrix<ValueType, Allocator> solve(const matrix<ValueType, OtherAllocator> &mat) const;
+
+  /**
+     * Solves A X = view for every column of the viewed matrix
+     * @throw   length_error if view.rows != rows
+     * @throw   out_of_range if the matrix is singular
+     * @returns the solution X
+     * @bigoh   O(rows^2 x view.columns)
+     */
+  template <typename ViewType>
+  matrix<ValueType, Allocator> solve(const matrix_view<ViewType> &view) const;
+
+  /**
+     * @returns true if a zero pivot was met, the determinant is zero
+     * @bigoh   O(1)
+     */
+  bool is_singular() const;
+
+  /**
+     * @returns the number of rows (and columns) of the factorized matrix
+     * @bigoh   O(1)
+     */
+  int size() const;
+
+  /**
+     * @returns the row permutation, row i of P x A is row perm[i] of A
+     * @bigoh   O(1)
+     */
+  const vector<int> &permutation() const;
+
+  /**
+     * @returns L and U packed in one matrix: U on and above the diagonal,
+     *          the unit lower triangular L below it
+     * @bigoh   O(1)
+     */
+  const matrix<ValueType, Allocator> &packed() const;
+
+private:
+  /**
+     * Blocked right-looking factorization: every panel of block_size
+     * columns is factorized with partial pivoting, then the block row
+     * of U is solved and the trailing matrix is updated with gemm.
+     */
+  void factorize();
+
+  /**
+     * Applies P, L^-1 and U^-1 in place to columns [first, last) of x
+     */
+  void substitute(matrix<ValueType, Allocator> &x, int first, int last) const;
+
+  /**
+     * Solves A X = x in place, x holds the permuted right hand sides
+     */
+  void solve_in_place(matrix<ValueType, Allocator> &x) const;
+
+  static constexpr int block_size = 64;
+
+  matrix<ValueType, Allocator> lu;
+  vector<int> perm;
+  int sign;
+  bool singular;
+};
+
+template <typename ValueType, typename Allocator>
+template <typename OtherAllocator>
+lu_factorization<ValueType, Allocator>::lu_factorization(const matrix<ValueType, OtherAllocator> &mat)
+    : lu(mat), sign(1), singular(false)
+{
+    factorize();
+}
+
+template <typename ValueType, typename Allocator>
+lu_factorization<ValueType, Allocator>::lu_factorization(matrix<ValueType, Allocator> &&mat)
+    : lu(std::move(mat)), sign(1), singular(false)
+{
+    factorize();
+}
+
+template <typename ValueType, typename Allocator>
+template <typename ViewType>
+lu_factorization<ValueType, Allocator>::lu_factorization(const matrix_view<ViewType> &view)
+    : lu(view), sign(1), singular(false)
+{
+    factorize();
+}
+
+template <typename ValueType, typename Allocator>
+void lu_factorization<ValueType, Allocator>::factorize()
+{
+    using std::abs;
+
+    if (lu.get_rows() != lu.get_cols())
+        throw std::length_error("lu_factorization -> matrix must be square");
+    const int n = lu.get_rows();
+    const int ld = lu.get_stride();
+    ValueType *a = lu.data();
+    perm.resize(n);
+    for (int i = 0; i < n; i++)
+        perm[i] = i;
+    // negated copy of the L21 panel, sized by the first (largest) one
+    matrix<ValueType, arena_allocator<ValueType>> l21;
+
+    for (int k = 0; k < n; k += block_size)
+    {
+        const int nb = std::min(block_size, n - k);
+
+        // factorize the panel, columns [k, k + nb), with partial pivoting
+        for (int j = k; j < k + nb; j++)
+        {
+            int index_max = j;
+            for (int i = j + 1; i < n; i++)
+                if (abs(a[static_cast<size_t>(i) * ld + j]) > abs(a[static_cast<size_t>(index_max) * ld + j]))
+                    index_max = i;
+            if (index_max != j)
+            {
+                lu.swap_rows(j, index_max);
+                std::swap(perm[j], perm[index_max]);
+                sign = -sign;
+            }
+            const ValueType *pivot_row = a + static_cast<size_t>(j) * ld;
+            if (pivot_row[j] == static_cast<ValueType>(0))
+            {
+                singular = true;
+                continue;
+            }
+            for (int i = j + 1; i < n; i++)
+            {
+                ValueType *row = a + static_cast<size_t>(i) * ld;
+                row[j] /= pivot_row[j];
+                matrix_kernels::vec_axpy(k + nb - j - 1, -row[j], pivot_row + j + 1, row + j + 1);
+            }
+        }
+
+        const int rest = n - k - nb;
+        if (rest <= 0)
+            continue;
+
+        // U12 = L11^-1 x A12
+        for (int j = k + 1; j < k + nb; j++)
+        {
+            ValueType *row = a + static_cast<size_t>(j) * ld;
+            for (int t = k; t < j; t++)
+                matrix_kernels::vec_axpy(rest, -row[t], a + static_cast<size_t>(t) * ld + k + nb, row + k + nb);
+        }
+
+        // A22 -= L21 x U12, gemm accumulates so L21 is negated into a copy
+        if (k == 0)
+            l21 = matrix<ValueType, arena_allocator<ValueType>>(rest, nb);
+        for (int i = 0; i < rest; i++)
+        {
+            const ValueType *src = a + static_cast<size_t>(k + nb + i) * ld + k;
+            ValueType *dst = l21[i].data();
+            for (int t = 0; t < nb; t++)
+                dst[t] = -src[t];
+        }
+        matrix_kernels::gemm(rest, rest, nb, l21.data(), l21.get_stride(),
+                             a + static_cast<size_t>(k) * ld + k + nb, ld,
+                             a + static_cast<size_t>(k + nb) * ld + k + nb, ld);
+    }
+}
+
+template <typename ValueType, typename Allocator>
+ValueType lu_factorization<ValueType, Allocator>::det() const
+{
+    if (singular)
+        return static_cast<ValueType>(0);
+    ValueType det_val = static_cast<ValueType>(1);
+    for (int i = 0; i < lu.get_rows(); i++)
+        det_val *= lu[i][i];
+    return sign < 0 ? -det_val : det_val;
+}
+
+template <typename ValueType, typename Allocator>
+void lu_factorization<ValueType, Allocator>::substitute(matrix<ValueType, Allocator> &x, int first, int last) const
+{
+    const int n = lu.get_rows();
+    const int width = last - first;
+    // L y = P b, L has a unit diagonal
+    for (int i = 1; i < n; i++)
+    {
+        const ValueType *l_row = lu[i].data();
+        ValueType *x_row = x[i].data() + first;
+        for (int t = 0; t < i; t++)
+            if (l_row[t] != static_cast<ValueType>(0))
+                matrix_kernels::vec_axpy(width, -l_row[t], x[t].data() + first, x_row);
+    }
+    // U x = y
+    for (int i = n - 1; i >= 0; i--)
+    {
+        const ValueType *u_row = lu[i].data();
+        ValueType *x_row = x[i].data() + first;
+        for (int t = i + 1; t < n; t++)
+            if (u_row[t] != static_cast<ValueType>(0))
+                matrix_kernels::vec_axpy(width, -u_row[t], x[t].data() + first, x_row);
+        matrix_kernels::vec_div_scalar(width, x_row, u_row[i]);
+    }
+}
+
+template <typename ValueType, typename Allocator>
+template <typename OtherAllocator>
+matrix<ValueType, Allocator> lu_factorization<ValueType, Allocator>::solve(const matrix<ValueType, OtherAllocator> &mat) const
+{
+    if (mat.get_rows() != lu.get_rows())
+        throw std::length_error("lu_factorization::solve -> check matrix dimentions");
+    if (singular)
+        throw std::out_of_range("lu_factorization::solve -> Determinant equal zero");
+    const int n = lu.get_rows();
+    matrix<ValueType, Allocator> x(n, mat.get_cols());
+    for (int i = 0; i < n; i++)
+        x[i] = mat[perm[i]];
+    solve_in_place(x);
+    return x;
+}
+
+template <typename ValueType, typename Allocator>
+template <typename ViewType>
+matrix<ValueType, Allocator> lu_factorization<ValueType, Allocator>::solve(const matrix_view<ViewType> &view) const
+{
+    if (view.get_rows() != lu.get_rows())
+        throw std::length_error("lu_factorization::solve -> check matrix dimentions");
+    if (singular)
+        throw std::out_of_range("lu_factorization::solve -> Determinant equal zero");
+    const int n = lu.get_rows();
+    const int cols = view.get_cols();
+    matrix<ValueType, Allocator> x(n, cols);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < cols; j++)
+            x[i][j] = view(perm[i], j);
+    solve_in_place(x);
+    return x;
+}
+
+template <typename ValueType, typename Allocator>
+void lu_factorization<ValueType, Allocator>::solve_in_place(matrix<ValueType, Allocator> &x) const
+{
+    const int n = lu.get_rows();
+    const int cols = x.get_cols();
+    const size_t work = static_cast<size_t>(n) * n * cols;
+    matrix_parallel::parallel_for(0, cols, work, [&](int first, int last) {
+        substitute(x, first, last);
+    });
+}
+
+template <typename ValueType, typename Allocator>
+vector<ValueType> lu_factorization<ValueType, Allocator>::solve(const vector<ValueType> &vec) const
+{
+    if (vec.size() != static_cast<size_t>(lu.get_rows()))
+        throw std::length_error("lu_factorization::solve -> vector.size() must be equal to matrix::rows");
+    if (singular)
+        throw std::out_of_range("lu_factorization::solve -> Determinant equal zero");
+    const int n = lu.get_rows();
+    vector<ValueType> x(n);
+    for (int i = 0; i < n; i++)
+        x[i] = vec[perm[i]];
+    for (int i = 1; i < n; i++)
+        x[i] -= matrix_kernels::vec_dot(i, lu[i].data(), x.data());
+    for (int i = n - 1; i >= 0; i--)
+    {
+        x[i] -= matrix_kernels::vec_dot(n - i - 1, lu[i].data() + i + 1, x.data() + i + 1);
+        x[i] /= lu[i][i];
+    }
+    return x;
+}
+
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> lu_factorization<ValueType, Allocator>::inverse() const
+{
+    if (singular)
+        throw std::out_of_range("matrix::invert -> Determinant equal zero");
+    const int n = lu.get_rows();
+    matrix<ValueType, Allocator> identity(n, n);
+    for (int i = 0; i < n; i++)
+        identity[i][i] = static_cast<ValueType>(1);
+    return solve(identity);
+}
+
+template <typename ValueType, typename Allocator>
+inline bool lu_factorization<ValueType, Allocator>::is_singular() const
+{
+    return singular;
+}
+
+template <typename ValueType, typename Allocator>
+inline int lu_factorization<ValueType, Allocator>::size() const
+{
+    return lu.get_rows();
+}
+
+template <typename ValueType, typename Allocator>
+inline const vector<int> &lu_factorization<ValueType, Allocator>::permutation() const
+{
+    return perm;
+}
+
+template <typename ValueType, typename Allocator>
+inline const matrix<ValueType, Allocator> &lu_factorization<ValueType, Allocator>::packed() const
+{
+    return lu;
+}
+
+#endif // End of the file
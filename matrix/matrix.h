@@ -26,5 +26,13 @@
 
 #include "matrix_def.h"
 #include "matrix_impl.h"
+#include "fixed_matrix.h"
+#include "sparse_matrix.h"
+#include "diagonal_matrix.h"
+#include "triangular_matrix.h"
+#include "symmetric_matrix.h"
+#include "band_matrix.h"
+#include "matrix_batch.h"
+#include "matrix_file.h"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,337 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_arena.h
+ * @brief
+ *
+ * This file provides a bump allocator for short lived matrices:
+ *
+ *  - <code>matrix_arena</code> hands out aligned memory from large chunks
+ *    and frees it all at once
+ *  - <code>scoped_arena</code> makes an arena the current one of the
+ *    calling thread and gives back everything allocated in the scope
+ *    when it ends
+ *  - <code>arena_allocator</code> is an STL allocator that allocates from
+ *    the current arena of the thread that created it, or from the heap
+ *    when no arena is active
+ *
+ * <code>matrix&lt;T, arena_allocator&lt;T&gt;&gt;</code> allocated inside a
+ * scope must not outlive it. The library uses arena_allocator for its
+ * internal scratch buffers, which never escape the call that made them.
+ * An arena belongs to one thread; pool threads don't see the arena of the
+ * caller and allocate from the heap.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _MATRIX_ARENA_H_
+#define _MATRIX_ARENA_H_
+
+#include <new>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+#include "matrix_storage.h"
+
+class matrix_arena
+{
+public:
+  /**
+     * Position in the arena, everything allocated after it can be
+     * released with rewind()
+     */
+  struct marker
+  {
+    std::size_t chunk;
+    char *top;
+    std::size_t used;
+  };
+
+  /**
+     * Creates an empty arena, nothing is allocated before the first request
+     * @param chunk_size size in bytes of the first chunk, every new chunk
+     *                   is twice as large as the previous one
+     */
+  explicit matrix_arena(std::size_t chunk_size = 1 << 16)
+      : top(nullptr), end(nullptr), next_size(chunk_size), used_bytes(0)
+  {
+  }
+
+  matrix_arena(const matrix_arena &) = delete;
+
+  matrix_arena &operator=(const matrix_arena &) = delete;
+
+  ~matrix_arena()
+  {
+    for (const auto &c : chunks)
+      ::operator delete(c.data, std::align_val_t(matrix_alignment));
+  }
+
+  /**
+     * @returns bytes of memory aligned to alignment
+     * @bigoh   O(1), a new chunk is allocated when the current one is full
+     */
+  void *allocate(std::size_t bytes, std::size_t alignment)
+  {
+    char *p = align_up(top, alignment);
+    if (!top || p + bytes > end)
+    {
+      add_chunk(bytes + alignment);
+      p = align_up(top, alignment);
+    }
+    used_bytes += p + bytes - top;
+    top = p + bytes;
+    return p;
+  }
+
+  /**
+     * Memory is given back by rewind() or reset(), except for the last
+     * allocation which is undone right away (e.g. a vector that grows)
+     */
+  void deallocate(void *p, std::size_t bytes) noexcept
+  {
+    if (static_cast<char *>(p) + bytes == top)
+    {
+      used_bytes -= bytes;
+      top = static_cast<char *>(p);
+    }
+  }
+
+  /**
+     * @returns the current position
+     */
+  marker mark() const
+  {
+    return marker{chunks.size(), top, used_bytes};
+  }
+
+  /**
+     * Releases everything allocated since m was taken
+     */
+  void rewind(const marker &m)
+  {
+    if (m.used == 0)
+    {
+      reset();
+      return;
+    }
+    while (chunks.size() > m.chunk)
+    {
+      ::operator delete(chunks.back().data, std::align_val_t(matrix_alignment));
+      chunks.pop_back();
+    }
+    top = m.top;
+    end = chunks.back().data + chunks.back().size;
+    used_bytes = m.used;
+  }
+
+  /**
+     * Releases everything. The chunks are merged into one chunk of their
+     * total size, so the next round of the same work allocates nothing.
+     */
+  void reset()
+  {
+    if (chunks.size() > 1)
+    {
+      std::size_t total = 0;
+      for (const auto &c : chunks)
+      {
+        total += c.size;
+        ::operator delete(c.data, std::align_val_t(matrix_alignment));
+      }
+      chunks.clear();
+      add_chunk(total);
+    }
+    top = chunks.empty() ? nullptr : chunks.front().data;
+    end = chunks.empty() ? nullptr : chunks.front().data + chunks.front().size;
+    used_bytes = 0;
+  }
+
+  /**
+     * @returns bytes handed out since the last reset
+     */
+  std::size_t used() const { return used_bytes; }
+
+  /**
+     * @returns bytes owned by the arena
+     */
+  std::size_t capacity() const
+  {
+    std::size_t total = 0;
+    for (const auto &c : chunks)
+      total += c.size;
+    return total;
+  }
+
+  /**
+     * @returns the arena of the innermost scoped_arena of the calling
+     *          thread, nullptr if there is none
+     */
+  static matrix_arena *current() { return current_ref(); }
+
+private:
+  friend class scoped_arena;
+
+  struct chunk
+  {
+    char *data;
+    std::size_t size;
+  };
+
+  static matrix_arena *&current_ref()
+  {
+    thread_local matrix_arena *arena = nullptr;
+    return arena;
+  }
+
+  static char *align_up(char *p, std::size_t alignment)
+  {
+    const std::uintptr_t v = reinterpret_cast<std::uintptr_t>(p);
+    return p + ((alignment - v % alignment) % alignment);
+  }
+
+  void add_chunk(std::size_t min_size)
+  {
+    const std::size_t size = std::max(next_size, min_size);
+    char *data = static_cast<char *>(::operator new(size, std::align_val_t(matrix_alignment)));
+    chunks.push_back(chunk{data, size});
+    top = data;
+    end = data + size;
+    next_size = size * 2;
+  }
+
+  std::vector<chunk> chunks;
+  char *top;
+  char *end;
+  std::size_t next_size;
+  std::size_t used_bytes;
+};
+
+/**
+ * Makes an arena the current one of the calling thread for the lifetime
+ * of the object, and releases what was allocated from it in that time.
+ * Scopes nest, the previous arena is restored on exit.
+ */
+class scoped_arena
+{
+public:
+  /**
+     * Uses an arena owned by the scope
+     */
+  scoped_arena() : owned(new matrix_arena), arena(*owned)
+  {
+    enter();
+  }
+
+  /**
+     * Uses an existing arena, its chunks are kept for the next scope
+     */
+  explicit scoped_arena(matrix_arena &arena) : arena(arena)
+  {
+    enter();
+  }
+
+  scoped_arena(const scoped_arena &) = delete;
+
+  scoped_arena &operator=(const scoped_arena &) = delete;
+
+  ~scoped_arena()
+  {
+    matrix_arena::current_ref() = previous;
+    arena.rewind(start);
+  }
+
+  matrix_arena &get() { return arena; }
+
+private:
+  void enter()
+  {
+    previous = matrix_arena::current_ref();
+    matrix_arena::current_ref() = &arena;
+    start = arena.mark();
+  }
+
+  std::unique_ptr<matrix_arena> owned;
+  matrix_arena &arena;
+  matrix_arena *previous;
+  matrix_arena::marker start;
+};
+
+/**
+ * STL allocator drawing from the arena that was current when it was
+ * created, from the heap if there was none. Copies of a container
+ * allocate from the arena current at the time of the copy.
+ */
+template <typename ValueType, std::size_t Alignment = matrix_alignment>
+class arena_allocator
+{
+public:
+  using value_type = ValueType;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  template <typename U>
+  struct rebind
+  {
+    using other = arena_allocator<U, Alignment>;
+  };
+
+  arena_allocator() noexcept : arena(matrix_arena::current()) {}
+
+  explicit arena_allocator(matrix_arena *arena) noexcept : arena(arena) {}
+
+  template <typename U>
+  arena_allocator(const arena_allocator<U, Alignment> &alloc) noexcept : arena(alloc.get_arena()) {}
+
+  ValueType *allocate(std::size_t n)
+  {
+    if (arena)
+      return static_cast<ValueType *>(arena->allocate(n * sizeof(ValueType), alignment));
+    return static_cast<ValueType *>(::operator new(n * sizeof(ValueType), std::align_val_t(alignment)));
+  }
+
+  void deallocate(ValueType *p, std::size_t n) noexcept
+  {
+    if (arena)
+      arena->deallocate(p, n * sizeof(ValueType));
+    else
+      ::operator delete(p, std::align_val_t(alignment));
+  }
+
+  arena_allocator select_on_container_copy_construction() const
+  {
+    return arena_allocator();
+  }
+
+  matrix_arena *get_arena() const { return arena; }
+
+  template <typename U>
+  bool operator==(const arena_allocator<U, Alignment> &alloc) const noexcept
+  {
+    return arena == alloc.get_arena();
+  }
+
+  template <typename U>
+  bool operator!=(const arena_allocator<U, Alignment> &alloc) const noexcept
+  {
+    return arena != alloc.get_arena();
+  }
+
+private:
+  static constexpr std::size_t alignment = std::max(Alignment, alignof(ValueType));
+
+  matrix_arena *arena;
+};
+
+#endif // End of the file
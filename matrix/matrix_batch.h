@@ -0,0 +1,508 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_batch.h
+ * @brief
+ *
+ * This file provides the <code>matrix_batch</code> class, N independent
+ * matrices of the same shape stored as structure of arrays: element (i, j)
+ * of all the matrices is one contiguous plane, indexed by the matrix.
+ *
+ * The batched operations loop over the matrices in the innermost loop,
+ * the same arithmetic on consecutive elements, which the compiler turns
+ * into SIMD instructions, and blocks of matrices are shared between the
+ * threads of the pool.
+ *
+ *  - multiply: any shape
+ *  - det, invert, solve: closed forms up to 4x4 (the adjugate for the
+ *    inverse), above that every matrix is factorized on its own with
+ *    partial pivoting
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _MATRIX_BATCH_H_
+#define _MATRIX_BATCH_H_
+
+#include <cmath>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "matrix_def.h"
+#include "fixed_matrix.h"
+#include "thread_pool.h"
+#include "matrix_storage.h"
+#include "determinant_kernels.h"
+
+namespace matrix_kernels
+{
+    /**
+     * out[b] = det of matrix b for b in [first, last), N <= 4,
+     * plane k of the N x N matrices starts at a + k * stride
+     */
+    template <int N, typename T>
+    void batch_det_small(const T *a, std::size_t stride, int first, int last, T *out)
+    {
+        for (int b = first; b < last; b++)
+        {
+            T m[N * N];
+            unroll<N * N>([&](int k) { m[k] = a[k * stride + b]; });
+            out[b] = det_small(N, m, N);
+        }
+    }
+
+    /**
+     * Inverse of the matrices [first, last) by the adjugate, N <= 4
+     * @returns true if one of them is singular
+     */
+    template <int N, typename T>
+    bool batch_invert_small(const T *a, T *inv, std::size_t stride, int first, int last)
+    {
+        bool singular = false;
+        for (int b = first; b < last; b++)
+        {
+            T m[N * N];
+            unroll<N * N>([&](int k) { m[k] = a[k * stride + b]; });
+            const T det = det_small(N, m, N);
+            singular |= det == static_cast<T>(0);
+            const T r = static_cast<T>(1) / det;
+            if constexpr (N == 1)
+                inv[b] = r;
+            else
+            {
+                // inv(j, i) = (-1)^(i + j) det(minor(i, j)) / det
+                unroll<N * N>([&](int ij) {
+                    const int i = ij / N, j = ij % N;
+                    T minor[(N - 1) * (N - 1)];
+                    int t = 0;
+                    for (int r0 = 0; r0 < N; r0++)
+                        for (int c0 = 0; c0 < N; c0++)
+                            if (r0 != i && c0 != j)
+                                minor[t++] = m[r0 * N + c0];
+                    const T cofactor = det_small(N - 1, minor, N - 1) * r;
+                    inv[(j * N + i) * stride + b] = ((i + j) & 1) ? -cofactor : cofactor;
+                });
+            }
+        }
+        return singular;
+    }
+
+    /**
+     * LU with partial pivoting of the packed n x n matrix m, in place,
+     * row k was swapped with row perm[k] at step k
+     * @returns the sign of the permutation, 0 if m is singular
+     */
+    template <typename T>
+    int batch_lane_lu(int n, T *m, int *perm)
+    {
+        using std::abs;
+        int sign = 1;
+        for (int k = 0; k < n; k++)
+        {
+            int p = k;
+            for (int i = k + 1; i < n; i++)
+                if (abs(m[i * n + k]) > abs(m[p * n + k]))
+                    p = i;
+            perm[k] = p;
+            if (p != k)
+            {
+                std::swap_ranges(m + k * n, m + k * n + n, m + p * n);
+                sign = -sign;
+            }
+            if (m[k * n + k] == static_cast<T>(0))
+                return 0;
+            for (int i = k + 1; i < n; i++)
+            {
+                const T l = m[i * n + k] /= m[k * n + k];
+                for (int j = k + 1; j < n; j++)
+                    m[i * n + j] -= l * m[k * n + j];
+            }
+        }
+        return sign;
+    }
+
+    /**
+     * Solves LU X = P x for the packed n x cols right hand sides x, in place.
+     * The LU swaps whole rows, so P is applied before L.
+     */
+    template <typename T>
+    void batch_lane_substitute(int n, const T *m, const int *perm, T *x, int cols)
+    {
+        for (int k = 0; k < n; k++)
+            if (perm[k] != k)
+                std::swap_ranges(x + k * cols, x + k * cols + cols, x + perm[k] * cols);
+        for (int k = 0; k < n; k++)
+        {
+            for (int i = k + 1; i < n; i++)
+                for (int j = 0; j < cols; j++)
+                    x[i * cols + j] -= m[i * n + k] * x[k * cols + j];
+        }
+        for (int i = n - 1; i >= 0; i--)
+        {
+            for (int t = i + 1; t < n; t++)
+                for (int j = 0; j < cols; j++)
+                    x[i * cols + j] -= m[i * n + t] * x[t * cols + j];
+            for (int j = 0; j < cols; j++)
+                x[i * cols + j] /= m[i * n + i];
+        }
+    }
+}
+
+template <typename ValueType>
+class matrix_batch
+{
+public:
+  /**
+     * Constructs an empty batch
+     */
+  matrix_batch();
+
+  /**
+     * Constructs count (rows x cols) matrices of zeros
+     * @bigoh O(count x rows x columns)
+     */
+  matrix_batch(int count, int rows, int cols);
+
+  /**
+     * @returns a reference to element (i, j) of matrix b, no bounds checking
+     */
+  ValueType &operator()(int b, int i, int j)
+  {
+    return elements[static_cast<std::size_t>(i * cols + j) * stride + b];
+  }
+
+  const ValueType &operator()(int b, int i, int j) const
+  {
+    return elements[static_cast<std::size_t>(i * cols + j) * stride + b];
+  }
+
+  /**
+     * Copies mat into matrix b
+     * @throw out_of_range if b is not in the batch
+     * @throw length_error if the dimensions of mat are not the same
+     * @bigoh O(rows x columns)
+     */
+  template <typename Allocator>
+  void set(int b, const matrix<ValueType, Allocator> &mat);
+
+  /**
+     * @returns a copy of matrix b
+     * @throw out_of_range if b is not in the batch
+     * @bigoh O(rows x columns)
+     */
+  matrix<ValueType> get(int b) const;
+
+  /**
+     * Multiply matrix b of this batch with matrix b of mat, for every b
+     * @throw   length_error if the sizes or the dimensions don't match
+     * @returns the batch of the products
+     * @bigoh O(count x rows x columns x mat.columns)
+     */
+  matrix_batch multiply(const matrix_batch &mat) const;
+
+  /**
+     * @throw   length_error if the matrices are not square
+     * @returns the determinant of every matrix
+     * @bigoh O(count x rows^3)
+     */
+  vector<ValueType> det() const;
+
+  /**
+     * @throw   length_error if the matrices are not square
+     * @throw   out_of_range if one of the matrices is singular
+     * @returns the batch of the inverses
+     * @bigoh O(count x rows^3)
+     */
+  matrix_batch invert() const;
+
+  /**
+     * Solves A X = rhs for matrix b of both batches, for every b
+     * @throw   length_error if the matrices are not square or
+     *          the sizes or the dimensions don't match
+     * @throw   out_of_range if one of the matrices is singular
+     * @returns the batch of the solutions
+     * @bigoh O(count x (rows^3 + rows^2 x rhs.columns))
+     */
+  matrix_batch solve(const matrix_batch &rhs) const;
+
+  int size() const { return count; }
+
+  int get_rows() const { return rows; }
+
+  int get_cols() const { return cols; }
+
+  /**
+     * @returns the plane of element (i, j): element (i, j) of matrix b
+     *          is plane(i, j)[b]
+     */
+  ValueType *plane(int i, int j) { return elements.data() + static_cast<std::size_t>(i * cols + j) * stride; }
+
+  const ValueType *plane(int i, int j) const
+  {
+    return elements.data() + static_cast<std::size_t>(i * cols + j) * stride;
+  }
+
+private:
+  /**
+     * Number of matrices of a task, the planes of a block of 3x3 doubles
+     * fit in L1
+     */
+  static constexpr int block_size = 256;
+
+  /**
+     * Calls fn(first, last) for blocks of matrices, in parallel
+     */
+  template <typename Function>
+  void for_each_block(std::size_t work_per_matrix, Function fn) const;
+
+  /**
+     * The general path, every matrix copied out and factorized on its own.
+     * fn(b, lu, perm, sign, x) is called for every matrix, x is a scratch
+     * buffer of scratch_size elements.
+     */
+  template <typename Function>
+  void for_each_lu(std::size_t scratch_size, Function fn) const;
+
+  void check_square(const char *name) const;
+
+  int count;
+  int rows;
+  int cols;
+  int stride;
+  vector<ValueType, aligned_allocator<ValueType>> elements;
+};
+
+template <typename ValueType>
+matrix_batch<ValueType>::matrix_batch() : matrix_batch(0, 0, 0)
+{
+}
+
+template <typename ValueType>
+matrix_batch<ValueType>::matrix_batch(int count, int rows, int cols)
+    : count(count), rows(rows), cols(cols), stride(padded_stride<ValueType>(count)),
+      elements(static_cast<std::size_t>(rows) * cols * stride)
+{
+    if (count < 0 || rows < 0 || cols < 0)
+        throw std::length_error("matrix_batch -> dimensions must not be negative");
+}
+
+template <typename ValueType>
+template <typename Allocator>
+void matrix_batch<ValueType>::set(int b, const matrix<ValueType, Allocator> &mat)
+{
+    if (b < 0 || b >= count)
+        throw std::out_of_range("matrix_batch::set -> index out of range");
+    if (mat.get_rows() != rows || mat.get_cols() != cols)
+        throw std::length_error("matrix_batch::set -> Matrices dimentions must be the same");
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            (*this)(b, i, j) = mat[i][j];
+}
+
+template <typename ValueType>
+matrix<ValueType> matrix_batch<ValueType>::get(int b) const
+{
+    if (b < 0 || b >= count)
+        throw std::out_of_range("matrix_batch::get -> index out of range");
+    matrix<ValueType> res(rows, cols);
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            res[i][j] = (*this)(b, i, j);
+    return res;
+}
+
+template <typename ValueType>
+template <typename Function>
+void matrix_batch<ValueType>::for_each_block(std::size_t work_per_matrix, Function fn) const
+{
+    const int blocks = (count + block_size - 1) / block_size;
+    matrix_parallel::parallel_for(0, blocks, work_per_matrix * count, [&](int first, int last) {
+        fn(first * block_size, std::min(count, last * block_size));
+    });
+}
+
+template <typename ValueType>
+template <typename Function>
+void matrix_batch<ValueType>::for_each_lu(std::size_t scratch_size, Function fn) const
+{
+    const int n = rows;
+    for_each_block(static_cast<std::size_t>(n) * n * n, [&](int first, int last) {
+        vector<ValueType> lu(static_cast<std::size_t>(n) * n);
+        vector<ValueType> x(scratch_size);
+        vector<int> perm(n);
+        for (int b = first; b < last; b++)
+        {
+            for (int k = 0; k < n * n; k++)
+                lu[k] = elements[k * static_cast<std::size_t>(stride) + b];
+            const int sign = matrix_kernels::batch_lane_lu(n, lu.data(), perm.data());
+            fn(b, lu.data(), perm.data(), sign, x.data());
+        }
+    });
+}
+
+template <typename ValueType>
+void matrix_batch<ValueType>::check_square(const char *name) const
+{
+    if (rows != cols)
+        throw std::length_error(std::string(name) + " -> matrices must be square");
+}
+
+template <typename ValueType>
+matrix_batch<ValueType> matrix_batch<ValueType>::multiply(const matrix_batch &mat) const
+{
+    if (count != mat.count || cols != mat.rows)
+        throw std::length_error("matrix_batch::multiply -> check matrices dimentions");
+    matrix_batch res(count, rows, mat.cols);
+    const int n = mat.cols;
+    for_each_block(static_cast<std::size_t>(rows) * cols * n, [&](int first, int last) {
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < n; j++)
+            {
+                ValueType *c = res.plane(i, j);
+                for (int k = 0; k < cols; k++)
+                {
+                    const ValueType *a = plane(i, k);
+                    const ValueType *b = mat.plane(k, j);
+                    for (int t = first; t < last; t++)
+                        c[t] += a[t] * b[t];
+                }
+            }
+    });
+    return res;
+}
+
+template <typename ValueType>
+vector<ValueType> matrix_batch<ValueType>::det() const
+{
+    check_square("matrix_batch::det");
+    vector<ValueType> res(count);
+    const ValueType *a = elements.data();
+    const std::size_t ld = stride;
+    switch (rows)
+    {
+    case 0:
+        std::fill(res.begin(), res.end(), static_cast<ValueType>(1));
+        break;
+    case 1:
+        std::copy_n(a, count, res.begin());
+        break;
+    case 2:
+        for_each_block(8, [&](int first, int last) { matrix_kernels::batch_det_small<2>(a, ld, first, last, res.data()); });
+        break;
+    case 3:
+        for_each_block(27, [&](int first, int last) { matrix_kernels::batch_det_small<3>(a, ld, first, last, res.data()); });
+        break;
+    case 4:
+        for_each_block(64, [&](int first, int last) { matrix_kernels::batch_det_small<4>(a, ld, first, last, res.data()); });
+        break;
+    default:
+        for_each_lu(0, [&](int b, const ValueType *lu, const int *, int sign, ValueType *) {
+            ValueType det_val = static_cast<ValueType>(sign);
+            if (sign != 0)
+                for (int i = 0; i < rows; i++)
+                    det_val *= lu[i * rows + i];
+            res[b] = det_val;
+        });
+    }
+    return res;
+}
+
+template <typename ValueType>
+matrix_batch<ValueType> matrix_batch<ValueType>::invert() const
+{
+    check_square("matrix_batch::invert");
+    matrix_batch res(count, rows, cols);
+    std::atomic<bool> singular{false};
+    const ValueType *a = elements.data();
+    ValueType *inv = res.elements.data();
+    const std::size_t ld = stride;
+    auto small = [&](auto n) {
+        constexpr int N = decltype(n)::value;
+        for_each_block(N * N * N, [&](int first, int last) {
+            if (matrix_kernels::batch_invert_small<N>(a, inv, ld, first, last))
+                singular = true;
+        });
+    };
+    switch (rows)
+    {
+    case 0:
+        break;
+    case 1:
+        small(std::integral_constant<int, 1>());
+        break;
+    case 2:
+        small(std::integral_constant<int, 2>());
+        break;
+    case 3:
+        small(std::integral_constant<int, 3>());
+        break;
+    case 4:
+        small(std::integral_constant<int, 4>());
+        break;
+    default:
+        for_each_lu(static_cast<std::size_t>(rows) * rows, [&](int b, const ValueType *lu, const int *perm,
+                                                              int sign, ValueType *x) {
+            if (sign == 0)
+            {
+                singular = true;
+                return;
+            }
+            std::fill_n(x, rows * rows, ValueType());
+            for (int i = 0; i < rows; i++)
+                x[i * rows + i] = static_cast<ValueType>(1);
+            matrix_kernels::batch_lane_substitute(rows, lu, perm, x, rows);
+            for (int k = 0; k < rows * rows; k++)
+                inv[k * ld + b] = x[k];
+        });
+    }
+    if (singular)
+        throw std::out_of_range("matrix_batch::invert -> Determinant equal zero");
+    return res;
+}
+
+template <typename ValueType>
+matrix_batch<ValueType> matrix_batch<ValueType>::solve(const matrix_batch &rhs) const
+{
+    check_square("matrix_batch::solve");
+    if (count != rhs.count || rows != rhs.rows)
+        throw std::length_error("matrix_batch::solve -> check matrices dimentions");
+    // small systems are solved through their closed form inverse
+    if (rows <= 4)
+        return invert().multiply(rhs);
+    matrix_batch res(count, rhs.rows, rhs.cols);
+    std::atomic<bool> singular{false};
+    const int n = rhs.cols;
+    for_each_lu(static_cast<std::size_t>(rows) * n, [&](int b, const ValueType *lu, const int *perm,
+                                                        int sign, ValueType *x) {
+        if (sign == 0)
+        {
+            singular = true;
+            return;
+        }
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < n; j++)
+                x[i * n + j] = rhs(b, i, j);
+        matrix_kernels::batch_lane_substitute(rows, lu, perm, x, n);
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < n; j++)
+                res(b, i, j) = x[i * n + j];
+    });
+    if (singular)
+        throw std::out_of_range("matrix_batch::solve -> Determinant equal zero");
+    return res;
+}
+
+#endif // End of the file
@@ -0,0 +1,653 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_cache.h
+ * @brief
+ *
+ * This file provides the result cache of the expensive operations:
+ * <code>invert()</code>, <code>power()</code>, <code>det()</code>,
+ * <code>determinant()</code>, <code>determinant_recursive()</code> and
+ * the factorization <code>lu()</code>.
+ *
+ * The cache is off by default. It is turned on with a capacity in bytes,
+ * <code>matrix_cache::set_capacity()</code> or the MATRIX_CACHE_BYTES
+ * environment variable, and keeps the least recently used results that
+ * fit. A result is keyed by the operation, its argument (the power) and a
+ * 128 bit hash of the element type, the shape and the elements of the
+ * matrix, two matrices with equal elements share their results. The
+ * cache can be used from several threads; a result computed at the same
+ * time by two threads is computed twice.
+ *
+ * With a spill directory, <code>matrix_cache::set_spill_dir()</code> or
+ * MATRIX_CACHE_DIR, every result put in the cache is also written there
+ * as a matrix file (see matrix_file.h), and a result missing in memory is
+ * looked for there before being computed, the cache survives a restart.
+ * Factorizations are kept in memory only. The directory is never pruned.
+ *
+ * Only the element types of the matrix files are cached, results held in
+ * arena memory and matrices under min_size rows are never cached.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _MATRIX_CACHE_H_
+#define _MATRIX_CACHE_H_
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <typeindex>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#include <unistd.h>
+
+#include "matrix_def.h"
+#include "matrix_file.h"
+#include "matrix_profile.h"
+#include "matrix_storage.h"
+
+template <typename ValueType, typename Allocator>
+class lu_factorization;
+
+namespace matrix_cache
+{
+    /**
+     * Matrices with fewer rows are computed directly, faster than a lookup
+     */
+    constexpr int min_size = 16;
+
+    /**
+     * The cached operations, part of the key
+     */
+    enum class cache_op : std::uint32_t
+    {
+        invert = 1,
+        det = 2,
+        det_recursive = 3,
+        power = 4,
+        lu = 5
+    };
+
+    /**
+     * true for the element types with a matrix file tag
+     */
+    template <typename ValueType, typename = void>
+    struct has_file_type : std::false_type
+    {
+    };
+
+    template <typename ValueType>
+    struct has_file_type<ValueType, std::void_t<decltype(matrix_file_traits<ValueType>::type)>> : std::true_type
+    {
+    };
+
+    /**
+     * Streaming hash of bytes: four 64 bit lanes over stripes of 32 bytes,
+     * the rounds of xxHash64, folded into two words. Fast, not
+     * cryptographic.
+     */
+    class content_hasher
+    {
+    public:
+      content_hasher() : lanes{p1 + p2, p2, 0, 0 - p1} {}
+
+      void update(const void *data, std::size_t size)
+      {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        total += size;
+        if (pending)
+        {
+          const std::size_t n = std::min(size, stripe - pending);
+          std::memcpy(buffer + pending, p, n);
+          pending += n;
+          p += n;
+          size -= n;
+          if (pending < stripe)
+            return;
+          consume(lanes, buffer);
+          pending = 0;
+        }
+        for (; size >= stripe; p += stripe, size -= stripe)
+          consume(lanes, p);
+        std::memcpy(buffer, p, size);
+        pending = size;
+      }
+
+      template <typename T>
+      void update_value(const T &val)
+      {
+        update(&val, sizeof(val));
+      }
+
+      /**
+         * @returns the two words of the hash of the bytes so far
+         */
+      std::pair<std::uint64_t, std::uint64_t> digest() const
+      {
+        std::uint64_t acc[4] = {lanes[0], lanes[1], lanes[2], lanes[3]};
+        if (pending)
+        {
+          // the length mixed in below tells the zero padding apart
+          unsigned char tail[stripe] = {};
+          std::memcpy(tail, buffer, pending);
+          consume(acc, tail);
+        }
+        const std::uint64_t h1 = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+        const std::uint64_t h2 = rotl(acc[0], 29) ^ rotl(acc[1], 37) ^ rotl(acc[2], 43) ^ rotl(acc[3], 53);
+        return {mix(h1 ^ total), mix(h2 + total * p3 + h1)};
+      }
+
+    private:
+      static constexpr std::size_t stripe = 32;
+      static constexpr std::uint64_t p1 = 0x9E3779B185EBCA87ULL;
+      static constexpr std::uint64_t p2 = 0xC2B2AE3D27D4EB4FULL;
+      static constexpr std::uint64_t p3 = 0x165667B19E3779F9ULL;
+
+      static std::uint64_t rotl(std::uint64_t x, int r)
+      {
+        return (x << r) | (x >> (64 - r));
+      }
+
+      static std::uint64_t mix(std::uint64_t h)
+      {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+      }
+
+      static void consume(std::uint64_t *acc, const unsigned char *p)
+      {
+        for (int i = 0; i < 4; i++)
+        {
+          std::uint64_t word;
+          std::memcpy(&word, p + 8 * i, 8);
+          acc[i] = rotl(acc[i] + word * p2, 31) * p1;
+        }
+      }
+
+      std::uint64_t lanes[4];
+      unsigned char buffer[stripe];
+      std::size_t pending = 0;
+      std::uint64_t total = 0;
+    };
+
+    struct cache_key
+    {
+        std::uint64_t hash[2];
+        std::uint32_t op;
+        std::uint32_t type;
+        std::int64_t param;
+
+        bool operator==(const cache_key &key) const
+        {
+            return hash[0] == key.hash[0] && hash[1] == key.hash[1] && op == key.op &&
+                   type == key.type && param == key.param;
+        }
+    };
+
+    struct key_hash
+    {
+        std::size_t operator()(const cache_key &key) const
+        {
+            return static_cast<std::size_t>(key.hash[0] ^ (key.param * 0x9E3779B97F4A7C15ULL) ^ key.op);
+        }
+    };
+
+    /**
+     * @returns the key of op(mat, param), the padding of the rows is
+     *          not part of it
+     */
+    template <typename ValueType, typename Allocator>
+    cache_key make_key(cache_op op, std::int64_t param, const matrix<ValueType, Allocator> &mat)
+    {
+        content_hasher hasher;
+        const std::uint32_t type = static_cast<std::uint32_t>(matrix_file_traits<ValueType>::type);
+        hasher.update_value(type);
+        hasher.update_value(static_cast<std::int64_t>(mat.get_rows()));
+        hasher.update_value(static_cast<std::int64_t>(mat.get_cols()));
+        for (int i = 0; i < mat.get_rows(); i++)
+            hasher.update(mat.data() + static_cast<std::size_t>(i) * mat.get_stride(),
+                          sizeof(ValueType) * mat.get_cols());
+        const auto digest = hasher.digest();
+        return {{digest.first, digest.second}, static_cast<std::uint32_t>(op), type, param};
+    }
+
+    /**
+     * How a result is measured, written to and read from the spill
+     * directory. Only the specializations are cacheable.
+     */
+    template <typename Result, typename = void>
+    struct result_traits
+    {
+        static constexpr bool cacheable = false;
+        static constexpr bool spillable = false;
+    };
+
+    /**
+     * Numbers, the determinants, spilled as 1x1 matrices
+     */
+    template <typename ValueType>
+    struct result_traits<ValueType, std::enable_if_t<has_file_type<ValueType>::value>>
+    {
+        static constexpr bool cacheable = true;
+        static constexpr bool spillable = true;
+
+        static std::size_t bytes(const ValueType &) { return sizeof(ValueType); }
+
+        static void save(const ValueType &val, const std::string &path)
+        {
+            matrix<ValueType> mat(1, 1);
+            mat[0][0] = val;
+            mat.save(path);
+        }
+
+        static ValueType load(const std::string &path)
+        {
+            matrix<ValueType> mat = matrix<ValueType>::load(path);
+            if (mat.get_rows() != 1 || mat.get_cols() != 1)
+                throw std::runtime_error("matrix_cache::load -> not a number");
+            return mat[0][0];
+        }
+    };
+
+    /**
+     * Matrices on the heap, arena matrices must not outlive their scope
+     */
+    template <typename ValueType>
+    struct result_traits<matrix<ValueType, aligned_allocator<ValueType>>,
+                         std::enable_if_t<has_file_type<ValueType>::value>>
+    {
+        static constexpr bool cacheable = true;
+        static constexpr bool spillable = true;
+
+        static std::size_t bytes(const matrix<ValueType> &mat)
+        {
+            return sizeof(ValueType) * mat.get_rows() * mat.get_stride();
+        }
+
+        static void save(const matrix<ValueType> &mat, const std::string &path) { mat.save(path); }
+
+        static matrix<ValueType> load(const std::string &path) { return matrix<ValueType>::load(path); }
+    };
+
+    /**
+     * Factorizations, kept in memory only
+     */
+    template <typename ValueType>
+    struct result_traits<lu_factorization<ValueType, aligned_allocator<ValueType>>,
+                         std::enable_if_t<has_file_type<ValueType>::value>>
+    {
+        static constexpr bool cacheable = true;
+        static constexpr bool spillable = false;
+
+        static std::size_t bytes(const lu_factorization<ValueType, aligned_allocator<ValueType>> &lu)
+        {
+            return sizeof(ValueType) * lu.packed().get_rows() * lu.packed().get_stride() +
+                   sizeof(int) * lu.permutation().size();
+        }
+    };
+
+    struct cache_stats
+    {
+        /**
+         * results found, in memory or in the spill directory
+         */
+        std::uint64_t hits = 0;
+        /**
+         * results read from the spill directory
+         */
+        std::uint64_t disk_hits = 0;
+        /**
+         * results computed
+         */
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+    };
+
+    class result_cache
+    {
+    public:
+      /**
+         * @returns the cache shared by the library
+         */
+      static result_cache &instance()
+      {
+        static result_cache cache;
+        return cache;
+      }
+
+      /**
+         * @returns true if results are looked up and stored
+         */
+      bool enabled() const
+      {
+        return active.load(std::memory_order_relaxed);
+      }
+
+      /**
+         * Sets the bytes of results kept in memory, 0 keeps none
+         */
+      void set_capacity(std::size_t bytes)
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        limit = bytes;
+        evict();
+        update_active();
+      }
+
+      std::size_t capacity()
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        return limit;
+      }
+
+      /**
+         * Sets the spill directory, an empty path turns spilling off
+         * The directory must exist
+         */
+      void set_spill_dir(const std::string &dir)
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        spill = dir;
+        update_active();
+      }
+
+      std::string spill_dir()
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        return spill;
+      }
+
+      /**
+         * Drops the results kept in memory, the spill directory is kept
+         */
+      void clear()
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        lru.clear();
+        index.clear();
+        used = 0;
+      }
+
+      cache_stats stats()
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        cache_stats res = counters;
+        res.entries = index.size();
+        res.bytes = used;
+        return res;
+      }
+
+      void reset_stats()
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        counters = cache_stats();
+      }
+
+      /**
+         * @returns the result of key, from memory or from the spill
+         *          directory, nullptr if it must be computed
+         */
+      template <typename Result>
+      std::shared_ptr<const Result> find(const cache_key &key)
+      {
+        std::string dir;
+        {
+          std::lock_guard<std::mutex> lock(mtx);
+          auto it = index.find(key);
+          if (it != index.end() && it->second->type == typeid(Result))
+          {
+            lru.splice(lru.begin(), lru, it->second);
+            counters.hits++;
+            return std::static_pointer_cast<const Result>(it->second->value);
+          }
+          dir = spill;
+        }
+        if constexpr (result_traits<Result>::spillable)
+        {
+          const std::string path = dir.empty() ? dir : spill_path(dir, key);
+          if (!path.empty() && ::access(path.c_str(), R_OK) == 0)
+          {
+            try
+            {
+              auto res = std::make_shared<const Result>(result_traits<Result>::load(path));
+              std::lock_guard<std::mutex> lock(mtx);
+              counters.hits++;
+              counters.disk_hits++;
+              put(key, res, typeid(Result), result_traits<Result>::bytes(*res));
+              return res;
+            }
+            catch (const std::exception &)
+            {
+              // unreadable, computed and written again
+            }
+          }
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        counters.misses++;
+        return nullptr;
+      }
+
+      /**
+         * Keeps a computed result, and writes it to the spill directory
+         */
+      template <typename Result>
+      void insert(const cache_key &key, const Result &res)
+      {
+        const std::size_t bytes = result_traits<Result>::bytes(res);
+        std::string dir;
+        {
+          std::lock_guard<std::mutex> lock(mtx);
+          dir = spill;
+          if (bytes <= limit)
+            put(key, std::make_shared<const Result>(res), typeid(Result), bytes);
+        }
+        if constexpr (result_traits<Result>::spillable)
+        {
+          if (!dir.empty())
+            write(dir, key, res);
+        }
+      }
+
+    private:
+      struct entry
+      {
+        cache_key key;
+        std::shared_ptr<const void> value;
+        std::type_index type;
+        std::size_t bytes;
+      };
+
+      result_cache() : limit(env_capacity()), spill(env_dir())
+      {
+        update_active();
+      }
+
+      static std::size_t env_capacity()
+      {
+        const char *env = std::getenv("MATRIX_CACHE_BYTES");
+        return env ? std::strtoull(env, nullptr, 10) : 0;
+      }
+
+      static std::string env_dir()
+      {
+        const char *env = std::getenv("MATRIX_CACHE_DIR");
+        return env ? env : "";
+      }
+
+      static std::string spill_path(const std::string &dir, const cache_key &key)
+      {
+        char name[96];
+        std::snprintf(name, sizeof(name), "/%016llx%016llx-%u-%u-%lld.mtx",
+                      static_cast<unsigned long long>(key.hash[0]), static_cast<unsigned long long>(key.hash[1]),
+                      key.op, key.type, static_cast<long long>(key.param));
+        return dir + name;
+      }
+
+      /**
+         * Writes to a temporary file renamed at the end, a reader never
+         * sees a partial file
+         */
+      template <typename Result>
+      void write(const std::string &dir, const cache_key &key, const Result &res)
+      {
+        const std::string path = spill_path(dir, key);
+        const std::string tmp = path + ".tmp" + std::to_string(::getpid()) + "-" +
+                                std::to_string(temp_count.fetch_add(1));
+        try
+        {
+          result_traits<Result>::save(res, tmp);
+          if (std::rename(tmp.c_str(), path.c_str()) != 0)
+            std::remove(tmp.c_str());
+        }
+        catch (const std::exception &)
+        {
+          std::remove(tmp.c_str());
+        }
+      }
+
+      // called with mtx held
+      void put(const cache_key &key, std::shared_ptr<const void> value, std::type_index type, std::size_t bytes)
+      {
+        auto it = index.find(key);
+        if (it != index.end())
+        {
+          used -= it->second->bytes;
+          lru.erase(it->second);
+          index.erase(it);
+        }
+        if (bytes > limit)
+          return;
+        lru.push_front(entry{key, std::move(value), type, bytes});
+        index.emplace(key, lru.begin());
+        used += bytes;
+        evict();
+      }
+
+      // called with mtx held
+      void evict()
+      {
+        while (used > limit)
+        {
+          used -= lru.back().bytes;
+          index.erase(lru.back().key);
+          lru.pop_back();
+          counters.evictions++;
+        }
+      }
+
+      // called with mtx held
+      void update_active()
+      {
+        active.store(limit != 0 || !spill.empty(), std::memory_order_relaxed);
+      }
+
+      std::mutex mtx;
+      std::atomic<bool> active{false};
+      std::atomic<std::uint64_t> temp_count{0};
+      std::size_t limit;
+      std::size_t used = 0;
+      std::string spill;
+      cache_stats counters;
+      std::list<entry> lru;
+      std::unordered_map<cache_key, std::list<entry>::iterator, key_hash> index;
+    };
+
+    /**
+     * @returns compute() or its cached result for op(mat, param)
+     */
+    template <typename Result, typename ValueType, typename Allocator, typename Compute>
+    Result memoize(cache_op op, std::int64_t param, const matrix<ValueType, Allocator> &mat, Compute compute)
+    {
+        if constexpr (has_file_type<ValueType>::value && result_traits<Result>::cacheable)
+        {
+            result_cache &cache = result_cache::instance();
+            if (cache.enabled() && mat.get_rows() >= min_size)
+            {
+                const cache_key key = make_key(op, param, mat);
+                if (auto hit = cache.find<Result>(key))
+                {
+                    MATRIX_PROFILE_CACHE_HIT();
+                    return *hit;
+                }
+                Result res = compute();
+                cache.insert(key, res);
+                return res;
+            }
+        }
+        return compute();
+    }
+
+    /**
+     * Sets the bytes of results kept in memory, 0 keeps none
+     */
+    inline void set_capacity(std::size_t bytes)
+    {
+        result_cache::instance().set_capacity(bytes);
+    }
+
+    inline std::size_t capacity()
+    {
+        return result_cache::instance().capacity();
+    }
+
+    /**
+     * Sets the directory the results are written to, "" for none
+     */
+    inline void set_spill_dir(const std::string &dir)
+    {
+        result_cache::instance().set_spill_dir(dir);
+    }
+
+    inline std::string spill_dir()
+    {
+        return result_cache::instance().spill_dir();
+    }
+
+    /**
+     * @returns the hit and miss counters and the memory in use
+     */
+    inline cache_stats get_stats()
+    {
+        return result_cache::instance().stats();
+    }
+
+    /**
+     * Sets the counters of get_stats() to 0
+     */
+    inline void reset_stats()
+    {
+        result_cache::instance().reset_stats();
+    }
+
+    /**
+     * Drops the results kept in memory
+     */
+    inline void clear()
+    {
+        result_cache::instance().clear();
+    }
+}
+
+#endif // End of the file
@@ -22,12 +22,16 @@
 #define _MAREIX_DEF_H_
 
 #include <vector>
+#include <string>
 #include <utility>
 #include <sstream>
 
+#include "matrix_storage.h"
+#include "matrix_expr.h"
+
 using std::vector;
 
-template <typename ValueType>
+template <typename ValueType, typename Allocator>
 class matrix
 {
 public:
@@ -47,13 +51,20 @@ public:
      * Copy constructor
      * @bigoh O(rows x columns)
      */
-  matrix(const matrix<ValueType> &mat);
+  matrix(const matrix<ValueType, Allocator> &mat);
 
   /**
      * Move constructor
      * @bigoh O(1)
      */
-  matrix(matrix<ValueType> &&mat);
+  matrix(matrix<ValueType, Allocator> &&mat);
+
+  /**
+     * Copies a matrix that uses another allocator
+     * @bigoh O(rows x columns)
+     */
+  template <typename OtherAllocator>
+  explicit matrix(const matrix<ValueType, OtherAllocator> &mat);
 
   /**
      * Initializes a new matrix from a given STL vector of vectors
@@ -66,17 +77,26 @@ public:
      * Initializes a new matrix from a given STL vector of vectors
      * Destroies the given vector
      * @throw length_error if the dimentions are not consistent
-     * @bigoh O(1)
+     * @bigoh O(rows x columns)
      */
   matrix(vector<vector<ValueType>> &&vec);
 
+  /**
+     * Initializes a new matrix by evaluating an element-wise
+     * expression (see matrix_expr.h) in one pass
+     * @throw length_error if the operands dimensions are not the same
+     * @bigoh O(rows x columns)
+     */
+  template <typename Expr>
+  matrix(const matrix_expr<Expr> &expr);
+
   /**
      * Copy assignment constructor
      * @returns Reference to the current object so that it can
      *          be used in further calculations 
      * @bigoh O(rows x columns)
      */
-  matrix<ValueType> &operator=(const matrix<ValueType> &mat);
+  matrix<ValueType, Allocator> &operator=(const matrix<ValueType, Allocator> &mat);
 
   /**
      * Move assignment constructor
@@ -84,7 +104,7 @@ public:
      *          be used in further calculations 
      * @bigoh O(1)
      */
-  matrix<ValueType> &operator=(matrix<ValueType> &&mat);
+  matrix<ValueType, Allocator> &operator=(matrix<ValueType, Allocator> &&mat);
 
   /**
      * Assignment from STL vector of vectors 
@@ -93,7 +113,7 @@ public:
      * @throw length_error if the dimentions are not consistent
      * @bigoh O(rows x columns)
      */
-  matrix<ValueType> &operator=(const vector<vector<ValueType>> &vec);
+  matrix<ValueType, Allocator> &operator=(const vector<vector<ValueType>> &vec);
 
   /**
      * Assignment from STL vector of vectors 
@@ -101,23 +121,32 @@ public:
      * @returns Reference to the current object so that it can
      *          be used in further calculations 
      * @throw length_error if the dimentions are not consistent
-     * @bigoh O(1)
+     * @bigoh O(rows x columns)
+     */
+  matrix<ValueType, Allocator> &operator=(vector<vector<ValueType>> &&vec);
+
+  /**
+     * Assignment from an element-wise expression, evaluated in one pass
+     * directly into the matrix buffer
+     * @returns Reference to the current object
+     * @bigoh O(rows x columns)
      */
-  matrix<ValueType> &operator=(vector<vector<ValueType>> &&vec);
+  template <typename Expr>
+  matrix<ValueType, Allocator> &operator=(const matrix_expr<Expr> &expr);
 
   /**
      * Compares two matrices for equality.
      * The ValueType must have an == operator.
      * @bigoh O(rows x columns)
      */
-  bool operator==(const matrix<ValueType> &mat);
+  bool operator==(const matrix<ValueType, Allocator> &mat);
 
   /**
      * Compares two matrices for inequality.
      * The ValueType must have a != operator.
      * @bigoh O(rows x columns)
      */
-  bool operator!=(const matrix<ValueType> &mat);
+  bool operator!=(const matrix<ValueType, Allocator> &mat);
 
   /**
      * Overloads <code>+=</code> for addition.
@@ -127,7 +156,7 @@ public:
      * @returns Reference to the current object
      * @bigoh   O(rows x columns x additon operation)
      */
-  matrix<ValueType> &operator+=(const matrix<ValueType> &mat);
+  matrix<ValueType, Allocator> &operator+=(const matrix<ValueType, Allocator> &mat);
 
   /**
      * Overloads <code>-=</code> for subtraction.
@@ -137,7 +166,7 @@ public:
      * @returns Reference to the current object
      * @bigoh   O(rows x columns x subtraction operation)
      */
-  matrix<ValueType> &operator-=(const matrix<ValueType> &mat);
+  matrix<ValueType, Allocator> &operator-=(const matrix<ValueType, Allocator> &mat);
 
   /**
      * Overloads <code>*=</code> for scaler multiplication.
@@ -147,7 +176,7 @@ public:
      * @returns Reference to the current object
      * @bigoh   O(rows x columns x multiplication operation)
      */
-  matrix<ValueType> &operator*=(const matrix<ValueType> &mat);
+  matrix<ValueType, Allocator> &operator*=(const matrix<ValueType, Allocator> &mat);
 
   /**
      * Overloads <code>/=</code> for scaler division.
@@ -157,7 +186,26 @@ public:
      * @returns Reference to the current object
      * @bigoh   O(rows x columns x division operation)
      */
-  matrix<ValueType> &operator/=(const matrix<ValueType> &mat);
+  matrix<ValueType, Allocator> &operator/=(const matrix<ValueType, Allocator> &mat);
+
+  /**
+     * Overloads <code>+= -= *= /=</code> for element-wise expressions,
+     * the expression is evaluated in the same pass as the update.
+     * @throw   length_error if the dimensions are not the same 
+     * @returns Reference to the current object
+     * @bigoh   O(rows x columns)
+     */
+  template <typename Expr>
+  matrix<ValueType, Allocator> &operator+=(const matrix_expr<Expr> &expr);
+
+  template <typename Expr>
+  matrix<ValueType, Allocator> &operator-=(const matrix_expr<Expr> &expr);
+
+  template <typename Expr>
+  matrix<ValueType, Allocator> &operator*=(const matrix_expr<Expr> &expr);
+
+  template <typename Expr>
+  matrix<ValueType, Allocator> &operator/=(const matrix_expr<Expr> &expr);
 
   /**
      * Add every item in the matrix to val.
@@ -166,7 +214,7 @@ public:
      * @returns Reference to the current object
      * @bigoh   O(rows x columns x additon operation)
      */
-  matrix<ValueType> &operator+=(const ValueType val);
+  matrix<ValueType, Allocator> &operator+=(const ValueType val);
 
   /**
      * Subtract val from every item in the matrix.
@@ -175,7 +223,7 @@ public:
      * @returns Reference to the current object
      * @bigoh   O(rows x columns x subtraction operation)
      */
-  matrix<ValueType> &operator-=(const ValueType val);
+  matrix<ValueType, Allocator> &operator-=(const ValueType val);
 
   /**
      * Multiply every item in the matrix with val.
@@ -184,7 +232,7 @@ public:
      * @returns Reference to the current object
      * @bigoh   O(rows x columns x multiplication operation)
      */
-  matrix<ValueType> &operator*=(const ValueType val);
+  matrix<ValueType, Allocator> &operator*=(const ValueType val);
 
   /**
      * Divide every item in the matrix on val.
@@ -193,60 +241,101 @@ public:
      * @returns Reference to the current object
      * @bigoh   O(rows x columns x division operation)
      */
-  matrix<ValueType> &operator/=(const ValueType val);
+  matrix<ValueType, Allocator> &operator/=(const ValueType val);
 
   /**
      * Overloads <code>[]</code> to select a row from the matrix.
-     * Selecting an element is handled by the STL vector class
+     * Selecting an element is handled by the <code>matrix_row</code> proxy
      * This extension enables the use of traditional array notation to
      * get or set individual elements.
      * @bigoh O(1)
      */
-  vector<ValueType> &operator[](int rowIndex);
+  matrix_row<ValueType> operator[](int rowIndex);
+
+  /**
+     * Read only version of <code>[]</code>
+     * @bigoh O(1)
+     */
+  matrix_row<const ValueType> operator[](int rowIndex) const;
 
   /**
      * Multiply the two matrices
+     * Uses the cache blocked kernel in matrix_gemm.h
      * @throw   length_error if columns != mat.rows
      * @returns a new matrix results from multiplication
      * @bigoh O(rows x columns x mat.columns)
      */
-  matrix<ValueType> multiply(matrix<ValueType> &mat);
+  matrix<ValueType, Allocator> multiply(const matrix<ValueType, Allocator> &mat);
 
   /**
-     * Matrix inverse
+     * Multiply with a view (a transpose, a block...) without copying it
+     * @throw   length_error if columns != mat.rows
+     * @returns a new matrix results from multiplication
+     * @bigoh O(rows x columns x mat.columns)
+     */
+  template <typename OtherType>
+  matrix<ValueType, Allocator> multiply(const matrix_view<OtherType> &mat);
+
+  /**
+     * Matrix inverse, computed from the LU factorization
+     * or taken from the result cache (see matrix_cache.h)
      * @throw   length_error if columns != rows
      * @throw   out_of_range if determinant = zero
      * @returns a new matrix results from inverting
+     * @bigoh O(rows^3)
      */
-  matrix<ValueType> invert();
+  matrix<ValueType, Allocator> invert();
 
   /**
-     * Matrix transpose
-     * @throw   length_error if columns != mat.rows
+     * LU factorization with partial pivoting of the matrix.
+     * Keep it to answer repeated det / inverse / solve queries
+     * on the same matrix with one factorization.
+     * @throw   length_error if columns != rows
+     * @bigoh O(rows^3)
+     */
+  lu_factorization<ValueType, Allocator> lu();
+
+  /**
+     * Matrix transpose, cache-oblivious blocked copy
      * @returns a new matrix results from transposing
      * @bigoh O(rows x columns)
      */
-  matrix<ValueType> transpose();
+  matrix<ValueType, Allocator> transpose();
+
+  /**
+     * Transposes the matrix without allocating a second one: square
+     * matrices swap tiles, others follow the permutation cycles of the
+     * packed buffer and are left with stride == columns
+     * @returns Reference to the current object
+     * @bigoh O(rows x columns), rows x columns bits of extra memory
+     *        for non-square matrices
+     */
+  matrix<ValueType, Allocator> &transpose_in_place();
 
   /**
-     * Matrix power
+     * Matrix power using exponentiation by squaring, cached
+     * like invert()
+     * n = 0 gives the identity, negative n inverts once then powers
+     * the inverse
      * @throw   length_error if columns != rows
+     * @throw   out_of_range if n < 0 and determinant = zero
      * @returns a new matrix results from powering
-     * @bigoh O(rows^3 x n)
+     * @bigoh O(rows^3 x log(n))
      */
-  matrix<ValueType> power(int n);
+  matrix<ValueType, Allocator> power(int n);
 
   /**
-     * @returns the Determinant of the given matrix using 
-     *          recursive defintion
+     * @returns the Determinant of the given matrix without divisions,
+     *          see determinant_recursive()
      * @throw   length_error if it's not a squre matrix
      */
   ValueType det_recursive();
 
   /**
      * @returns the Determinant of the given matrix using 
-     *          Gaussian elimination algoithm
+     *          the LU factorization
      * @throw   length_error if it's not a squre matrix
+     * @bigoh O(rows^3)
      */
   ValueType det();
 
@@ -255,7 +344,8 @@ public:
      * algorithm to solve system of linear equations 
      * 
      * @param   vec constants vector
-     * 
+     * @throw   length_error if it's not a squre matrix
+     * @throw   out_of_range if determinant = zero
      * @returns vector of the results
      */
   vector<ValueType> back_sub(vector<ValueType> vec);
@@ -266,7 +356,7 @@ public:
      * @returns Reference to the current object
      * @bigoh O(columns)
      */
-  matrix<ValueType> &replace_row(vector<ValueType> vec, int index);
+  matrix<ValueType, Allocator> &replace_row(vector<ValueType> vec, int index);
 
   /**
      * Replace column(index)
@@ -274,7 +364,7 @@ public:
      * @returns Reference to the current object
      * @bigoh O(rows)
      */
-  matrix<ValueType> &replace_col(vector<ValueType> vec, int index);
+  matrix<ValueType, Allocator> &replace_col(vector<ValueType> vec, int index);
 
   /**
      * Adds a new row to the end of the matrix
@@ -282,7 +372,7 @@ public:
      * @returns Reference to the current object
      * @bigoh O(columns)
      */
-  matrix<ValueType> &push_row(const vector<ValueType> &vec);
+  matrix<ValueType, Allocator> &push_row(const vector<ValueType> &vec);
 
   /**
      * Adds a new colum to the end of the matrix
@@ -290,7 +380,7 @@ public:
      * @returns Reference to the current object
      * @bigoh O(rows)
      */
-  matrix<ValueType> &push_col(vector<ValueType> vec);
+  matrix<ValueType, Allocator> &push_col(vector<ValueType> vec);
 
   /**
      * @throw   out_of_range if index out of range
@@ -312,7 +402,7 @@ public:
      * @returns Reference to the current object
      * @bigoh O(columns)
      */
-  matrix<ValueType> &erase_row(int index);
+  matrix<ValueType, Allocator> &erase_row(int index);
 
   /**
      * Erases column(index)
@@ -320,7 +410,7 @@ public:
      * @returns Reference to the current object
      * @bigoh O(rows)
      */
-  matrix<ValueType> &erase_col(int index);
+  matrix<ValueType, Allocator> &erase_col(int index);
 
   /**
      * sawps row1 with row2
@@ -329,7 +419,7 @@ public:
      * @returns Reference to the current object
      * @bigoh O(rows)
      */
-  matrix<ValueType> &swap_rows(int row1, int row2);
+  matrix<ValueType, Allocator> &swap_rows(int row1, int row2);
 
   /**
      * sawps column1 with column2
@@ -338,7 +428,7 @@ public:
      * @returns Reference to the current object
      * @bigoh O(columns)
      */
-  matrix<ValueType> &swap_cols(int col1, int col2);
+  matrix<ValueType, Allocator> &swap_cols(int col1, int col2);
 
   /**
      * Prints the matrix in the standard format to the standard output
@@ -347,7 +437,7 @@ public:
      *   1 1 1
      * @returns Reference to the current object
      */
-  matrix<ValueType> &print_r();
+  matrix<ValueType, Allocator> &print_r();
 
   /**
      * Prints the matrix in the standard format to a given ostream
@@ -356,173 +446,171 @@ public:
      *   1 1 1
      * @returns Reference to the current object
      */
-  matrix<ValueType> &print_r(std::ostream &os);
+  matrix<ValueType, Allocator> &print_r(std::ostream &os);
+
+  /**
+     * Prints a const matrix in the standard format to a given ostream
+     * @returns Reference to the current object
+     */
+  const matrix<ValueType, Allocator> &print_r(std::ostream &os) const;
 
   /**
      * Prints the matrix in format "[1 1; 1 1]" to the standard output
      * @returns Reference to the current object
      */
-  matrix<ValueType> &print_l();
+  matrix<ValueType, Allocator> &print_l();
 
   /**
      * Prints the matrix in format "[1 1; 1 1]" to a given ostream
      * @returns Reference to the current object
      */
-  matrix<ValueType> &print_l(std::ostream &os);
+  matrix<ValueType, Allocator> &print_l(std::ostream &os);
+
+  /**
+     * Prints a const matrix in format "[1 1; 1 1]" to a given ostream
+     * @returns Reference to the current object
+     */
+  const matrix<ValueType, Allocator> &print_l(std::ostream &os) const;
+
+  /**
+     * Writes the matrix to a binary matrix file (see matrix_file.h),
+     * the buffer is written in one block
+     * @throw runtime_error if the file can't be written
+     * @bigoh O(rows x columns)
+     */
+  void save(const std::string &path) const;
+
+  /**
+     * Writes the matrix file bytes to a binary stream, the header and
+     * then the buffer, without flushing it
+     * @bigoh O(rows x columns)
+     */
+  void save(std::ostream &os) const;
+
+  /**
+     * Reads a binary matrix file saved with the same element type,
+     * use mapped_matrix to read it without copying
+     * @throw runtime_error if the file can't be read or is not
+     *        a valid file of ValueType elements
+     * @returns the loaded matrix
+     * @bigoh O(rows x columns)
+     */
+  static matrix<ValueType, Allocator> load(const std::string &path);
 
   /**
      * Resizes the matrix to an new dimenions row x column
      * Doesn't guarantee the matrix data still valid
      * @returns Reference to the new object
      */
-  matrix<ValueType> &resize(int row, int col);
+  matrix<ValueType, Allocator> &resize(int row, int col);
 
   /**
      * @returns the dimensions in pair <rows, columns>
      * @bigoh O(1)
      */
-  std::pair<int, int> get_dim();
+  std::pair<int, int> get_dim() const;
 
   /**
      * @returns the number of rows
      * @bigoh O(1)
      */
-  int get_rows();
+  int get_rows() const;
 
   /**
      * @returns the number of columns
      * @bigoh O(1)
      */
-  int get_cols();
-
-  /**************************************************************************
-     *************  Static and friend functions and operators  **************
-     ************************************************************************/
-
-  /**
-     * @static  function can used to check if a certain vector 
-     *          can be valid as a matrix.
-     * @returns pair<rows, columns> if the matrix is valid
-     *          pair<-1, -1> if the matrix is not valid
-     * @bigoh   O(rows x columns)
-     */
-  static std::pair<int, int> check_dim(const vector<vector<ValueType>> &vec);
+  int get_cols() const;
 
   /**
-     * Overloads <code>+</code> for addition.
-     * Very useful in mathematical operation.
-     * The ValueType must have a += operator.
-     * @throw   length_error if the dimensions are not the same 
-     * @returns a new matrix results from additon
-     * @bigoh   O(rows x columns x additon operation)
+     * @returns the leading dimension, the distance in elements between
+     *          the beginnings of two consecutive rows (>= columns)
+     * @bigoh O(1)
      */
-  template <typename T>
-  friend matrix<T> operator+(matrix<T> m1, const matrix<T> &m2);
+  int get_stride() const;
 
   /**
-     * Overloads <code>-</code> for subtraction.
-     * Very useful in mathematical operation.
-     * The ValueType must have a -= operator.
-     * @throw   length_error if the dimensions are not the same 
-     * @returns a new matrix results from subtraction
-     * @bigoh   O(rows x columns x subtraction operation)
+     * @returns pointer to the first element of the contiguous, 64-byte
+     *          aligned, row-major buffer. Element (i, j) is at
+     *          data()[i * get_stride() + j]
+     * @bigoh O(1)
      */
-  template <typename T>
-  friend matrix<T> operator-(matrix<T> m1, const matrix<T> &m2);
+  ValueType *data();
 
   /**
-     * Overloads <code>*</code> for scaler multiplication.
-     * Very useful in mathematical operation.
-     * The ValueType must have a *= operator.
-     * @throw   length_error if the dimensions are not the same 
-     * @returns a new matrix results from multiplication
-     * @bigoh   O(rows x columns x multiplication operation)
+     * Read only version of <code>data()</code>
+     * @bigoh O(1)
      */
-  template <typename T>
-  friend matrix<T> operator*(matrix<T> m1, const matrix<T> &m2);
+  const ValueType *data() const;
 
   /**
-     * Overloads <code>/</code> for scaler division.
-     * Very useful in mathematical operations.
-     * The ValueType must have a /= operator.
-     * @throw   length_error if the dimensions are not the same 
-     * @returns a new matrix results from division
-     * @bigoh   O(rows x columns x division operation)
+     * @returns a view of the whole matrix, use its row, col, block,
+     *          minor and transpose to reference parts of the matrix
+     *          without copying them
+     * @bigoh O(1)
      */
-  template <typename T>
-  friend matrix<T> operator/(matrix<T> m1, const matrix<T> &m2);
+  matrix_view<ValueType> view();
 
   /**
-     * Add every item in the matrix to val.
-     * Very useful in mathematical operations.
-     * The ValueType must have a += operator.
-     * @returns a new matrix results from additon
-     * @bigoh   O(rows x columns x additon operation)
+     * Read only version of <code>view()</code>
+     * @bigoh O(1)
      */
-  template <typename T>
-  friend matrix<T> operator+(matrix<T> m1, const T val);
+  matrix_view<const ValueType> view() const;
 
-  /**
-     * Subtract val from every item in the matrix.
-     * Very useful in mathematical operations.
-     * The ValueType must have a -= operator.
-     * @returns a new matrix results from subtraction
-     * @bigoh   O(rows x columns x subtraction operation)
-     */
-  template <typename T>
-  friend matrix<T> operator-(matrix<T> m1, const T val);
+  /**************************************************************************
+     *************  Static and friend functions and operators  **************
+     ************************************************************************/
 
   /**
-     * Multiply every item in the matrix with val.
-     * Very useful in mathematical operations.
-     * The ValueType must have a *= operator.
-     * @returns a new matrix results from multiplication
-     * @bigoh   O(rows x columns x multiplication operation)
+     * @static  function can used to check if a certain vector 
+     *          can be valid as a matrix.
+     * @returns pair<rows, columns> if the matrix is valid
+     *          pair<-1, -1> if the matrix is not valid
+     * @bigoh   O(rows x columns)
      */
-  template <typename T>
-  friend matrix<T> operator*(matrix<T> m1, const T val);
+  static std::pair<int, int> check_dim(const vector<vector<ValueType>> &vec);
 
-  /**
-     * Divide every item in the matrix on val.
-     * Very useful in mathematical operation.
-     * The ValueType must have a /= operator.
-     * @returns a new matrix results from division
-     * @bigoh   O(rows x columns x division operation)
+  /*
+     * The element-wise operators + - * / between matrices, and between
+     * a matrix and a scalar, are expression templates declared in
+     * matrix_expr.h
      */
-  template <typename T>
-  friend matrix<T> operator/(matrix<T> m1, const T val);
 
   /**
      * Overloads << operator to print the matrix in the standard format
      * as a native type.
      */
-  template <typename T>
-  friend std::ostream &operator<<(std::ostream &os, const matrix<T> &mat);
+  template <typename T, typename A>
+  friend std::ostream &operator<<(std::ostream &os, const matrix<T, A> &mat);
 
   /**
-     * @returns the Determinant of the given matrix using 
-     *          recursive defintion
+     * @returns the Determinant of the given matrix using only + - and *
+     *          (closed forms up to 4x4, cofactor expansion over column
+     *          subsets up to 16x16, Berkowitz algorithm above). Larger
+     *          floating point matrices use the LU factorization.
      * @throw   length_error if it's not a squre matrix
+     * @bigoh   O(1) up to 4x4, O(2^rows x rows) up to 16x16, O(rows^4)
      */
-  template <typename T>
-  friend T determinant_recursive(matrix<T> mat);
+  template <typename T, typename A>
+  friend T determinant_recursive(const matrix<T, A> &mat);
 
   /**
      * @returns the Determinant of the given matrix using 
-     *          Gaussian elimination algoithm
+     *          the LU factorization
      * @throw   length_error if it's not a squre matrix
      */
-  template <typename T>
-  friend T determinant(matrix<T> mat);
+  template <typename T, typename A>
+  friend T determinant(matrix<T, A> mat);
 
   /**
      * @helper  function used to get submatrices used in determinant 
      *          calculations.
      * @returns matrix with dimensions <rows-1, columns-1>
      *          the specified row and col are erasrd
+     *          use view().minor(row, col) to avoid the copy
      */
-  template <typename T>
-  friend matrix<T> sub_matrix(matrix<T> mat, int row, int col);
+  template <typename T, typename A>
+  friend matrix<T, A> sub_matrix(const matrix<T, A> &mat, int row, int col);
 
   /**
      * function used to perform Back Substitution (Gaussian Elimination) 
@@ -530,16 +618,38 @@ public:
      * 
      * @param   mat coefficient matrix
      * @param   vec constants vector
-     * 
+     * @throw   out_of_range if determinant = zero
      * @returns vector of the results
      */
-  template <typename T>
-  friend vector<T> back_substitution(matrix<T> mat, vector<T> vec);
+  template <typename T, typename A>
+  friend vector<T> back_substitution(matrix<T, A> mat, vector<T> vec);
 
 private:
+  /**
+     * Evaluates expr element by element into the matrix buffer with
+     * assign(element, value), splitting the rows between threads
+     * @throw length_error if the dimensions are not the same
+     */
+  template <typename Expr, typename Assign>
+  void eval_expr(const Expr &expr, Assign assign, const char *name);
+
+  /**
+     * res = a x b, res must already have the dimensions of the result
+     * and must not be a or b. Reuses the buffer of res.
+     */
+  static void multiply_into(const matrix<ValueType, Allocator> &a, const matrix<ValueType, Allocator> &b,
+                            matrix<ValueType, Allocator> &res);
+
+  /**
+     * Moves the elements to a new buffer with the given dimensions and
+     * stride, keeping the overlapping part and zeroing the rest
+     */
+  void relayout(int row, int col, int new_stride);
+
   int rows;
   int cols;
-  vector<vector<ValueType>> elements;
+  int stride;
+  vector<ValueType, Allocator> elements;
 };
 
 #endif
@@ -0,0 +1,354 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_expr.h
+ * @brief
+ *
+ * This file provides the expression templates behind the element-wise
+ * operators of the <code>matrix</code> class. <code>+ - * /</code> between
+ * matrices (or a matrix and a scalar) don't compute anything, they return
+ * a lightweight node describing the operation. The whole tree is evaluated
+ * in one fused loop when it is assigned to a matrix, so an expression like
+ * <code>A + B * 2 - C</code> makes a single pass over memory and creates
+ * no temporary matrices.
+ *
+ * Matrix views (matrix_view.h) are leaves too. When an expression reads
+ * the destination through a view with another layout (a transpose for
+ * example) it is evaluated into a temporary before being assigned.
+ *
+ * Nodes keep references to the matrices they were built from, so an
+ * expression must be assigned to a matrix (or evaluated with eval())
+ * before its operands go out of scope. Avoid storing them in
+ * <code>auto</code> variables.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _MATRIX_EXPR_H_
+#define _MATRIX_EXPR_H_
+
+#include <string>
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "matrix_storage.h"
+
+/**
+ * Base class of every matrix expression node
+ */
+template <typename Derived>
+class matrix_expr
+{
+public:
+  const Derived &derived() const
+  {
+    return static_cast<const Derived &>(*this);
+  }
+
+  /**
+     * Evaluates the expression into a new matrix
+     * @bigoh O(rows x columns)
+     */
+  auto eval() const
+  {
+    return matrix<typename Derived::value_type>(*this);
+  }
+};
+
+/**
+ * Leaf of an expression, reads the elements of a matrix
+ */
+template <typename ValueType>
+class matrix_leaf : public matrix_expr<matrix_leaf<ValueType>>
+{
+public:
+  using value_type = ValueType;
+
+  template <typename Allocator>
+  explicit matrix_leaf(const matrix<ValueType, Allocator> &mat)
+      : ptr(mat.data()), rows(mat.get_rows()), cols(mat.get_cols()), stride(mat.get_stride())
+  {
+  }
+
+  int get_rows() const { return rows; }
+
+  int get_cols() const { return cols; }
+
+  ValueType coeff(int i, int j) const
+  {
+    return ptr[static_cast<std::size_t>(i) * stride + j];
+  }
+
+  /**
+     * @returns true if evaluating into dst may overwrite elements
+     *          before they are read, see matrix_view::conflicts_with
+     */
+  template <typename View>
+  bool aliases(const View &dst) const
+  {
+    return dst.conflicts_with({ptr, rows, cols, stride});
+  }
+
+private:
+  const ValueType *ptr;
+  int rows;
+  int cols;
+  int stride;
+};
+
+/**
+ * Element-wise operations of the nodes, name is used in error messages
+ */
+struct matrix_add_op
+{
+  static constexpr const char *name = "matrix::addition";
+  template <typename T>
+  static T apply(const T &a, const T &b) { return a + b; }
+};
+
+struct matrix_sub_op
+{
+  static constexpr const char *name = "matrix::subtraction";
+  template <typename T>
+  static T apply(const T &a, const T &b) { return a - b; }
+};
+
+struct matrix_mul_op
+{
+  static constexpr const char *name = "matrix::scalar_multiplication";
+  template <typename T>
+  static T apply(const T &a, const T &b) { return a * b; }
+};
+
+struct matrix_div_op
+{
+  static constexpr const char *name = "matrix::divsion";
+  template <typename T>
+  static T apply(const T &a, const T &b) { return a / b; }
+};
+
+/**
+ * Node combining two expressions of the same dimensions element by element
+ */
+template <typename Op, typename Lhs, typename Rhs>
+class matrix_binary_expr : public matrix_expr<matrix_binary_expr<Op, Lhs, Rhs>>
+{
+public:
+  using value_type = typename Lhs::value_type;
+
+  /**
+     * @throw length_error if the dimensions are not the same
+     */
+  matrix_binary_expr(const Lhs &l, const Rhs &r) : lhs(l), rhs(r)
+  {
+    if (lhs.get_rows() != rhs.get_rows() || lhs.get_cols() != rhs.get_cols())
+      throw std::length_error(std::string(Op::name) + " -> Matrices dimentions must be the same");
+  }
+
+  int get_rows() const { return lhs.get_rows(); }
+
+  int get_cols() const { return lhs.get_cols(); }
+
+  value_type coeff(int i, int j) const
+  {
+    return Op::apply(lhs.coeff(i, j), rhs.coeff(i, j));
+  }
+
+  template <typename View>
+  bool aliases(const View &dst) const
+  {
+    return lhs.aliases(dst) || rhs.aliases(dst);
+  }
+
+private:
+  Lhs lhs;
+  Rhs rhs;
+};
+
+/**
+ * Node combining every element of an expression with a scalar
+ */
+template <typename Op, typename Expr>
+class matrix_scalar_expr : public matrix_expr<matrix_scalar_expr<Op, Expr>>
+{
+public:
+  using value_type = typename Expr::value_type;
+
+  matrix_scalar_expr(const Expr &e, const value_type &v) : expr(e), val(v) {}
+
+  int get_rows() const { return expr.get_rows(); }
+
+  int get_cols() const { return expr.get_cols(); }
+
+  value_type coeff(int i, int j) const
+  {
+    return Op::apply(expr.coeff(i, j), val);
+  }
+
+  template <typename View>
+  bool aliases(const View &dst) const
+  {
+    return expr.aliases(dst);
+  }
+
+private:
+  Expr expr;
+  value_type val;
+};
+
+/**
+ * Tells whether a type can be an operand of the element-wise operators
+ * and how to turn it into an expression node: matrices become leaves,
+ * expression nodes are used as they are.
+ */
+template <typename T, typename = void>
+struct matrix_operand : std::false_type
+{
+};
+
+template <typename ValueType, typename Allocator>
+struct matrix_operand<matrix<ValueType, Allocator>> : std::true_type
+{
+  using type = matrix_leaf<ValueType>;
+  using value_type = ValueType;
+  static type wrap(const matrix<ValueType, Allocator> &mat) { return type(mat); }
+};
+
+template <typename Expr>
+struct matrix_operand<Expr, typename std::enable_if<std::is_base_of<matrix_expr<Expr>, Expr>::value>::type>
+    : std::true_type
+{
+  using type = Expr;
+  using value_type = typename Expr::value_type;
+  static const type &wrap(const Expr &expr) { return expr; }
+};
+
+template <typename Lhs, typename Rhs>
+using enable_if_matrix_operands = typename std::enable_if<
+    matrix_operand<Lhs>::value && matrix_operand<Rhs>::value>::type;
+
+template <typename Op, typename Lhs, typename Rhs>
+inline matrix_binary_expr<Op, typename matrix_operand<Lhs>::type, typename matrix_operand<Rhs>::type>
+make_matrix_expr(const Lhs &lhs, const Rhs &rhs)
+{
+    return {matrix_operand<Lhs>::wrap(lhs), matrix_operand<Rhs>::wrap(rhs)};
+}
+
+template <typename Op, typename Lhs>
+inline matrix_scalar_expr<Op, typename matrix_operand<Lhs>::type>
+make_matrix_scalar_expr(const Lhs &lhs, const typename matrix_operand<Lhs>::value_type &val)
+{
+    return {matrix_operand<Lhs>::wrap(lhs), val};
+}
+
+/**
+ * Overloads <code>+</code> for addition.
+ * The ValueType must have a + operator.
+ * @throw   length_error if the dimensions are not the same
+ * @returns an expression of the addition
+ * @bigoh   O(1), O(rows x columns) when evaluated
+ */
+template <typename Lhs, typename Rhs, typename = enable_if_matrix_operands<Lhs, Rhs>>
+inline auto operator+(const Lhs &lhs, const Rhs &rhs)
+{
+    return make_matrix_expr<matrix_add_op>(lhs, rhs);
+}
+
+/**
+ * Overloads <code>-</code> for subtraction.
+ * The ValueType must have a - operator.
+ * @throw   length_error if the dimensions are not the same
+ * @returns an expression of the subtraction
+ * @bigoh   O(1), O(rows x columns) when evaluated
+ */
+template <typename Lhs, typename Rhs, typename = enable_if_matrix_operands<Lhs, Rhs>>
+inline auto operator-(const Lhs &lhs, const Rhs &rhs)
+{
+    return make_matrix_expr<matrix_sub_op>(lhs, rhs);
+}
+
+/**
+ * Overloads <code>*</code> for scaler (element-wise) multiplication.
+ * The ValueType must have a * operator.
+ * @throw   length_error if the dimensions are not the same
+ * @returns an expression of the multiplication
+ * @bigoh   O(1), O(rows x columns) when evaluated
+ */
+template <typename Lhs, typename Rhs, typename = enable_if_matrix_operands<Lhs, Rhs>>
+inline auto operator*(const Lhs &lhs, const Rhs &rhs)
+{
+    return make_matrix_expr<matrix_mul_op>(lhs, rhs);
+}
+
+/**
+ * Overloads <code>/</code> for scaler (element-wise) division.
+ * The ValueType must have a / operator.
+ * @throw   length_error if the dimensions are not the same
+ * @returns an expression of the division
+ * @bigoh   O(1), O(rows x columns) when evaluated
+ */
+template <typename Lhs, typename Rhs, typename = enable_if_matrix_operands<Lhs, Rhs>>
+inline auto operator/(const Lhs &lhs, const Rhs &rhs)
+{
+    return make_matrix_expr<matrix_div_op>(lhs, rhs);
+}
+
+/**
+ * Add val to every item of the matrix expression
+ * @returns an expression of the addition
+ */
+template <typename Lhs, typename = typename std::enable_if<matrix_operand<Lhs>::value>::type>
+inline auto operator+(const Lhs &lhs, const typename matrix_operand<Lhs>::value_type &val)
+{
+    return make_matrix_scalar_expr<matrix_add_op>(lhs, val);
+}
+
+/**
+ * Subtract val from every item of the matrix expression
+ * @returns an expression of the subtraction
+ */
+template <typename Lhs, typename = typename std::enable_if<matrix_operand<Lhs>::value>::type>
+inline auto operator-(const Lhs &lhs, const typename matrix_operand<Lhs>::value_type &val)
+{
+    return make_matrix_scalar_expr<matrix_sub_op>(lhs, val);
+}
+
+/**
+ * Multiply every item of the matrix expression with val
+ * @returns an expression of the multiplication
+ */
+template <typename Lhs, typename = typename std::enable_if<matrix_operand<Lhs>::value>::type>
+inline auto operator*(const Lhs &lhs, const typename matrix_operand<Lhs>::value_type &val)
+{
+    return make_matrix_scalar_expr<matrix_mul_op>(lhs, val);
+}
+
+/**
+ * Divide every item of the matrix expression on val
+ * @returns an expression of the division
+ */
+template <typename Lhs, typename = typename std::enable_if<matrix_operand<Lhs>::value>::type>
+inline auto operator/(const Lhs &lhs, const typename matrix_operand<Lhs>::value_type &val)
+{
+    return make_matrix_scalar_expr<matrix_div_op>(lhs, val);
+}
+
+/**
+ * Overloads << operator to print an expression in the standard format
+ */
+template <typename Derived>
+std::ostream &operator<<(std::ostream &os, const matrix_expr<Derived> &expr)
+{
+    return os << expr.eval();
+}
+
+#endif // End of the file
@@ -0,0 +1,447 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_file.h
+ * @brief
+ *
+ * This file provides the binary matrix file format, read and written by
+ * <code>matrix::load</code> and <code>matrix::save</code>, and the
+ * <code>mapped_matrix</code> class that maps a file in memory and reads
+ * the elements where they are, without copying them.
+ *
+ * A file is a 64 bytes header followed by the payload:
+ *
+ *     offset  size  field
+ *          0     8  magic         "MTRXBIN\0"
+ *          8     4  byte_order    0x01020304, written in the byte order
+ *                                 of the host that saved the file
+ *         12     4  version       1
+ *         16     4  type          matrix_file_type of the elements
+ *         20     4  element_size  sizeof an element in bytes
+ *         24     4  layout        0 row-major, 1 column-major
+ *         28     4  reserved      0
+ *         32     8  rows
+ *         40     8  cols
+ *         48     8  stride        elements between the beginnings of two
+ *                                 rows (two columns if column-major)
+ *         56     8  offset        position of the payload in the file,
+ *                                 a multiple of 64
+ *
+ * The payload is rows x stride elements (cols x stride if column-major)
+ * in the native representation of the element type, the stride padding
+ * included. A matrix is saved row-major with its own stride, so saving
+ * and loading copies the buffer in one block and a mapped file is laid
+ * out like a matrix in memory, aligned the same way. Column-major files
+ * written by other tools are read through a transposed view.
+ *
+ * The integers of the header and the elements are in the byte order of
+ * the host, a file saved on a host of the other order is rejected.
+ *
+ * save(std::ostream&) writes the same bytes to a stream, records written
+ * one after the other make the compact binary output of the calculator.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _MATRIX_FILE_H_
+#define _MATRIX_FILE_H_
+
+#include <string>
+#include <limits>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <fstream>
+#include <utility>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "matrix_def.h"
+#include "matrix_view.h"
+
+/**
+ * Element type tags of the file format
+ */
+enum class matrix_file_type : std::uint32_t
+{
+    float32 = 1,
+    float64 = 2,
+    complex64 = 3,
+    complex128 = 4,
+    int32 = 5,
+    int64 = 6
+};
+
+/**
+ * Maps an element type to its tag, only these types can be saved
+ */
+template <typename ValueType>
+struct matrix_file_traits;
+
+template <>
+struct matrix_file_traits<float>
+{
+    static constexpr matrix_file_type type = matrix_file_type::float32;
+};
+
+template <>
+struct matrix_file_traits<double>
+{
+    static constexpr matrix_file_type type = matrix_file_type::float64;
+};
+
+template <>
+struct matrix_file_traits<std::complex<float>>
+{
+    static constexpr matrix_file_type type = matrix_file_type::complex64;
+};
+
+template <>
+struct matrix_file_traits<std::complex<double>>
+{
+    static constexpr matrix_file_type type = matrix_file_type::complex128;
+};
+
+template <>
+struct matrix_file_traits<std::int32_t>
+{
+    static constexpr matrix_file_type type = matrix_file_type::int32;
+};
+
+template <>
+struct matrix_file_traits<std::int64_t>
+{
+    static constexpr matrix_file_type type = matrix_file_type::int64;
+};
+
+/**
+ * The header at the beginning of a matrix file
+ */
+struct matrix_file_header
+{
+    char magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+    std::uint32_t type;
+    std::uint32_t element_size;
+    std::uint32_t layout;
+    std::uint32_t reserved;
+    std::uint64_t rows;
+    std::uint64_t cols;
+    std::uint64_t stride;
+    std::uint64_t offset;
+};
+
+static_assert(sizeof(matrix_file_header) == 64, "matrix_file_header must be 64 bytes");
+
+namespace matrix_io
+{
+    constexpr char file_magic[8] = {'M', 'T', 'R', 'X', 'B', 'I', 'N', '\0'};
+    constexpr std::uint32_t file_byte_order = 0x01020304;
+    constexpr std::uint32_t file_version = 1;
+    constexpr std::uint32_t row_major = 0;
+    constexpr std::uint32_t column_major = 1;
+
+    /**
+     * @returns the header of a row-major (rows x cols) payload
+     */
+    template <typename ValueType>
+    matrix_file_header make_header(int rows, int cols, int stride)
+    {
+        matrix_file_header header = {};
+        std::memcpy(header.magic, file_magic, sizeof(file_magic));
+        header.byte_order = file_byte_order;
+        header.version = file_version;
+        header.type = static_cast<std::uint32_t>(matrix_file_traits<ValueType>::type);
+        header.element_size = sizeof(ValueType);
+        header.layout = row_major;
+        header.rows = rows;
+        header.cols = cols;
+        header.stride = stride;
+        header.offset = sizeof(matrix_file_header);
+        return header;
+    }
+
+    /**
+     * Checks the header describes a payload of ValueType that fits in
+     * a file of file_size bytes
+     * @throw runtime_error naming the function if it doesn't
+     */
+    template <typename ValueType>
+    void check_header(const matrix_file_header &header, std::uint64_t file_size, const std::string &name)
+    {
+        constexpr std::uint64_t max_dim = std::numeric_limits<int>::max();
+        if (std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0)
+            throw std::runtime_error(name + " -> not a matrix file");
+        if (header.byte_order != file_byte_order)
+            throw std::runtime_error(name + " -> the file was saved with another byte order");
+        if (header.version != file_version)
+            throw std::runtime_error(name + " -> unsupported file version");
+        if (header.type != static_cast<std::uint32_t>(matrix_file_traits<ValueType>::type) ||
+            header.element_size != sizeof(ValueType))
+            throw std::runtime_error(name + " -> the file holds another element type");
+        if (header.layout != row_major && header.layout != column_major)
+            throw std::runtime_error(name + " -> unknown layout");
+
+        const std::uint64_t outer = header.layout == row_major ? header.rows : header.cols;
+        const std::uint64_t inner = header.layout == row_major ? header.cols : header.rows;
+        if (header.rows > max_dim || header.cols > max_dim || header.stride > max_dim || header.stride < inner)
+            throw std::runtime_error(name + " -> invalid dimensions");
+        if (header.offset < sizeof(matrix_file_header) || header.offset % matrix_alignment || header.offset > file_size)
+            throw std::runtime_error(name + " -> invalid payload offset");
+        if (outer && header.stride > (file_size - header.offset) / sizeof(ValueType) / outer)
+            throw std::runtime_error(name + " -> the file is truncated");
+    }
+
+    /**
+     * Reads and checks the header of an open file
+     * @returns the header, the stream is left at the payload
+     */
+    template <typename ValueType>
+    matrix_file_header read_header(std::ifstream &in, const std::string &name)
+    {
+        in.seekg(0, std::ios::end);
+        const std::uint64_t file_size = static_cast<std::uint64_t>(in.tellg());
+        in.seekg(0);
+        matrix_file_header header;
+        if (file_size < sizeof(header) || !in.read(reinterpret_cast<char *>(&header), sizeof(header)))
+            throw std::runtime_error(name + " -> not a matrix file");
+        check_header<ValueType>(header, file_size, name);
+        in.seekg(header.offset);
+        return header;
+    }
+} // namespace matrix_io
+
+template <typename ValueType, typename Allocator>
+void matrix<ValueType, Allocator>::save(std::ostream &os) const
+{
+    const matrix_file_header header = matrix_io::make_header<ValueType>(rows, cols, stride);
+    os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char *>(data()), static_cast<std::streamsize>(rows) * stride * sizeof(ValueType));
+}
+
+template <typename ValueType, typename Allocator>
+void matrix<ValueType, Allocator>::save(const std::string &path) const
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw std::runtime_error("matrix::save -> cannot open " + path);
+    save(out);
+    if (!out.flush())
+        throw std::runtime_error("matrix::save -> cannot write " + path);
+}
+
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> matrix<ValueType, Allocator>::load(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("matrix::load -> cannot open " + path);
+    const matrix_file_header header = matrix_io::read_header<ValueType>(in, "matrix::load");
+
+    // a column-major file is read as its transpose, then transposed back,
+    // in place if square, into a new matrix with padded rows otherwise
+    const bool by_rows = header.layout == matrix_io::row_major;
+    const int outer = static_cast<int>(by_rows ? header.rows : header.cols);
+    const int inner = static_cast<int>(by_rows ? header.cols : header.rows);
+    const int file_stride = static_cast<int>(header.stride);
+    matrix res(outer, inner);
+    if (file_stride == res.stride)
+    {
+        in.read(reinterpret_cast<char *>(res.data()),
+                static_cast<std::streamsize>(outer) * file_stride * sizeof(ValueType));
+    }
+    else
+    {
+        for (int i = 0; i < outer && in; i++)
+        {
+            in.seekg(header.offset + static_cast<std::uint64_t>(i) * file_stride * sizeof(ValueType));
+            in.read(reinterpret_cast<char *>(res[i].data()), static_cast<std::streamsize>(inner) * sizeof(ValueType));
+        }
+    }
+    if (!in)
+        throw std::runtime_error("matrix::load -> cannot read " + path);
+    if (!by_rows && outer == inner)
+        res.transpose_in_place();
+    else if (!by_rows)
+        res = res.transpose();
+    return res;
+}
+
+/**
+ * Read only matrix backed by a mapped matrix file, the elements are
+ * read from the page cache where they are, nothing is copied. Use view()
+ * to compute with it, or copy it into a matrix with to_matrix().
+ *
+ * The mapping is private: the file can't be changed through it, and
+ * changing the file while it is mapped is not supported.
+ */
+template <typename ValueType>
+class mapped_matrix
+{
+public:
+  /**
+     * Maps the matrix file at path
+     * @throw runtime_error if the file can't be mapped or is not
+     *        a valid file of ValueType elements
+     * @bigoh O(1), the pages are read on first access
+     */
+  explicit mapped_matrix(const std::string &path);
+
+  mapped_matrix(mapped_matrix &&mat) noexcept;
+
+  mapped_matrix &operator=(mapped_matrix &&mat) noexcept;
+
+  mapped_matrix(const mapped_matrix &) = delete;
+
+  mapped_matrix &operator=(const mapped_matrix &) = delete;
+
+  ~mapped_matrix();
+
+  /**
+     * @returns element (i, j), no bounds checking
+     */
+  ValueType operator()(int i, int j) const { return view()(i, j); }
+
+  /**
+     * @returns a read only view of the mapped elements, valid
+     *          as long as the mapped_matrix lives
+     * @bigoh O(1)
+     */
+  matrix_view<const ValueType> view() const
+  {
+    return matrix_view<const ValueType>(ptr, rows, cols, row_stride, col_stride);
+  }
+
+  /**
+     * @returns a copy of the mapped matrix
+     * @bigoh O(rows x columns)
+     */
+  matrix<ValueType> to_matrix() const { return matrix<ValueType>(view()); }
+
+  int get_rows() const { return rows; }
+
+  int get_cols() const { return cols; }
+
+  /**
+     * @returns true if the file is row-major, the view of a
+     *          column-major file is a transposed view
+     */
+  bool is_row_major() const { return col_stride == 1; }
+
+private:
+  void unmap() noexcept;
+
+  void *base = nullptr;
+  std::size_t length = 0;
+  const ValueType *ptr = nullptr;
+  int rows = 0;
+  int cols = 0;
+  int row_stride = 0;
+  int col_stride = 1;
+};
+
+template <typename ValueType>
+mapped_matrix<ValueType>::mapped_matrix(const std::string &path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("mapped_matrix -> cannot open " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<std::uint64_t>(st.st_size) < sizeof(matrix_file_header))
+    {
+        ::close(fd);
+        throw std::runtime_error("mapped_matrix -> not a matrix file");
+    }
+    length = static_cast<std::size_t>(st.st_size);
+    base = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+    {
+        base = nullptr;
+        throw std::runtime_error("mapped_matrix -> cannot map " + path);
+    }
+
+    matrix_file_header header;
+    std::memcpy(&header, base, sizeof(header));
+    try
+    {
+        matrix_io::check_header<ValueType>(header, length, "mapped_matrix");
+    }
+    catch (...)
+    {
+        unmap();
+        throw;
+    }
+    ptr = reinterpret_cast<const ValueType *>(static_cast<const char *>(base) + header.offset);
+    rows = static_cast<int>(header.rows);
+    cols = static_cast<int>(header.cols);
+    if (header.layout == matrix_io::row_major)
+    {
+        row_stride = static_cast<int>(header.stride);
+        col_stride = 1;
+    }
+    else
+    {
+        row_stride = 1;
+        col_stride = static_cast<int>(header.stride);
+    }
+}
+
+template <typename ValueType>
+mapped_matrix<ValueType>::mapped_matrix(mapped_matrix &&mat) noexcept
+    : base(mat.base), length(mat.length), ptr(mat.ptr), rows(mat.rows), cols(mat.cols),
+      row_stride(mat.row_stride), col_stride(mat.col_stride)
+{
+    mat.base = nullptr;
+    mat.ptr = nullptr;
+    mat.rows = mat.cols = mat.row_stride = 0;
+}
+
+template <typename ValueType>
+mapped_matrix<ValueType> &mapped_matrix<ValueType>::operator=(mapped_matrix &&mat) noexcept
+{
+    if (this != &mat)
+    {
+        unmap();
+        std::swap(base, mat.base);
+        std::swap(length, mat.length);
+        std::swap(ptr, mat.ptr);
+        std::swap(rows, mat.rows);
+        std::swap(cols, mat.cols);
+        std::swap(row_stride, mat.row_stride);
+        std::swap(col_stride, mat.col_stride);
+    }
+    return *this;
+}
+
+template <typename ValueType>
+mapped_matrix<ValueType>::~mapped_matrix()
+{
+    unmap();
+}
+
+template <typename ValueType>
+void mapped_matrix<ValueType>::unmap() noexcept
+{
+    if (base)
+        ::munmap(base, length);
+    base = nullptr;
+    ptr = nullptr;
+    length = 0;
+    rows = cols = row_stride = 0;
+}
+
+#endif // End of the file
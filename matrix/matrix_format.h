@@ -0,0 +1,243 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_format.h
+ * @brief
+ *
+ * This file provides the text formatting behind <code>print_r</code>,
+ * <code>print_l</code> and <code>operator<<</code>. Numbers are formatted
+ * with std::to_chars into a buffer on the stack, written to the stream in
+ * blocks, instead of one formatted stream insertion per element.
+ *
+ * The text is the one the stream would write: to_chars with the stream
+ * precision gives the digits of printf("%g") in the "C" locale, complex
+ * numbers are written (re,im). Streams with other flags, a width or
+ * another locale, and element types other than numbers, are written
+ * element by element through the stream as before.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _MATRIX_FORMAT_H_
+#define _MATRIX_FORMAT_H_
+
+#include <ios>
+#include <locale>
+#include <complex>
+#include <ostream>
+#include <charconv>
+#include <cstddef>
+#include <type_traits>
+
+namespace matrix_format
+{
+    /**
+     * true for the element types written by text_writer: numbers,
+     * except bool and the character types that streams print as text
+     */
+    template <typename ValueType>
+    struct is_formattable
+        : std::integral_constant<bool, std::is_arithmetic<ValueType>::value &&
+                                           !std::is_same<ValueType, bool>::value &&
+                                           !std::is_same<ValueType, char>::value &&
+                                           !std::is_same<ValueType, signed char>::value &&
+                                           !std::is_same<ValueType, unsigned char>::value &&
+                                           !std::is_same<ValueType, wchar_t>::value &&
+                                           !std::is_same<ValueType, char16_t>::value &&
+                                           !std::is_same<ValueType, char32_t>::value>
+    {
+    };
+
+    template <typename ValueType>
+    struct is_formattable<std::complex<ValueType>> : std::is_floating_point<ValueType>
+    {
+    };
+
+    /**
+     * @returns true if os formats numbers the default way: decimal,
+     *          %g floating point, no width, no sign or base shown, in the
+     *          "C" locale
+     */
+    inline bool has_default_format(const std::ostream &os)
+    {
+        const std::ios::fmtflags flags = os.flags() & ~(std::ios::skipws | std::ios::unitbuf);
+        return flags == std::ios::dec && os.width() == 0 && os.getloc() == std::locale::classic();
+    }
+
+    /**
+     * Writes val as the stream would into [first, last)
+     * @returns one past the last character written, nullptr if it
+     *          doesn't fit
+     */
+    template <typename ValueType>
+    inline char *to_text(char *first, char *last, ValueType val, int precision)
+    {
+        std::to_chars_result res;
+        if constexpr (std::is_floating_point<ValueType>::value)
+            res = std::to_chars(first, last, val, std::chars_format::general, precision);
+        else
+            res = std::to_chars(first, last, val);
+        return res.ec == std::errc() ? res.ptr : nullptr;
+    }
+
+    template <typename ValueType>
+    inline char *to_text(char *first, char *last, const std::complex<ValueType> &val, int precision)
+    {
+        if (last - first < 3)
+            return nullptr;
+        *first++ = '(';
+        first = to_text(first, last - 2, val.real(), precision);
+        if (!first)
+            return nullptr;
+        *first++ = ',';
+        first = to_text(first, last - 1, val.imag(), precision);
+        if (!first)
+            return nullptr;
+        *first++ = ')';
+        return first;
+    }
+
+    /**
+     * Buffers formatted text and writes it to the stream in blocks
+     */
+    class text_writer
+    {
+    public:
+      explicit text_writer(std::ostream &stream)
+          : os(stream), precision(static_cast<int>(stream.precision())), end(buffer)
+      {
+      }
+
+      text_writer(const text_writer &) = delete;
+
+      text_writer &operator=(const text_writer &) = delete;
+
+      void put(char c)
+      {
+        if (end == buffer + block_size)
+          flush();
+        *end++ = c;
+      }
+
+      template <typename ValueType>
+      void put_value(const ValueType &val)
+      {
+        char *p = to_text(end, buffer + block_size, val, precision);
+        if (!p)
+        {
+          flush();
+          p = to_text(end, buffer + block_size, val, precision);
+        }
+        end = p;
+      }
+
+      /**
+         * Writes the buffered text to the stream
+         */
+      void flush()
+      {
+        os.write(buffer, end - buffer);
+        end = buffer;
+      }
+
+    private:
+      static constexpr std::size_t block_size = 1 << 14;
+
+      std::ostream &os;
+      int precision;
+      char *end;
+      char buffer[block_size];
+    };
+
+    /**
+     * Writes the (rows x cols) elements at data, row i at data + i * stride,
+     * every element followed by a space and every row by a line break.
+     * The stream is flushed at the end, as it was after every row.
+     */
+    template <typename ValueType>
+    void write_rows(std::ostream &os, const ValueType *data, int rows, int cols, int stride)
+    {
+        if constexpr (is_formattable<ValueType>::value)
+        {
+            if (has_default_format(os))
+            {
+                text_writer out(os);
+                for (int i = 0; i < rows; i++)
+                {
+                    const ValueType *row = data + static_cast<std::size_t>(i) * stride;
+                    for (int j = 0; j < cols; j++)
+                    {
+                        out.put_value(row[j]);
+                        out.put(' ');
+                    }
+                    out.put('\n');
+                }
+                out.flush();
+                os.flush();
+                return;
+            }
+        }
+        for (int i = 0; i < rows; i++)
+        {
+            const ValueType *row = data + static_cast<std::size_t>(i) * stride;
+            for (int j = 0; j < cols; j++)
+                os << row[j] << " ";
+            os << std::endl;
+        }
+    }
+
+    /**
+     * Writes the (rows x cols) elements at data on one line
+     * in the input format "[1 2;3 4]"
+     */
+    template <typename ValueType>
+    void write_line(std::ostream &os, const ValueType *data, int rows, int cols, int stride)
+    {
+        if constexpr (is_formattable<ValueType>::value)
+        {
+            if (has_default_format(os))
+            {
+                text_writer out(os);
+                out.put('[');
+                for (int i = 0; i < rows; i++)
+                {
+                    const ValueType *row = data + static_cast<std::size_t>(i) * stride;
+                    for (int j = 0; j < cols; j++)
+                    {
+                        out.put_value(row[j]);
+                        if (j < cols - 1)
+                            out.put(' ');
+                    }
+                    if (i < rows - 1)
+                        out.put(';');
+                }
+                out.put(']');
+                out.flush();
+                return;
+            }
+        }
+        os << "[";
+        for (int i = 0; i < rows; i++)
+        {
+            const ValueType *row = data + static_cast<std::size_t>(i) * stride;
+            for (int j = 0; j < cols; j++)
+            {
+                os << row[j];
+                if (j < cols - 1)
+                    os << " ";
+            }
+            if (i < rows - 1)
+                os << ";";
+        }
+        os << "]";
+    }
+} // namespace matrix_format
+
+#endif // End of the file
@@ -0,0 +1,481 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_gemm.h
+ * @brief
+ *
+ * This file implements the general matrix multiplication kernel used by
+ * <code>matrix::multiply</code>. The product is computed on cache sized
+ * blocks: a (KC x NC) panel of B is packed to stay in L3, a (MC x KC)
+ * block of A is packed to stay in L2, and a register blocked (MR x NR)
+ * micro-kernel streams the packed panels from L1.
+ *
+ * A and B are read through a row and a column stride, so transposed and
+ * strided views are multiplied without being copied first: packing
+ * already rearranges them.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _MATRIX_GEMM_H_
+#define _MATRIX_GEMM_H_
+
+#include <vector>
+#include <complex>
+#include <cstddef>
+#include <algorithm>
+
+#include "matrix_storage.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+
+namespace matrix_kernels
+{
+    /**
+     * Blocking parameters of the multiplication kernel
+     * MR x NR : size of the register block computed by the micro-kernel
+     * KC      : depth of the packed panels (A micro-panel + B micro-panel in L1)
+     * MC      : rows of the packed block of A (MC x KC in L2)
+     * NC      : columns of the packed panel of B (KC x NC in L3)
+     */
+    template <typename ValueType>
+    struct gemm_blocking
+    {
+        static constexpr int MR = 4;
+        static constexpr int NR = 4;
+        static constexpr int KC = 256;
+        static constexpr int MC = 64;
+        static constexpr int NC = 2048;
+    };
+
+    template <>
+    struct gemm_blocking<float>
+    {
+        static constexpr int MR = 6;
+        static constexpr int NR = 16;
+        static constexpr int KC = 256;
+        static constexpr int MC = 120;
+        static constexpr int NC = 4096;
+    };
+
+    template <>
+    struct gemm_blocking<double>
+    {
+        static constexpr int MR = 6;
+        static constexpr int NR = 8;
+        static constexpr int KC = 256;
+        static constexpr int MC = 96;
+        static constexpr int NC = 4096;
+    };
+
+    template <>
+    struct gemm_blocking<std::complex<float>>
+    {
+        static constexpr int MR = 4;
+        static constexpr int NR = 4;
+        static constexpr int KC = 256;
+        static constexpr int MC = 64;
+        static constexpr int NC = 2048;
+    };
+
+    /**
+     * Products smaller than this number of multiply-adds skip the packing
+     */
+    constexpr std::size_t gemm_small_size = 32 * 32 * 32;
+
+    /**
+     * @returns a per thread scratch buffer of at least n elements,
+     *          reused between calls so packing does not allocate
+     */
+    template <typename ValueType, int Slot>
+    inline ValueType *gemm_buffer(std::size_t n)
+    {
+        thread_local vector<ValueType, aligned_allocator<ValueType>> buffer;
+        if (buffer.size() < n)
+            buffer.resize(n);
+        return buffer.data();
+    }
+
+    /**
+     * Packs an (mc x kc) block of A into micro-panels of MR rows.
+     * Inside a micro-panel the MR values of a column are contiguous,
+     * rows past mc are padded with zeros.
+     */
+    template <typename ValueType, int MR>
+    void pack_a(int mc, int kc, const ValueType *a, int rsa, int csa, ValueType *packed)
+    {
+        for (int i = 0; i < mc; i += MR)
+        {
+            const int mr = std::min(MR, mc - i);
+            for (int p = 0; p < kc; p++)
+            {
+                for (int r = 0; r < mr; r++)
+                    packed[r] = a[static_cast<std::size_t>(i + r) * rsa + static_cast<std::size_t>(p) * csa];
+                for (int r = mr; r < MR; r++)
+                    packed[r] = ValueType();
+                packed += MR;
+            }
+        }
+    }
+
+    /**
+     * Packs a (kc x nc) panel of B into micro-panels of NR columns.
+     * Inside a micro-panel the NR values of a row are contiguous,
+     * columns past nc are padded with zeros.
+     */
+    template <typename ValueType, int NR>
+    void pack_b(int kc, int nc, const ValueType *b, int rsb, int csb, ValueType *packed)
+    {
+        for (int j = 0; j < nc; j += NR)
+        {
+            const int nr = std::min(NR, nc - j);
+            for (int p = 0; p < kc; p++)
+            {
+                const ValueType *row = b + static_cast<std::size_t>(p) * rsb + static_cast<std::size_t>(j) * csb;
+                if (csb == 1)
+                    for (int c = 0; c < nr; c++)
+                        packed[c] = row[c];
+                else
+                    for (int c = 0; c < nr; c++)
+                        packed[c] = row[static_cast<std::size_t>(c) * csb];
+                for (int c = nr; c < NR; c++)
+                    packed[c] = ValueType();
+                packed += NR;
+            }
+        }
+    }
+
+    /**
+     * Register blocked micro-kernel
+     * C(mr x nr) += A micro-panel(MR x kc) * B micro-panel(kc x NR)
+     */
+    template <typename ValueType, int MR, int NR>
+    struct micro_kernel
+    {
+        static void run(int kc, const ValueType *a, const ValueType *b,
+                        ValueType *c, int ldc, int mr, int nr)
+        {
+            ValueType acc[MR][NR] = {};
+            for (int p = 0; p < kc; p++, a += MR, b += NR)
+                for (int i = 0; i < MR; i++)
+                    for (int j = 0; j < NR; j++)
+                        acc[i][j] += a[i] * b[j];
+            for (int i = 0; i < mr; i++)
+                for (int j = 0; j < nr; j++)
+                    c[static_cast<std::size_t>(i) * ldc + j] += acc[i][j];
+        }
+    };
+
+    /**
+     * Complex micro-kernel, keeps the real and imaginary parts in separate
+     * accumulators and expands the product by hand so that the inner loop
+     * is plain floating point arithmetic.
+     */
+    template <typename FloatType, int MR, int NR>
+    struct micro_kernel<std::complex<FloatType>, MR, NR>
+    {
+        static void run(int kc, const std::complex<FloatType> *a, const std::complex<FloatType> *b,
+                        std::complex<FloatType> *c, int ldc, int mr, int nr)
+        {
+            FloatType re[MR][NR] = {};
+            FloatType im[MR][NR] = {};
+            const FloatType *pa = reinterpret_cast<const FloatType *>(a);
+            const FloatType *pb = reinterpret_cast<const FloatType *>(b);
+            for (int p = 0; p < kc; p++, pa += 2 * MR, pb += 2 * NR)
+                for (int i = 0; i < MR; i++)
+                {
+                    const FloatType ar = pa[2 * i];
+                    const FloatType ai = pa[2 * i + 1];
+                    for (int j = 0; j < NR; j++)
+                    {
+                        re[i][j] += ar * pb[2 * j] - ai * pb[2 * j + 1];
+                        im[i][j] += ar * pb[2 * j + 1] + ai * pb[2 * j];
+                    }
+                }
+            for (int i = 0; i < mr; i++)
+                for (int j = 0; j < nr; j++)
+                    c[static_cast<std::size_t>(i) * ldc + j] += std::complex<FloatType>(re[i][j], im[i][j]);
+        }
+    };
+
+    /**
+     * Adds an (MR x NR) tile of accumulators to the mr x nr valid part of C
+     */
+    template <typename ValueType, int MR, int NR>
+    inline void gemm_write_back(const ValueType *tile, ValueType *c, int ldc, int mr, int nr)
+    {
+        for (int i = 0; i < mr; i++)
+            for (int j = 0; j < nr; j++)
+                c[static_cast<std::size_t>(i) * ldc + j] += tile[i * NR + j];
+    }
+
+#ifdef MATRIX_SIMD_X86
+
+/**
+ * Generates a SIMD micro-kernel for an (MR x NV * W) register block,
+ * NV registers of W lanes per row of C. The full tile is updated in place,
+ * edge tiles go through a temporary.
+ */
+#define MATRIX_GEMM_KERNEL(NAME, TARGET, T, MR, NV, W, VT, LOADU, STOREU, SET1, FMA, ADD)          \
+    __attribute__((target(TARGET))) inline void NAME(int kc, const T *a, const T *b,              \
+                                                     T *c, int ldc, int mr, int nr)               \
+    {                                                                                             \
+        VT acc[MR][NV];                                                                           \
+        _Pragma("GCC unroll 8") for (int i = 0; i < MR; i++)                                      \
+            _Pragma("GCC unroll 2") for (int v = 0; v < NV; v++)                                  \
+                acc[i][v] = SET1(0);                                                              \
+        for (int p = 0; p < kc; p++, a += MR, b += NV * W)                                        \
+        {                                                                                         \
+            VT bv[NV];                                                                            \
+            _Pragma("GCC unroll 2") for (int v = 0; v < NV; v++)                                  \
+                bv[v] = LOADU(b + v * W);                                                         \
+            _Pragma("GCC unroll 8") for (int i = 0; i < MR; i++)                                  \
+            {                                                                                     \
+                const VT av = SET1(a[i]);                                                         \
+                _Pragma("GCC unroll 2") for (int v = 0; v < NV; v++)                              \
+                    acc[i][v] = FMA(av, bv[v], acc[i][v]);                                        \
+            }                                                                                     \
+        }                                                                                         \
+        if (mr == MR && nr == NV * W)                                                             \
+        {                                                                                         \
+            _Pragma("GCC unroll 8") for (int i = 0; i < MR; i++)                                  \
+                _Pragma("GCC unroll 2") for (int v = 0; v < NV; v++)                              \
+            {                                                                                     \
+                T *dst = c + static_cast<std::size_t>(i) * ldc + v * W;                           \
+                STOREU(dst, ADD(LOADU(dst), acc[i][v]));                                          \
+            }                                                                                     \
+            return;                                                                               \
+        }                                                                                         \
+        alignas(64) T tile[MR * NV * W];                                                          \
+        for (int i = 0; i < MR; i++)                                                              \
+            for (int v = 0; v < NV; v++)                                                          \
+                STOREU(tile + i * NV * W + v * W, acc[i][v]);                                     \
+        gemm_write_back<T, MR, NV * W>(tile, c, ldc, mr, nr);                                     \
+    }
+
+    MATRIX_GEMM_KERNEL(gemm_kernel_avx2_f32, "avx2,fma", float, 6, 2, 8, __m256,
+                       _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_fmadd_ps, _mm256_add_ps)
+    MATRIX_GEMM_KERNEL(gemm_kernel_avx2_f64, "avx2,fma", double, 6, 2, 4, __m256d,
+                       _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_fmadd_pd, _mm256_add_pd)
+    MATRIX_GEMM_KERNEL(gemm_kernel_avx512_f32, "avx512f", float, 6, 1, 16, __m512,
+                       _mm512_loadu_ps, _mm512_storeu_ps, _mm512_set1_ps, _mm512_fmadd_ps, _mm512_add_ps)
+    MATRIX_GEMM_KERNEL(gemm_kernel_avx512_f64, "avx512f", double, 6, 1, 8, __m512d,
+                       _mm512_loadu_pd, _mm512_storeu_pd, _mm512_set1_pd, _mm512_fmadd_pd, _mm512_add_pd)
+
+#undef MATRIX_GEMM_KERNEL
+
+    /**
+     * complex<float> micro-kernel for a (4 x 4) block, one register per row
+     * of C holding 4 interleaved complex values. ar * b and ai * b are
+     * accumulated separately and combined with addsub after the loop.
+     */
+    __attribute__((target("avx2,fma"))) inline void gemm_kernel_avx2_c32(
+        int kc, const std::complex<float> *a, const std::complex<float> *b,
+        std::complex<float> *c, int ldc, int mr, int nr)
+    {
+        const float *pa = reinterpret_cast<const float *>(a);
+        const float *pb = reinterpret_cast<const float *>(b);
+        __m256 acc_re[4], acc_im[4];
+        _Pragma("GCC unroll 4") for (int i = 0; i < 4; i++)
+        {
+            acc_re[i] = _mm256_setzero_ps();
+            acc_im[i] = _mm256_setzero_ps();
+        }
+        for (int p = 0; p < kc; p++, pa += 8, pb += 8)
+        {
+            const __m256 bv = _mm256_loadu_ps(pb);
+            _Pragma("GCC unroll 4") for (int i = 0; i < 4; i++)
+            {
+                acc_re[i] = _mm256_fmadd_ps(_mm256_set1_ps(pa[2 * i]), bv, acc_re[i]);
+                acc_im[i] = _mm256_fmadd_ps(_mm256_set1_ps(pa[2 * i + 1]), bv, acc_im[i]);
+            }
+        }
+        alignas(32) std::complex<float> tile[4 * 4];
+        _Pragma("GCC unroll 4") for (int i = 0; i < 4; i++)
+        {
+            const __m256 swapped = _mm256_permute_ps(acc_im[i], 0xB1);
+            const __m256 res = _mm256_addsub_ps(acc_re[i], swapped);
+            if (mr == 4 && nr == 4)
+            {
+                float *dst = reinterpret_cast<float *>(c + static_cast<std::size_t>(i) * ldc);
+                _mm256_storeu_ps(dst, _mm256_add_ps(_mm256_loadu_ps(dst), res));
+            }
+            else
+                _mm256_store_ps(reinterpret_cast<float *>(tile + 4 * i), res);
+        }
+        if (mr != 4 || nr != 4)
+            gemm_write_back<std::complex<float>, 4, 4>(tile, c, ldc, mr, nr);
+    }
+
+#endif // MATRIX_SIMD_X86
+
+    /**
+     * @returns the micro-kernel used by gemm() for ValueType: the SIMD
+     *          kernel of the active instruction set for float, double and
+     *          complex<float>, the portable kernel otherwise
+     */
+    template <typename ValueType>
+    inline auto gemm_micro_kernel()
+    {
+        using blocking = gemm_blocking<ValueType>;
+        return &micro_kernel<ValueType, blocking::MR, blocking::NR>::run;
+    }
+
+    template <>
+    inline auto gemm_micro_kernel<float>()
+    {
+        using blocking = gemm_blocking<float>;
+        static const auto kernel = [] {
+            auto selected = &micro_kernel<float, blocking::MR, blocking::NR>::run;
+#ifdef MATRIX_SIMD_X86
+            if (active_simd_level == simd_level::avx512)
+                selected = gemm_kernel_avx512_f32;
+            else if (active_simd_level == simd_level::avx2)
+                selected = gemm_kernel_avx2_f32;
+#endif
+            return selected;
+        }();
+        return kernel;
+    }
+
+    template <>
+    inline auto gemm_micro_kernel<double>()
+    {
+        using blocking = gemm_blocking<double>;
+        static const auto kernel = [] {
+            auto selected = &micro_kernel<double, blocking::MR, blocking::NR>::run;
+#ifdef MATRIX_SIMD_X86
+            if (active_simd_level == simd_level::avx512)
+                selected = gemm_kernel_avx512_f64;
+            else if (active_simd_level == simd_level::avx2)
+                selected = gemm_kernel_avx2_f64;
+#endif
+            return selected;
+        }();
+        return kernel;
+    }
+
+    template <>
+    inline auto gemm_micro_kernel<std::complex<float>>()
+    {
+        using blocking = gemm_blocking<std::complex<float>>;
+        static const auto kernel = [] {
+            auto selected = &micro_kernel<std::complex<float>, blocking::MR, blocking::NR>::run;
+#ifdef MATRIX_SIMD_X86
+            if (active_simd_level >= simd_level::avx2)
+                selected = gemm_kernel_avx2_c32;
+#endif
+            return selected;
+        }();
+        return kernel;
+    }
+
+    /**
+     * Straightforward i-k-j product used for small sizes where
+     * packing costs more than it saves
+     */
+    template <typename ValueType>
+    void gemm_small(int m, int n, int k, const ValueType *a, int rsa, int csa,
+                    const ValueType *b, int rsb, int csb, ValueType *c, int ldc)
+    {
+        for (int i = 0; i < m; i++)
+        {
+            ValueType *c_row = c + static_cast<std::size_t>(i) * ldc;
+            const ValueType *a_row = a + static_cast<std::size_t>(i) * rsa;
+            for (int p = 0; p < k; p++)
+            {
+                const ValueType a_val = a_row[static_cast<std::size_t>(p) * csa];
+                const ValueType *b_row = b + static_cast<std::size_t>(p) * rsb;
+                if (csb == 1)
+                    for (int j = 0; j < n; j++)
+                        c_row[j] += a_val * b_row[j];
+                else
+                    for (int j = 0; j < n; j++)
+                        c_row[j] += a_val * b_row[static_cast<std::size_t>(j) * csb];
+            }
+        }
+    }
+
+    /**
+     * C(m x n) += A(m x k) * B(k x n)
+     * Element (i, j) of A is a[i * rsa + j * csa], same for B,
+     * C is row-major with leading dimension ldc
+     */
+    template <typename ValueType>
+    void gemm(int m, int n, int k, const ValueType *a, int rsa, int csa,
+              const ValueType *b, int rsb, int csb, ValueType *c, int ldc)
+    {
+        if (m <= 0 || n <= 0 || k <= 0)
+            return;
+        if (static_cast<std::size_t>(m) * n * k <= gemm_small_size)
+        {
+            gemm_small(m, n, k, a, rsa, csa, b, rsb, csb, c, ldc);
+            return;
+        }
+
+        using blocking = gemm_blocking<ValueType>;
+        constexpr int MR = blocking::MR;
+        constexpr int NR = blocking::NR;
+        constexpr int KC = blocking::KC;
+        constexpr int MC = blocking::MC;
+        constexpr int NC = blocking::NC;
+
+        const auto kernel = gemm_micro_kernel<ValueType>();
+        ValueType *packed_b = gemm_buffer<ValueType, 1>(static_cast<std::size_t>(NC + NR) * KC);
+
+        // rows of C are split between the threads in blocks of at most MC
+        // rows, every thread packs its own blocks of A against the shared B
+        const std::size_t work = static_cast<std::size_t>(m) * n * k / 64;
+        const int threads = work < matrix_parallel::parallel_threshold ? 1 : matrix_parallel::get_num_threads();
+        const int row_block = std::max(MR, std::min(MC, (m / threads + MR - 1) / MR * MR));
+        const int row_blocks = (m + row_block - 1) / row_block;
+
+        for (int jc = 0; jc < n; jc += NC)
+        {
+            const int nc = std::min(NC, n - jc);
+            for (int pc = 0; pc < k; pc += KC)
+            {
+                const int kc = std::min(KC, k - pc);
+                pack_b<ValueType, NR>(kc, nc, b + static_cast<std::size_t>(pc) * rsb + static_cast<std::size_t>(jc) * csb,
+                                      rsb, csb, packed_b);
+                matrix_parallel::parallel_for(0, row_blocks, work, [&](int first, int last) {
+                    ValueType *packed_a = gemm_buffer<ValueType, 0>(static_cast<std::size_t>(MC + MR) * KC);
+                    for (int ic = first * row_block; ic < std::min(m, last * row_block); ic += row_block)
+                    {
+                        const int mc = std::min(row_block, m - ic);
+                        pack_a<ValueType, MR>(mc, kc, a + static_cast<std::size_t>(ic) * rsa + static_cast<std::size_t>(pc) * csa,
+                                              rsa, csa, packed_a);
+                        for (int jr = 0; jr < nc; jr += NR)
+                            for (int ir = 0; ir < mc; ir += MR)
+                                kernel(
+                                    kc,
+                                    packed_a + static_cast<std::size_t>(ir) * kc,
+                                    packed_b + static_cast<std::size_t>(jr) * kc,
+                                    c + static_cast<std::size_t>(ic + ir) * ldc + jc + jr, ldc,
+                                    std::min(MR, mc - ir), std::min(NR, nc - jr));
+                    }
+                });
+            }
+        }
+    }
+
+    /**
+     * C(m x n) += A(m x k) * B(k x n)
+     * All matrices are row-major with leading dimensions lda, ldb and ldc
+     */
+    template <typename ValueType>
+    inline void gemm(int m, int n, int k, const ValueType *a, int lda,
+                     const ValueType *b, int ldb, ValueType *c, int ldc)
+    {
+        gemm(m, n, k, a, lda, 1, b, ldb, 1, c, ldc);
+    }
+}
+
+#endif // End of the file
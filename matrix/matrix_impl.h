@@ -28,413 +28,619 @@
 #include <sstream>
 
 #include "matrix_def.h"
+#include "matrix_gemm.h"
+#include "thread_pool.h"
+#include "matrix_arena.h"
+#include "matrix_cache.h"
+#include "matrix_profile.h"
+#include "lu_factorization.h"
+#include "determinant_kernels.h"
+#include "matrix_view.h"
+#include "matrix_format.h"
+#include "matrix_transpose.h"
 #include "vector_arithmetic.h"
 
-template <typename ValueType>
-matrix<ValueType>::matrix()
-    : rows(0), cols(0)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator>::matrix()
+    : rows(0), cols(0), stride(0)
 {
     // do nothing
 }
 
-template <typename ValueType>
-matrix<ValueType>::matrix(int row, int col)
-    : rows(row), cols(col)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator>::matrix(int row, int col)
+    : rows(row), cols(col), stride(padded_stride<ValueType>(col)),
+      elements(static_cast<size_t>(row) * stride)
 {
-    elements.resize(row);
-    for (int i = 0; i < row; i++)
-        elements[i].resize(col);
+    // do nothing
 }
 
-template <typename ValueType>
-matrix<ValueType>::matrix(const matrix<ValueType> &mat)
-    : rows(mat.rows), cols(mat.cols), elements(mat.elements)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator>::matrix(const matrix<ValueType, Allocator> &mat)
+    : rows(mat.rows), cols(mat.cols), stride(mat.stride), elements(mat.elements)
 {
     // do nothing
 }
 
-template <typename ValueType>
-matrix<ValueType>::matrix(matrix<ValueType> &&mat)
-    : rows(mat.rows), cols(mat.cols), elements(std::move(mat.elements))
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator>::matrix(matrix<ValueType, Allocator> &&mat)
+    : rows(mat.rows), cols(mat.cols), stride(mat.stride), elements(std::move(mat.elements))
 {
-    // do nothing
+    mat.rows = mat.cols = mat.stride = 0;
 }
 
-template <typename ValueType>
-matrix<ValueType>::matrix(const vector<vector<ValueType>> &vec)
+template <typename ValueType, typename Allocator>
+template <typename OtherAllocator>
+matrix<ValueType, Allocator>::matrix(const matrix<ValueType, OtherAllocator> &mat)
+    : matrix(mat.get_rows(), mat.get_cols())
 {
-    std::pair<int, int> p = check_dim(vec);
-    if (p.first < 0)
-        throw std::length_error("matrix -> vectors dimentions are not consistent");
-    rows = p.first;
-    cols = p.second;
-    elements = vec;
+    for (int i = 0; i < rows; i++)
+        (*this)[i] = mat[i];
 }
 
-template <typename ValueType>
-matrix<ValueType>::matrix(vector<vector<ValueType>> &&vec)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator>::matrix(const vector<vector<ValueType>> &vec)
+    : matrix()
 {
-    std::pair<int, int> p = check_dim(vec);
-    if (p.first < 0)
-        throw std::length_error("matrix -> vectors dimentions are not consistent");
-    rows = p.first;
-    cols = p.second;
-    elements = std::move(vec);
+    *this = vec;
+}
+
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator>::matrix(vector<vector<ValueType>> &&vec)
+    : matrix()
+{
+    *this = vec;
+    vec.clear();
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator=(const matrix<ValueType> &mat)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator=(const matrix<ValueType, Allocator> &mat)
 {
     rows = mat.rows;
     cols = mat.cols;
+    stride = mat.stride;
     elements = mat.elements;
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator=(matrix<ValueType> &&mat)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator=(matrix<ValueType, Allocator> &&mat)
 {
     rows = mat.rows;
     cols = mat.cols;
+    stride = mat.stride;
     elements = std::move(mat.elements);
+    mat.rows = mat.cols = mat.stride = 0;
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator=(const vector<vector<ValueType>> &vec)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator=(const vector<vector<ValueType>> &vec)
 {
     std::pair<int, int> p = check_dim(vec);
     if (p.first < 0)
         throw std::length_error("matrix -> vectors dimentions are not consistent");
     rows = p.first;
     cols = p.second;
-    elements = vec;
+    stride = padded_stride<ValueType>(cols);
+    elements.assign(static_cast<size_t>(rows) * stride, ValueType());
+    for (int i = 0; i < rows; i++)
+        std::copy(vec[i].begin(), vec[i].end(), data() + static_cast<size_t>(i) * stride);
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator=(vector<vector<ValueType>> &&vec)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator=(vector<vector<ValueType>> &&vec)
 {
-    std::pair<int, int> p = check_dim(vec);
-    if (p.first < 0)
-        throw std::length_error("matrix -> vectors dimentions are not consistent");
-    rows = p.first;
-    cols = p.second;
-    elements = std::move(vec);
+    *this = vec;
+    vec.clear();
     return *this;
 }
 
-template <typename ValueType>
-bool matrix<ValueType>::operator==(const matrix<ValueType> &mat)
+template <typename ValueType, typename Allocator>
+template <typename Expr>
+matrix<ValueType, Allocator>::matrix(const matrix_expr<Expr> &expr)
+    : matrix(expr.derived().get_rows(), expr.derived().get_cols())
 {
-    return elements == mat.elements;
+    eval_expr(expr.derived(), [](ValueType &dst, const ValueType &val) { dst = val; }, "matrix");
 }
 
-template <typename ValueType>
-bool matrix<ValueType>::operator!=(const matrix<ValueType> &mat)
+template <typename ValueType, typename Allocator>
+template <typename Expr>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator=(const matrix_expr<Expr> &expr)
 {
-    return elements != mat.elements;
+    const Expr &e = expr.derived();
+    if (rows != e.get_rows() || cols != e.get_cols())
+    {
+        // the expression may read from this matrix, build the result aside
+        matrix<ValueType, Allocator> res(e);
+        return *this = std::move(res);
+    }
+    eval_expr(e, [](ValueType &dst, const ValueType &val) { dst = val; }, "matrix");
+    return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::print_r()
+template <typename ValueType, typename Allocator>
+template <typename Expr>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator+=(const matrix_expr<Expr> &expr)
 {
-    for (const auto &items : elements)
-    {
-        for (const auto &element : items)
-            std::cout << element << " ";
-        std::cout << std::endl;
-    }
+    eval_expr(expr.derived(), [](ValueType &dst, const ValueType &val) { dst += val; }, "matrix::addition");
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::print_r(std::ostream &os)
+template <typename ValueType, typename Allocator>
+template <typename Expr>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator-=(const matrix_expr<Expr> &expr)
 {
-    for (const auto &items : elements)
-    {
-        for (const auto &element : items)
-            os << element << " ";
-        os << std::endl;
-    }
+    eval_expr(expr.derived(), [](ValueType &dst, const ValueType &val) { dst -= val; }, "matrix::subtraction");
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::print_l()
+template <typename ValueType, typename Allocator>
+template <typename Expr>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator*=(const matrix_expr<Expr> &expr)
 {
-    std::cout << "[";
-    for (int i = 0; i < rows; i++)
-    {
-        for (int j = 0; j < cols; j++)
-        {
-            std::cout << elements[i][j];
-            if (j < (cols - 1))
-                std::cout << " ";
-        }
-        if (i < (rows - 1))
-            std::cout << ";";
-    }
-    std::cout << "]";
+    eval_expr(expr.derived(), [](ValueType &dst, const ValueType &val) { dst *= val; }, "matrix::scalar_multiplication");
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::print_l(std::ostream &os)
+template <typename ValueType, typename Allocator>
+template <typename Expr>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator/=(const matrix_expr<Expr> &expr)
 {
-    os << "[";
-    for (int i = 0; i < rows; i++)
+    eval_expr(expr.derived(), [](ValueType &dst, const ValueType &val) { dst /= val; }, "matrix::divsion");
+    return *this;
+}
+
+template <typename ValueType, typename Allocator>
+template <typename Expr, typename Assign>
+void matrix<ValueType, Allocator>::eval_expr(const Expr &expr, Assign assign, const char *name)
+{
+    if (rows != expr.get_rows() || cols != expr.get_cols())
+        throw std::length_error(std::string(name) + " -> Matrices dimentions must be the same");
+    if (expr.aliases(view()))
     {
-        for (int j = 0; j < cols; j++)
+        // the expression reads this matrix through a view with another
+        // layout, evaluate it aside so no element is read after being written
+        const matrix<ValueType, arena_allocator<ValueType>> tmp(expr);
+        eval_expr(matrix_leaf<ValueType>(tmp), assign, name);
+        return;
+    }
+    MATRIX_PROFILE_OP("matrix::expression", rows, cols, 0, 0, static_cast<double>(rows) * cols * sizeof(ValueType));
+    matrix_parallel::parallel_for(0, rows, static_cast<size_t>(rows) * cols, [&](int first, int last) {
+        for (int i = first; i < last; i++)
         {
-            os << elements[i][j];
-            if (j < (cols - 1))
-                os << " ";
+            ValueType *dst = data() + static_cast<size_t>(i) * stride;
+            for (int j = 0; j < cols; j++)
+                assign(dst[j], expr.coeff(i, j));
         }
-        if (i < (rows - 1))
-            os << ";";
-    }
-    os << "]";
+    });
+}
+
+template <typename ValueType, typename Allocator>
+bool matrix<ValueType, Allocator>::operator==(const matrix<ValueType, Allocator> &mat)
+{
+    if (rows != mat.rows || cols != mat.cols)
+        return false;
+    for (int i = 0; i < rows; i++)
+        if (!std::equal((*this)[i].begin(), (*this)[i].end(), mat[i].begin()))
+            return false;
+    return true;
+}
+
+template <typename ValueType, typename Allocator>
+bool matrix<ValueType, Allocator>::operator!=(const matrix<ValueType, Allocator> &mat)
+{
+    return !(*this == mat);
+}
+
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::print_r()
+{
+    return print_r(std::cout);
+}
+
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::print_r(std::ostream &os)
+{
+    matrix_format::write_rows(os, data(), rows, cols, stride);
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::resize(int row, int col)
+template <typename ValueType, typename Allocator>
+const matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::print_r(std::ostream &os) const
 {
+    matrix_format::write_rows(os, data(), rows, cols, stride);
+    return *this;
+}
+
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::print_l()
+{
+    return print_l(std::cout);
+}
+
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::print_l(std::ostream &os)
+{
+    matrix_format::write_line(os, data(), rows, cols, stride);
+    return *this;
+}
+
+template <typename ValueType, typename Allocator>
+const matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::print_l(std::ostream &os) const
+{
+    matrix_format::write_line(os, data(), rows, cols, stride);
+    return *this;
+}
+
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::resize(int row, int col)
+{
+    relayout(row, col, padded_stride<ValueType>(col));
+    return *this;
+}
+
+template <typename ValueType, typename Allocator>
+void matrix<ValueType, Allocator>::relayout(int row, int col, int new_stride)
+{
+    vector<ValueType, Allocator> buffer(static_cast<size_t>(row) * new_stride);
+    const int min_rows = std::min(rows, row);
+    const int min_cols = std::min(cols, col);
+    for (int i = 0; i < min_rows; i++)
+        std::copy(data() + static_cast<size_t>(i) * stride,
+                  data() + static_cast<size_t>(i) * stride + min_cols,
+                  buffer.data() + static_cast<size_t>(i) * new_stride);
     rows = row;
     cols = col;
-    elements.resize(row);
-    for (int i = 0; i < row; i++)
-        elements[i].resize(col);
-    return *this;
+    stride = new_stride;
+    elements = std::move(buffer);
 }
 
-template <typename ValueType>
-inline std::pair<int, int> matrix<ValueType>::get_dim()
+template <typename ValueType, typename Allocator>
+inline std::pair<int, int> matrix<ValueType, Allocator>::get_dim() const
 {
     return std::make_pair(rows, cols);
 }
 
-template <typename ValueType>
-inline int matrix<ValueType>::get_rows()
+template <typename ValueType, typename Allocator>
+inline int matrix<ValueType, Allocator>::get_rows() const
 {
     return rows;
 }
 
-template <typename ValueType>
-inline int matrix<ValueType>::get_cols()
+template <typename ValueType, typename Allocator>
+inline int matrix<ValueType, Allocator>::get_cols() const
 {
     return cols;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator+=(const matrix<ValueType> &mat)
+template <typename ValueType, typename Allocator>
+inline int matrix<ValueType, Allocator>::get_stride() const
 {
-    if (rows != mat.rows || cols != mat.cols)
-        throw std::length_error("matrix::addition -> Matrices dimentions must be the same");
-    auto itm = mat.elements.begin();
-    std::for_each(elements.begin(), elements.end(), [&itm](auto &ite) {
-        auto iitm = itm->begin();
-        std::for_each(ite.begin(), ite.end(), [&iitm](auto &iite) {
-            iite += *iitm;
-            iitm++;
-        });
-        itm++;
-    });
+    return stride;
+}
+
+template <typename ValueType, typename Allocator>
+inline ValueType *matrix<ValueType, Allocator>::data()
+{
+    return elements.data();
+}
+
+template <typename ValueType, typename Allocator>
+inline const ValueType *matrix<ValueType, Allocator>::data() const
+{
+    return elements.data();
+}
 
-    /* Another simple way, use one only */
+template <typename ValueType, typename Allocator>
+inline matrix_view<ValueType> matrix<ValueType, Allocator>::view()
+{
+    return matrix_view<ValueType>(data(), rows, cols, stride);
+}
 
-    // for(int i=0; i<rows; i++)
-    //     for(int j=0; j<cols; j++)
-    //         elements[i][j] += mat.elements[i][j] ;
+template <typename ValueType, typename Allocator>
+inline matrix_view<const ValueType> matrix<ValueType, Allocator>::view() const
+{
+    return matrix_view<const ValueType>(data(), rows, cols, stride);
+}
 
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator+=(const matrix<ValueType, Allocator> &mat)
+{
+    if (rows != mat.rows || cols != mat.cols)
+        throw std::length_error("matrix::addition -> Matrices dimentions must be the same");
+    MATRIX_PROFILE_OP("matrix::addition", rows, cols, 0, static_cast<double>(rows) * cols,
+                      3.0 * rows * cols * sizeof(ValueType));
+    matrix_parallel::parallel_for(0, rows, static_cast<size_t>(rows) * cols, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            ValueType *dst = data() + static_cast<size_t>(i) * stride;
+            const ValueType *src = mat.data() + static_cast<size_t>(i) * mat.stride;
+            matrix_kernels::vec_add(cols, dst, src);
+        }
+    });
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator-=(const matrix<ValueType> &mat)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator-=(const matrix<ValueType, Allocator> &mat)
 {
     if (rows != mat.rows || cols != mat.cols)
         throw std::length_error("matrix::subtraction -> Matrices dimentions must be the same");
-    auto itm = mat.elements.begin();
-    std::for_each(elements.begin(), elements.end(), [&itm](auto &ite) {
-        auto iitm = itm->begin();
-        std::for_each(ite.begin(), ite.end(), [&iitm](auto &iite) {
-            iite -= *iitm;
-            iitm++;
-        });
-        itm++;
+    MATRIX_PROFILE_OP("matrix::subtraction", rows, cols, 0, static_cast<double>(rows) * cols,
+                      3.0 * rows * cols * sizeof(ValueType));
+    matrix_parallel::parallel_for(0, rows, static_cast<size_t>(rows) * cols, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            ValueType *dst = data() + static_cast<size_t>(i) * stride;
+            const ValueType *src = mat.data() + static_cast<size_t>(i) * mat.stride;
+            matrix_kernels::vec_sub(cols, dst, src);
+        }
     });
-
-    /* Another simple way, use one only */
-
-    // for(int i=0; i<rows; i++)
-    //     for(int j=0; j<cols; j++)
-    //         elements[i][j] -= mat.elements[i][j] ;
-
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator*=(const matrix<ValueType> &mat)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator*=(const matrix<ValueType, Allocator> &mat)
 {
     if (rows != mat.rows || cols != mat.cols)
         throw std::length_error("matrix::scalar_multiplication -> Matrices dimentions must be the same");
-    auto itm = mat.elements.begin();
-    std::for_each(elements.begin(), elements.end(), [&itm](auto &ite) {
-        auto iitm = itm->begin();
-        std::for_each(ite.begin(), ite.end(), [&iitm](auto &iite) {
-            iite *= *iitm;
-            iitm++;
-        });
-        itm++;
+    MATRIX_PROFILE_OP("matrix::scalar_multiplication", rows, cols, 0, static_cast<double>(rows) * cols,
+                      3.0 * rows * cols * sizeof(ValueType));
+    matrix_parallel::parallel_for(0, rows, static_cast<size_t>(rows) * cols, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            ValueType *dst = data() + static_cast<size_t>(i) * stride;
+            const ValueType *src = mat.data() + static_cast<size_t>(i) * mat.stride;
+            matrix_kernels::vec_mul(cols, dst, src);
+        }
     });
-    /* Another simple way, use one only */
-    // for(int i=0; i<rows; i++)
-    //     for(int j=0; j<cols; j++)
-    //         elements[i][j] *= mat.elements[i][j] ;
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator/=(const matrix<ValueType> &mat)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator/=(const matrix<ValueType, Allocator> &mat)
 {
     if (rows != mat.rows || cols != mat.cols)
         throw std::length_error("matrix::divsion -> Matrices dimentions must be the same");
-    auto itm = mat.elements.begin();
-    std::for_each(elements.begin(), elements.end(), [&itm](auto &ite) {
-        auto iitm = itm->begin();
-        std::for_each(ite.begin(), ite.end(), [&iitm](auto &iite) {
-            iite /= *iitm;
-            iitm++;
-        });
-        itm++;
+    MATRIX_PROFILE_OP("matrix::division", rows, cols, 0, static_cast<double>(rows) * cols,
+                      3.0 * rows * cols * sizeof(ValueType));
+    matrix_parallel::parallel_for(0, rows, static_cast<size_t>(rows) * cols, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            ValueType *dst = data() + static_cast<size_t>(i) * stride;
+            const ValueType *src = mat.data() + static_cast<size_t>(i) * mat.stride;
+            matrix_kernels::vec_div(cols, dst, src);
+        }
     });
-
-    /* Another simple way, use one only */
-
-    // for(int i=0; i<rows; i++)
-    //     for(int j=0; j<cols; j++)
-    //         elements[i][j] /= mat.elements[i][j] ;
-
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator+=(const ValueType val)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator+=(const ValueType val)
 {
-    for (auto &row : elements)
-        for (auto &col : row)
-            col += val;
+    MATRIX_PROFILE_OP("matrix::scalar_addition", rows, cols, 0, static_cast<double>(rows) * cols,
+                      2.0 * rows * cols * sizeof(ValueType));
+    matrix_parallel::parallel_for(0, rows, static_cast<size_t>(rows) * cols, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            ValueType *dst = data() + static_cast<size_t>(i) * stride;
+            matrix_kernels::vec_add_scalar(cols, dst, val);
+        }
+    });
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator-=(const ValueType val)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator-=(const ValueType val)
 {
-    for (auto &row : elements)
-        for (auto &col : row)
-            col -= val;
+    MATRIX_PROFILE_OP("matrix::scalar_subtraction", rows, cols, 0, static_cast<double>(rows) * cols,
+                      2.0 * rows * cols * sizeof(ValueType));
+    matrix_parallel::parallel_for(0, rows, static_cast<size_t>(rows) * cols, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            ValueType *dst = data() + static_cast<size_t>(i) * stride;
+            matrix_kernels::vec_sub_scalar(cols, dst, val);
+        }
+    });
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator*=(const ValueType val)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator*=(const ValueType val)
 {
-    for (auto &row : elements)
-        for (auto &col : row)
-            col *= val;
+    MATRIX_PROFILE_OP("matrix::scalar_product", rows, cols, 0, static_cast<double>(rows) * cols,
+                      2.0 * rows * cols * sizeof(ValueType));
+    matrix_parallel::parallel_for(0, rows, static_cast<size_t>(rows) * cols, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            ValueType *dst = data() + static_cast<size_t>(i) * stride;
+            matrix_kernels::vec_mul_scalar(cols, dst, val);
+        }
+    });
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::operator/=(const ValueType val)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::operator/=(const ValueType val)
 {
-    for (auto &row : elements)
-        for (auto &col : row)
-            col /= val;
+    MATRIX_PROFILE_OP("matrix::scalar_division", rows, cols, 0, static_cast<double>(rows) * cols,
+                      2.0 * rows * cols * sizeof(ValueType));
+    matrix_parallel::parallel_for(0, rows, static_cast<size_t>(rows) * cols, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            ValueType *dst = data() + static_cast<size_t>(i) * stride;
+            matrix_kernels::vec_div_scalar(cols, dst, val);
+        }
+    });
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> matrix<ValueType>::multiply(matrix<ValueType> &mat)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> matrix<ValueType, Allocator>::multiply(const matrix<ValueType, Allocator> &mat)
 {
     if (cols != mat.rows)
         throw std::length_error("matrix::multiply -> check matrices dimentions");
-    matrix<ValueType> res(rows, mat.cols);
-    for (int i = 0; i < rows; i++)
-        for (int j = 0; j < mat.cols; j++)
-            for (int k = 0; k < mat.rows; k++)
-                res[i][j] += elements[i][k] * mat[k][j];
+    MATRIX_PROFILE_OP("matrix::multiply", rows, cols, mat.cols, matrix_profile::flops::gemm(rows, mat.cols, cols),
+                      (static_cast<double>(rows) * cols + static_cast<double>(cols) * mat.cols +
+                       static_cast<double>(rows) * mat.cols) * sizeof(ValueType));
+    matrix<ValueType, Allocator> res(rows, mat.cols);
+    matrix_kernels::gemm(rows, mat.cols, cols, data(), stride,
+                         mat.data(), mat.stride, res.data(), res.stride);
     return res;
 }
 
-template <typename ValueType>
-matrix<ValueType> matrix<ValueType>::power(int n)
+template <typename ValueType, typename Allocator>
+template <typename OtherType>
+inline matrix<ValueType, Allocator> matrix<ValueType, Allocator>::multiply(const matrix_view<OtherType> &mat)
+{
+    MATRIX_PROFILE_OP("matrix::multiply", rows, cols, mat.get_cols(), matrix_profile::flops::gemm(rows, mat.get_cols(), cols),
+                      (static_cast<double>(rows) * cols + static_cast<double>(mat.get_rows()) * mat.get_cols() +
+                       static_cast<double>(rows) * mat.get_cols()) * sizeof(ValueType));
+    return view().multiply(mat);
+}
+
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> matrix<ValueType, Allocator>::power(int n)
 {
     if (rows != cols)
         throw std::length_error("matrix::power -> matrix must be square");
-    matrix<ValueType> res = *this;
-    for (int i = 0; i < n - 1; i++)
-        res = res.multiply(*this);
-    return res;
+    MATRIX_PROFILE_OP("matrix::power", rows, cols, 0,
+                      matrix_profile::flops::power_products(n) * matrix_profile::flops::gemm(rows, rows, rows),
+                      matrix_profile::flops::power_products(n) * 3.0 * rows * rows * sizeof(ValueType));
+    return matrix_cache::memoize<matrix<ValueType, Allocator>>(matrix_cache::cache_op::power, n, *this, [&] {
+        // binary exponentiation, the three buffers are allocated once and
+        // every product is written into the spare one then swapped in
+        matrix<ValueType, Allocator> base = n < 0 ? invert() : *this;
+        matrix<ValueType, Allocator> res(rows, cols);
+        matrix<ValueType, Allocator> scratch(rows, cols);
+        unsigned long long e = n < 0 ? -static_cast<long long>(n) : n;
+        bool first = true;
+        while (e)
+        {
+            if (e & 1)
+            {
+                if (first)
+                    res = base;
+                else
+                {
+                    multiply_into(res, base, scratch);
+                    std::swap(res, scratch);
+                }
+                first = false;
+            }
+            e >>= 1;
+            if (e)
+            {
+                multiply_into(base, base, scratch);
+                std::swap(base, scratch);
+            }
+        }
+        if (first)
+            for (int i = 0; i < rows; i++)
+                res[i][i] = static_cast<ValueType>(1);
+        return res;
+    });
+}
+
+template <typename ValueType, typename Allocator>
+void matrix<ValueType, Allocator>::multiply_into(const matrix<ValueType, Allocator> &a, const matrix<ValueType, Allocator> &b,
+                                      matrix<ValueType, Allocator> &res)
+{
+    std::fill(res.elements.begin(), res.elements.end(), ValueType());
+    matrix_kernels::gemm(a.rows, b.cols, a.cols, a.data(), a.stride,
+                         b.data(), b.stride, res.data(), res.stride);
 }
 
-template <typename ValueType>
-matrix<ValueType> matrix<ValueType>::invert()
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> matrix<ValueType, Allocator>::invert()
 {
     if (rows != cols)
         throw std::length_error("matrix::invert -> matrix must be square");
-    matrix<ValueType> adj(rows, cols);
-    ValueType signRow = 1;
-    ValueType signCol = signRow;
-    for (int i = 0; i < rows; i++)
-    {
-        for (int j = 0; j < cols; j++)
-        {
-            adj[i][j] = determinant(sub_matrix(*this, i, j)) * signCol;
-            signCol = -signCol;
-        }
-        signRow = -signRow;
-        signCol = signRow;
-    }
-    ValueType det = determinant(*this);
-    if (det == static_cast<ValueType>(0))
-        throw std::out_of_range("matrix::invert -> Determinant equal zero");
-    return adj.transpose() /= det;
+    MATRIX_PROFILE_OP("matrix::invert", rows, cols, 0, matrix_profile::flops::inverse(rows),
+                      2.0 * rows * cols * sizeof(ValueType));
+    return matrix_cache::memoize<matrix<ValueType, Allocator>>(matrix_cache::cache_op::invert, 0, *this, [this] {
+        return lu_factorization<ValueType, Allocator>(*this).inverse();
+    });
 }
 
-template <typename ValueType>
-matrix<ValueType> matrix<ValueType>::transpose()
+template <typename ValueType, typename Allocator>
+inline lu_factorization<ValueType, Allocator> matrix<ValueType, Allocator>::lu()
 {
-    matrix<ValueType> res(cols, rows);
-    for (int i = 0; i < rows; i++)
-        for (int j = 0; j < cols; j++)
-            res[j][i] = elements[i][j];
+    MATRIX_PROFILE_OP("matrix::lu", rows, cols, 0, matrix_profile::flops::lu(rows),
+                      2.0 * rows * cols * sizeof(ValueType));
+    return matrix_cache::memoize<lu_factorization<ValueType, Allocator>>(matrix_cache::cache_op::lu, 0, *this, [this] {
+        return lu_factorization<ValueType, Allocator>(*this);
+    });
+}
+
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> matrix<ValueType, Allocator>::transpose()
+{
+    MATRIX_PROFILE_OP("matrix::transpose", rows, cols, 0, 0, 2.0 * rows * cols * sizeof(ValueType));
+    matrix<ValueType, Allocator> res(cols, rows);
+    matrix_kernels::transpose(rows, cols, data(), stride, res.data(), res.stride);
     return res;
 }
 
-template <typename ValueType>
-inline ValueType matrix<ValueType>::det()
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::transpose_in_place()
+{
+    MATRIX_PROFILE_OP("matrix::transpose_in_place", rows, cols, 0, 0, 2.0 * rows * cols * sizeof(ValueType));
+    if (rows == cols)
+    {
+        matrix_kernels::transpose_square_in_place(rows, data(), stride);
+        return *this;
+    }
+    // pack the rows so that the buffer is a plain rows x cols array, rows
+    // only move toward the front, which std::copy allows. With stride ==
+    // cols they are packed already, a copy onto itself is not allowed
+    if (stride != cols)
+        for (int i = 1; i < rows; i++)
+            std::copy(data() + static_cast<size_t>(i) * stride,
+                      data() + static_cast<size_t>(i) * stride + cols,
+                      data() + static_cast<size_t>(i) * cols);
+    matrix_kernels::transpose_cycles(rows, cols, data());
+    std::swap(rows, cols);
+    stride = cols;
+    elements.resize(static_cast<size_t>(rows) * cols);
+    return *this;
+}
+
+template <typename ValueType, typename Allocator>
+inline ValueType matrix<ValueType, Allocator>::det()
 {
-    return determinant(*this);
+    if (rows != cols)
+        throw std::length_error("matrix::determinant -> check matrix dimentions");
+    MATRIX_PROFILE_OP("matrix::det", rows, cols, 0, matrix_profile::flops::lu(rows),
+                      2.0 * rows * cols * sizeof(ValueType));
+    return matrix_cache::memoize<ValueType>(matrix_cache::cache_op::det, 0, *this, [this] {
+        return lu_factorization<ValueType, arena_allocator<ValueType>>(*this).det();
+    });
 }
 
-template <typename ValueType>
-inline ValueType matrix<ValueType>::det_recursive()
+template <typename ValueType, typename Allocator>
+inline ValueType matrix<ValueType, Allocator>::det_recursive()
 {
     return determinant_recursive(*this);
 }
 
-template <typename ValueType>
-inline vector<ValueType> matrix<ValueType>::back_sub(vector<ValueType> vec)
+template <typename ValueType, typename Allocator>
+inline vector<ValueType> matrix<ValueType, Allocator>::back_sub(vector<ValueType> vec)
 {
-    return back_substitution(*this, vec);
+    if (rows != cols)
+        throw std::length_error("back_substitution -> check matrix dimentions");
+    MATRIX_PROFILE_OP("matrix::back_sub", rows, cols, 0, matrix_profile::flops::solve(rows),
+                      2.0 * rows * cols * sizeof(ValueType));
+    return lu_factorization<ValueType, arena_allocator<ValueType>>(*this).solve(vec);
 }
 
-template <typename ValueType>
-std::pair<int, int> matrix<ValueType>::check_dim(const vector<vector<ValueType>> &vec)
+template <typename ValueType, typename Allocator>
+std::pair<int, int> matrix<ValueType, Allocator>::check_dim(const vector<vector<ValueType>> &vec)
 {
+    if (vec.empty())
+        return std::make_pair(0, 0);
     int rows = vec.size();
     int cols = vec[0].size();
     for (const auto &row : vec)
@@ -443,289 +649,184 @@ std::pair<int, int> matrix<ValueType>::check_dim(const vector<vector<ValueType>>
     return std::make_pair(rows, cols);
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::replace_row(vector<ValueType> vec, int index)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::replace_row(vector<ValueType> vec, int index)
 {
     if (index < 0 || index >= rows)
         throw std::out_of_range("matrix::replace_row -> trying to acess non existing row");
     if (vec.size() != cols)
         throw std::length_error("matrix::replace_row -> vector.size() must be equal to matrix::cols");
-    elements[index] = vec;
+    (*this)[index] = vec;
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::replace_col(vector<ValueType> vec, int index)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::replace_col(vector<ValueType> vec, int index)
 {
     if (index < 0 || index >= cols)
         throw std::out_of_range("matrix::replace_col -> trying to acess non existing column");
     if (vec.size() != rows)
         throw std::length_error("matrix::replace_col -> vector.size() must be equal to matrix::rows");
-    int i = 0;
-    for (auto &row : elements)
-        row[index] = vec[i++];
+    for (int i = 0; i < rows; i++)
+        elements[static_cast<size_t>(i) * stride + index] = vec[i];
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::push_row(const vector<ValueType> &vec)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::push_row(const vector<ValueType> &vec)
 {
     if (vec.size() != cols)
         throw std::length_error("matrix::push_row -> vector.size() must be equal to matrix::cols");
-    elements.push_back(vec);
+    elements.resize(static_cast<size_t>(rows + 1) * stride);
+    std::copy(vec.begin(), vec.end(), data() + static_cast<size_t>(rows) * stride);
     rows++;
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::push_col(vector<ValueType> vec)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::push_col(vector<ValueType> vec)
 {
     if (vec.size() != rows)
         throw std::length_error("matrix::push_col -> vector.size() must be equal to matrix::rows");
-    int i = 0;
-    for (auto &row : elements)
-        row.push_back(vec[i++]);
-    cols++;
+    if (cols == stride)
+        relayout(rows, cols + 1, padded_stride<ValueType>(cols + 1));
+    else
+        cols++;
+    for (int i = 0; i < rows; i++)
+        elements[static_cast<size_t>(i) * stride + cols - 1] = vec[i];
     return *this;
 }
 
-template <typename ValueType>
-vector<ValueType> matrix<ValueType>::get_row(int index)
+template <typename ValueType, typename Allocator>
+vector<ValueType> matrix<ValueType, Allocator>::get_row(int index)
 {
     if (index < 0 || index >= rows)
         throw std::out_of_range("matrix::get_row -> trying to acess non existing row");
-    return elements[index];
+    return (*this)[index];
 }
 
-template <typename ValueType>
-vector<ValueType> matrix<ValueType>::get_col(int index)
+template <typename ValueType, typename Allocator>
+vector<ValueType> matrix<ValueType, Allocator>::get_col(int index)
 {
     if (index < 0 || index >= cols)
         throw std::out_of_range("matrix::get_col -> trying to acess non existing column");
     vector<ValueType> vec(rows);
-    for (const auto &row : elements)
-        vec.push_back(row[index]);
+    for (int i = 0; i < rows; i++)
+        vec[i] = elements[static_cast<size_t>(i) * stride + index];
     return vec;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::erase_row(int index)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::erase_row(int index)
 {
     if (index < 0 || index >= rows)
         throw std::out_of_range("matrix::erase_row -> trying to erase non existing row");
-    elements.erase(elements.begin() + index);
+    elements.erase(elements.begin() + static_cast<size_t>(index) * stride,
+                   elements.begin() + static_cast<size_t>(index + 1) * stride);
     rows--;
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::erase_col(int index)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::erase_col(int index)
 {
     if (index < 0 || index >= cols)
         throw std::out_of_range("matrix::erase_col -> trying to erase non existing column");
-    for (auto &row : elements)
-        row.erase(row.begin() + index);
+    for (int i = 0; i < rows; i++)
+    {
+        ValueType *row = data() + static_cast<size_t>(i) * stride;
+        std::copy(row + index + 1, row + cols, row + index);
+        row[cols - 1] = ValueType();
+    }
     cols--;
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::swap_rows(int row1, int row2)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::swap_rows(int row1, int row2)
 {
     if ((row1 < 0 || row1 >= rows) || (row2 < 0 || row2 >= rows))
         throw std::out_of_range("matrix::swap_rows -> trying to swap non existing rows");
     if (row1 != row2)
-    {
-        vector<ValueType> temp = elements[row1];
-        replace_row(elements[row2], row1);
-        elements[row2] = temp;
-    }
+        std::swap_ranges((*this)[row1].begin(), (*this)[row1].end(), (*this)[row2].begin());
     return *this;
 }
 
-template <typename ValueType>
-matrix<ValueType> &matrix<ValueType>::swap_cols(int col1, int col2)
+template <typename ValueType, typename Allocator>
+matrix<ValueType, Allocator> &matrix<ValueType, Allocator>::swap_cols(int col1, int col2)
 {
     if ((col1 < 0 || col1 >= cols) || (col1 < 0 || col1 >= cols))
         throw std::out_of_range("matrix::swap_rows -> trying to swap non existing columns");
     if (col1 != col2)
-    {
-        vector<ValueType> temp = get_col(col1);
-        replace_col(get_col(col2), col1);
-        replace_col(temp, col2);
-    }
+        for (int i = 0; i < rows; i++)
+            std::swap(elements[static_cast<size_t>(i) * stride + col1],
+                      elements[static_cast<size_t>(i) * stride + col2]);
     return *this;
 }
 
-template <typename ValueType>
-vector<ValueType> &matrix<ValueType>::operator[](int rowIndex)
+template <typename ValueType, typename Allocator>
+inline matrix_row<ValueType> matrix<ValueType, Allocator>::operator[](int rowIndex)
 {
-    return elements[rowIndex];
+    return matrix_row<ValueType>(data() + static_cast<size_t>(rowIndex) * stride, cols);
 }
 
-template <typename ValueType>
-std::ostream &operator<<(std::ostream &os, const matrix<ValueType> &mat)
+template <typename ValueType, typename Allocator>
+inline matrix_row<const ValueType> matrix<ValueType, Allocator>::operator[](int rowIndex) const
 {
-    for (const auto &items : mat.elements)
-    {
-        for (const auto &element : items)
-            os << element << " ";
-        os << std::endl;
-    }
+    return matrix_row<const ValueType>(data() + static_cast<size_t>(rowIndex) * stride, cols);
+}
+
+template <typename ValueType, typename Allocator>
+std::ostream &operator<<(std::ostream &os, const matrix<ValueType, Allocator> &mat)
+{
+    matrix_format::write_rows(os, mat.data(), mat.rows, mat.cols, mat.stride);
     return os;
 }
 
-template <typename ValueType>
-matrix<ValueType> sub_matrix(matrix<ValueType> mat, int row, int col)
+template <typename ValueType, typename Allocator>
+inline matrix<ValueType, Allocator> sub_matrix(const matrix<ValueType, Allocator> &mat, int row, int col)
 {
-    for (int i = 0; i < mat.get_rows(); i++)
-        mat[i].erase(mat[i].begin() + col);
-    mat.elements.erase(mat.elements.begin() + row);
-    return matrix<ValueType>(std::move(mat.elements));
+    return mat.view().minor(row, col);
 }
 
-template <typename ValueType>
-ValueType determinant_recursive(matrix<ValueType> mat)
+template <typename ValueType, typename Allocator>
+ValueType determinant_recursive(const matrix<ValueType, Allocator> &mat)
 {
     if (mat.get_rows() != mat.get_cols())
         throw std::length_error("matrix::determinant_recursive -> check matrix dimentions");
-    if (mat.get_rows() == 1)
-        return mat[0][0];
-
-    ValueType det = ValueType();
-    ValueType sign = 1;
-    for (int i = 0; i < mat.get_cols(); i++)
-    {
-        det += mat[0][i] * determinant_recursive(sub_matrix(mat, 0, i)) * sign;
-        sign = -sign;
-    }
-    return det;
+    MATRIX_PROFILE_OP("determinant_recursive", mat.get_rows(), mat.get_cols(), 0,
+                      mat.get_rows() > matrix_kernels::det_subset_max && matrix_kernels::det_is_inexact<ValueType>::value
+                          ? matrix_profile::flops::lu(mat.get_rows())
+                          : matrix_profile::flops::det_division_free(mat.get_rows()),
+                      static_cast<double>(mat.get_rows()) * mat.get_cols() * sizeof(ValueType));
+    return matrix_cache::memoize<ValueType>(matrix_cache::cache_op::det_recursive, 0, mat, [&mat] {
+        if (mat.get_rows() > matrix_kernels::det_subset_max && matrix_kernels::det_is_inexact<ValueType>::value)
+            return lu_factorization<ValueType, arena_allocator<ValueType>>(mat).det();
+        return matrix_kernels::det_division_free(mat.get_rows(), mat.data(), mat.get_stride());
+    });
 }
 
-template <typename ValueType>
-ValueType determinant(matrix<ValueType> mat)
+template <typename ValueType, typename Allocator>
+ValueType determinant(matrix<ValueType, Allocator> mat)
 {
-    using namespace vector_arithmetic_operations;
-
     if (mat.get_rows() != mat.get_cols())
         throw std::length_error("matrix::determinant -> check matrix dimentions");
-    ValueType sign = 1;
-    for (int i = 0; i < mat.get_rows(); i++)
-    {
-        // find max in this col
-        ValueType max = mat[i][i];
-        int index_max = i;
-        for (int k = i + 1; k < mat.get_rows(); k++)
-        {
-            if (abs(mat[k][i]) > abs(max))
-            {
-                max = mat[k][i];
-                index_max = k;
-            }
-        }
-        // swap the max to the beginging
-        if (index_max != i)
-        {
-            mat.swap_rows(i, index_max);
-            sign -= 1;
-        }
-        // elemenate the numbers blow
-        for (int j = i + 1; j < mat.get_rows(); j++)
-        {
-            mat[j] += mat[i] * (-mat[j][i] / mat[i][i]);
-            mat[j][i] = 0;
-        }
-    }
-    // calc the determinant
-    ValueType det_val = static_cast<ValueType>(1);
-    for (int i = 0; i < mat.get_rows(); i++)
-        det_val *= mat[i][i];
-    return det_val * sign;
+    MATRIX_PROFILE_OP("determinant", mat.get_rows(), mat.get_cols(), 0, matrix_profile::flops::lu(mat.get_rows()),
+                      2.0 * mat.get_rows() * mat.get_cols() * sizeof(ValueType));
+    return matrix_cache::memoize<ValueType>(matrix_cache::cache_op::det, 0, mat, [&mat] {
+        return lu_factorization<ValueType, Allocator>(std::move(mat)).det();
+    });
 }
 
-template <typename ValueType>
-vector<ValueType> back_substitution(matrix<ValueType> mat, vector<ValueType> vec)
+template <typename ValueType, typename Allocator>
+vector<ValueType> back_substitution(matrix<ValueType, Allocator> mat, vector<ValueType> vec)
 {
-    using namespace vector_arithmetic_operations;
-
     if (mat.get_rows() != mat.get_cols())
         throw std::length_error("back_substitution -> check matrix dimentions");
-    mat.push_col(vec);
-    for (int i = 0; i < mat.get_rows(); i++)
-    {
-        ValueType max = mat[i][i];
-        int index_max = i;
-        for (int k = i + 1; k < mat.get_rows(); k++)
-        {
-            if (abs(mat[k][i]) > abs(max))
-            {
-                max = mat[k][i];
-                index_max = k;
-            }
-        }
-        mat.swap_rows(i, index_max);
-        for (int j = i + 1; j < mat.get_rows(); j++)
-        {
-            mat[j] += mat[i] * (-mat[j][i] / mat[i][i]);
-            mat[j][i] = 0;
-        }
-    }
-    vec = mat.get_col(mat.get_cols() - 1);
-    for (int i = mat.get_rows() - 1; i >= 0; i--)
-    {
-        for (int j = i + 1; j < mat.get_rows(); j++)
-            vec[i] -= mat[i][j] * vec[j];
-        vec[i] /= mat[i][i];
-    }
-    return vec;
-}
-
-template <typename ValueType>
-inline matrix<ValueType> operator+(matrix<ValueType> m1, const matrix<ValueType> &m2)
-{
-    return m1 += m2;
-}
-
-template <typename ValueType>
-inline matrix<ValueType> operator-(matrix<ValueType> m1, const matrix<ValueType> &m2)
-{
-    return m1 -= m2;
-}
-
-template <typename ValueType>
-inline matrix<ValueType> operator*(matrix<ValueType> m1, const matrix<ValueType> &m2)
-{
-    return m1 *= m2;
-}
-
-template <typename ValueType>
-inline matrix<ValueType> operator/(matrix<ValueType> m1, const matrix<ValueType> &m2)
-{
-    return m1 /= m2;
-}
-
-template <typename ValueType>
-matrix<ValueType> operator+(matrix<ValueType> m1, const ValueType val)
-{
-    return m1 += val;
-}
-
-template <typename ValueType>
-inline matrix<ValueType> operator-(matrix<ValueType> m1, const ValueType val)
-{
-    return m1 -= val;
-}
-
-template <typename ValueType>
-inline matrix<ValueType> operator*(matrix<ValueType> m1, const ValueType val)
-{
-    return m1 *= val;
-}
-
-template <typename ValueType>
-inline matrix<ValueType> operator/(matrix<ValueType> m1, const ValueType val)
-{
-    return m1 /= val;
+    MATRIX_PROFILE_OP("back_substitution", mat.get_rows(), mat.get_cols(), 0,
+                      matrix_profile::flops::solve(mat.get_rows()),
+                      2.0 * mat.get_rows() * mat.get_cols() * sizeof(ValueType));
+    return lu_factorization<ValueType, Allocator>(std::move(mat)).solve(vec);
 }
 
 #endif // End of the file
\ No newline at end of file
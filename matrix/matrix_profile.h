@@ -0,0 +1,507 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_profile.h
+ * @brief
+ *
+ * This file provides the instrumentation of the operations of the
+ * <code>matrix</code> class: multiply, invert, lu, det, determinant,
+ * determinant_recursive, power, transpose, back_substitution, the
+ * element-wise operators and the evaluation of expressions.
+ *
+ * It is compiled in with MATRIX_PROFILE defined (make PROFILE=1). Every
+ * call of an operation is then recorded, with its wall time, its shape,
+ * its FLOPs and the bytes it reads and writes, and whether its result
+ * came from the result cache (see matrix_cache.h). Times are inclusive,
+ * power includes the invert it calls. Without MATRIX_PROFILE the macros
+ * are empty, their arguments are not even evaluated, and the functions
+ * below do nothing.
+ *
+ * The FLOPs are the models of the flops namespace, a complex operation
+ * counts as one; a call answered by the cache counts none. Expressions
+ * count the bytes they write and no FLOPs.
+ *
+ * The results are read with <code>matrix_profile::get_stats()</code>,
+ * printed as a table with <code>matrix_profile::report()</code>, and
+ * written as a Chrome trace (chrome://tracing, ui.perfetto.dev) with
+ * <code>matrix_profile::write_trace()</code>. At exit, the table is
+ * printed to the standard error if MATRIX_PROFILE_REPORT is set, and the
+ * trace written to the file MATRIX_PROFILE_TRACE names. The trace keeps
+ * the first MATRIX_PROFILE_EVENTS calls, 1000000 by default, the table
+ * counts them all.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _MATRIX_PROFILE_H_
+#define _MATRIX_PROFILE_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#ifdef MATRIX_PROFILE
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#endif
+
+namespace matrix_profile
+{
+    /**
+     * The FLOP models of the operations, one per addition or multiplication
+     */
+    namespace flops
+    {
+        inline double gemm(double m, double n, double k)
+        {
+            return 2 * m * n * k;
+        }
+
+        inline double lu(double n)
+        {
+            return 2 * n * n * n / 3;
+        }
+
+        /**
+         * the factorization and n solves
+         */
+        inline double inverse(double n)
+        {
+            return 2 * n * n * n;
+        }
+
+        inline double solve(double n)
+        {
+            return lu(n) + 2 * n * n;
+        }
+
+        /**
+         * @returns the products of the binary exponentiation
+         */
+        inline double power_products(long long e)
+        {
+            const unsigned long long u = e < 0 ? -static_cast<unsigned long long>(e) : e;
+            if (!u)
+                return 0;
+            // a squaring per bit after the highest, a product per extra set bit
+            return (63 - __builtin_clzll(u)) + (__builtin_popcountll(u) - 1);
+        }
+
+        /**
+         * the kernels of determinant_recursive, see determinant_kernels.h
+         */
+        inline double det_division_free(double n)
+        {
+            if (n <= 4)
+                return n * n;
+            if (n <= 16)
+                return n * static_cast<double>(1u << static_cast<int>(n));
+            return n * n * n * n / 2;
+        }
+    }
+
+    /**
+     * The calls of an operation on one shape
+     */
+    struct op_stats
+    {
+        std::string name;
+        /**
+         * the shape of the first operand, other_cols is the number of
+         * columns of the second one for multiply, 0 otherwise
+         */
+        int rows;
+        int cols;
+        int other_cols;
+        long long calls;
+        long long cache_hits;
+        /**
+         * total and longest nanoseconds
+         */
+        double ns;
+        double max_ns;
+        double flops;
+        double bytes;
+    };
+
+#ifdef MATRIX_PROFILE
+
+    constexpr bool enabled = true;
+
+    class profiler
+    {
+    public:
+      using clock = std::chrono::steady_clock;
+
+      struct event
+      {
+        const char *name;
+        int rows;
+        int cols;
+        int other_cols;
+        bool cache_hit;
+        double flops;
+        double bytes;
+        std::int64_t start;
+        std::int64_t duration;
+      };
+
+      /**
+         * @returns the profiler shared by the library
+         */
+      static profiler &instance()
+      {
+        static profiler prof;
+        return prof;
+      }
+
+      /**
+         * @returns the nanoseconds since the profiler started
+         */
+      std::int64_t now() const
+      {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - epoch).count();
+      }
+
+      void record(const event &e)
+      {
+        buffer &buf = local_buffer();
+        std::lock_guard<std::mutex> lock(buf.mtx);
+        op_totals &t = buf.totals[{e.name, e.rows, e.cols, e.other_cols}];
+        t.calls++;
+        t.cache_hits += e.cache_hit;
+        t.ns += e.duration;
+        t.max_ns = std::max(t.max_ns, static_cast<double>(e.duration));
+        t.flops += e.flops;
+        t.bytes += e.bytes;
+        if (recorded.fetch_add(1, std::memory_order_relaxed) < max_events)
+          buf.events.push_back(e);
+      }
+
+      /**
+         * @returns the statistics of every operation and shape, the
+         *          longest total time first
+         */
+      std::vector<op_stats> stats()
+      {
+        std::map<std::tuple<std::string, int, int, int>, op_stats> merged;
+        for (const std::shared_ptr<buffer> &buf : snapshot())
+        {
+          std::lock_guard<std::mutex> lock(buf->mtx);
+          for (const auto &entry : buf->totals)
+          {
+            const key &k = entry.first;
+            const op_totals &t = entry.second;
+            op_stats &s = merged[std::make_tuple(std::string(k.name), k.rows, k.cols, k.other_cols)];
+            if (s.name.empty())
+              s = {k.name, k.rows, k.cols, k.other_cols, 0, 0, 0, 0, 0, 0};
+            s.calls += t.calls;
+            s.cache_hits += t.cache_hits;
+            s.ns += t.ns;
+            s.max_ns = std::max(s.max_ns, t.max_ns);
+            s.flops += t.flops;
+            s.bytes += t.bytes;
+          }
+        }
+        std::vector<op_stats> res;
+        for (auto &entry : merged)
+          res.push_back(std::move(entry.second));
+        std::stable_sort(res.begin(), res.end(),
+                         [](const op_stats &a, const op_stats &b) { return a.ns > b.ns; });
+        return res;
+      }
+
+      /**
+         * Writes the recorded calls in the Chrome trace event format
+         * @returns false if the file can't be written
+         */
+      bool write_trace(const std::string &path)
+      {
+        std::ofstream out(path);
+        if (!out)
+          return false;
+        out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+        bool first = true;
+        char line[512];
+        for (const std::shared_ptr<buffer> &buf : snapshot())
+        {
+          std::lock_guard<std::mutex> lock(buf->mtx);
+          for (const event &e : buf->events)
+          {
+            std::snprintf(line, sizeof(line),
+                          "%s{\"name\": \"%s\", \"cat\": \"matrix\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                          "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"shape\": \"%s\", \"flops\": %.0f, "
+                          "\"bytes\": %.0f, \"cache_hit\": %s}}",
+                          first ? "" : ",\n", e.name, buf->tid, e.start / 1e3, e.duration / 1e3,
+                          shape(e.rows, e.cols, e.other_cols).c_str(), e.flops, e.bytes,
+                          e.cache_hit ? "true" : "false");
+            out << line;
+            first = false;
+          }
+        }
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+      }
+
+      /**
+         * Drops what was recorded so far
+         */
+      void reset()
+      {
+        for (const std::shared_ptr<buffer> &buf : snapshot())
+        {
+          std::lock_guard<std::mutex> lock(buf->mtx);
+          buf->totals.clear();
+          buf->events.clear();
+        }
+        recorded = 0;
+      }
+
+      static std::string shape(int rows, int cols, int other_cols)
+      {
+        std::string res = std::to_string(rows) + "x" + std::to_string(cols);
+        if (other_cols)
+          res += " * " + std::to_string(cols) + "x" + std::to_string(other_cols);
+        return res;
+      }
+
+    private:
+      struct key
+      {
+        const char *name;
+        int rows;
+        int cols;
+        int other_cols;
+
+        bool operator==(const key &k) const
+        {
+          return name == k.name && rows == k.rows && cols == k.cols && other_cols == k.other_cols;
+        }
+      };
+
+      struct key_hash
+      {
+        std::size_t operator()(const key &k) const
+        {
+          std::size_t h = std::hash<const void *>()(k.name);
+          for (int v : {k.rows, k.cols, k.other_cols})
+            h = h * 0x9e3779b97f4a7c15ULL + static_cast<unsigned>(v);
+          return h;
+        }
+      };
+
+      struct op_totals
+      {
+        long long calls = 0;
+        long long cache_hits = 0;
+        double ns = 0;
+        double max_ns = 0;
+        double flops = 0;
+        double bytes = 0;
+      };
+
+      /**
+         * What one thread recorded, its lock is only contended while the
+         * results are read
+         */
+      struct buffer
+      {
+        std::mutex mtx;
+        int tid;
+        std::unordered_map<key, op_totals, key_hash> totals;
+        std::vector<event> events;
+      };
+
+      profiler() : epoch(clock::now())
+      {
+        const char *events = std::getenv("MATRIX_PROFILE_EVENTS");
+        if (events)
+          max_events = std::strtoll(events, nullptr, 10);
+      }
+
+      ~profiler();
+
+      buffer &local_buffer()
+      {
+        thread_local std::shared_ptr<buffer> buf;
+        if (!buf)
+        {
+          buf = std::make_shared<buffer>();
+          std::lock_guard<std::mutex> lock(mtx);
+          buf->tid = static_cast<int>(buffers.size()) + 1;
+          buffers.push_back(buf);
+        }
+        return *buf;
+      }
+
+      std::vector<std::shared_ptr<buffer>> snapshot()
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        return buffers;
+      }
+
+      const clock::time_point epoch;
+      long long max_events = 1000000;
+      std::atomic<long long> recorded{0};
+      std::mutex mtx;
+      std::vector<std::shared_ptr<buffer>> buffers;
+    };
+
+    /**
+     * Records the call of an operation from its construction to its
+     * destruction, the innermost one of a thread is marked by cache_hit
+     */
+    class scope
+    {
+    public:
+      scope(const char *name, int rows, int cols, int other_cols, double flops, double bytes)
+          : e{name, rows, cols, other_cols, false, flops, bytes, profiler::instance().now(), 0},
+            parent(current())
+      {
+        current() = this;
+      }
+
+      scope(const scope &) = delete;
+
+      scope &operator=(const scope &) = delete;
+
+      ~scope()
+      {
+        current() = parent;
+        profiler &prof = profiler::instance();
+        e.duration = prof.now() - e.start;
+        if (e.cache_hit)
+          e.flops = 0;
+        prof.record(e);
+      }
+
+      static scope *&current()
+      {
+        thread_local scope *innermost = nullptr;
+        return innermost;
+      }
+
+      profiler::event e;
+
+    private:
+      scope *parent;
+    };
+
+    /**
+     * Marks the current call as answered by the result cache
+     */
+    inline void cache_hit()
+    {
+        if (scope *s = scope::current())
+            s->e.cache_hit = true;
+    }
+
+    inline std::vector<op_stats> get_stats()
+    {
+        return profiler::instance().stats();
+    }
+
+    /**
+     * Prints the statistics as a table, the longest total time first
+     */
+    inline void report(std::ostream &os)
+    {
+        const std::vector<op_stats> stats = get_stats();
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-30s %-20s %10s %8s %12s %12s %10s %10s\n", "operation", "shape",
+                      "calls", "hits", "total ms", "mean us", "GFLOP/s", "GB/s");
+        os << line;
+        for (const op_stats &s : stats)
+        {
+            std::snprintf(line, sizeof(line), "%-30s %-20s %10lld %8lld %12.3f %12.3f %10.3f %10.3f\n",
+                          s.name.c_str(), profiler::shape(s.rows, s.cols, s.other_cols).c_str(), s.calls,
+                          s.cache_hits, s.ns / 1e6, s.ns / 1e3 / s.calls, s.ns ? s.flops / s.ns : 0.0,
+                          s.ns ? s.bytes / s.ns : 0.0);
+            os << line;
+        }
+    }
+
+    inline profiler::~profiler()
+    {
+        const char *trace = std::getenv("MATRIX_PROFILE_TRACE");
+        if (trace && *trace && !write_trace(trace))
+            std::cerr << "matrix_profile -> cannot write " << trace << '\n';
+        if (std::getenv("MATRIX_PROFILE_REPORT"))
+            report(std::cerr);
+    }
+
+    /**
+     * Writes the recorded calls as a Chrome trace
+     * @returns false if the file can't be written
+     */
+    inline bool write_trace(const std::string &path)
+    {
+        return profiler::instance().write_trace(path);
+    }
+
+    inline void reset()
+    {
+        profiler::instance().reset();
+    }
+
+#else
+
+    constexpr bool enabled = false;
+
+    inline void cache_hit()
+    {
+    }
+
+    inline std::vector<op_stats> get_stats()
+    {
+        return {};
+    }
+
+    inline void report(std::ostream &os)
+    {
+        os << "matrix_profile -> built without MATRIX_PROFILE\n";
+    }
+
+    inline bool write_trace(const std::string &)
+    {
+        return false;
+    }
+
+    inline void reset()
+    {
+    }
+
+#endif
+}
+
+/**
+ * Records the enclosing call of an operation, once per function body
+ */
+#ifdef MATRIX_PROFILE
+#define MATRIX_PROFILE_OP(NAME, ROWS, COLS, OTHER_COLS, FLOPS, BYTES) \
+    matrix_profile::scope matrix_profile_scope_(NAME, ROWS, COLS, OTHER_COLS, FLOPS, BYTES)
+#define MATRIX_PROFILE_CACHE_HIT() matrix_profile::cache_hit()
+#else
+#define MATRIX_PROFILE_OP(NAME, ROWS, COLS, OTHER_COLS, FLOPS, BYTES) static_cast<void>(0)
+#define MATRIX_PROFILE_CACHE_HIT() static_cast<void>(0)
+#endif
+
+#endif // End of the file
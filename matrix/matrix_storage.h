@@ -0,0 +1,199 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_storage.h
+ * @brief
+ *
+ * This file provides the building blocks of the <code>matrix</code> storage:
+ * an aligned allocator used for the contiguous element buffer, the helper
+ * that computes the padded leading dimension (stride) of a row, and the
+ * lightweight row proxy returned by <code>matrix::operator[]</code>.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _MATRIX_STORAGE_H_
+#define _MATRIX_STORAGE_H_
+
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+
+using std::vector;
+
+/**
+ * Alignment in bytes of the matrix buffers, one cache line
+ */
+constexpr std::size_t matrix_alignment = 64;
+
+/**
+ * STL allocator that returns memory aligned to a given boundary
+ * so that every matrix buffer starts on a cache line.
+ */
+template <typename ValueType, std::size_t Alignment = matrix_alignment>
+class aligned_allocator
+{
+public:
+  using value_type = ValueType;
+
+  template <typename U>
+  struct rebind
+  {
+    using other = aligned_allocator<U, Alignment>;
+  };
+
+  aligned_allocator() noexcept = default;
+
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U, Alignment> &) noexcept {}
+
+  ValueType *allocate(std::size_t n)
+  {
+    return static_cast<ValueType *>(
+        ::operator new(n * sizeof(ValueType), std::align_val_t(Alignment)));
+  }
+
+  void deallocate(ValueType *p, std::size_t) noexcept
+  {
+    ::operator delete(p, std::align_val_t(Alignment));
+  }
+
+  template <typename U>
+  bool operator==(const aligned_allocator<U, Alignment> &) const noexcept
+  {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const aligned_allocator<U, Alignment> &) const noexcept
+  {
+    return false;
+  }
+};
+
+/**
+ * @returns the leading dimension used to store a row of <code>cols</code>
+ *          elements. Rows wider than a cache line are padded to a whole
+ *          number of cache lines, and strides that are a multiple of the
+ *          page size get an extra line to avoid 4K aliasing between rows.
+ * @bigoh   O(1)
+ */
+template <typename ValueType>
+inline int padded_stride(int cols)
+{
+    if (sizeof(ValueType) > matrix_alignment || matrix_alignment % sizeof(ValueType))
+        return cols;
+    const int per_line = matrix_alignment / sizeof(ValueType);
+    if (cols < per_line)
+        return cols;
+    int stride = (cols + per_line - 1) / per_line * per_line;
+    if ((stride * sizeof(ValueType)) % 4096 == 0)
+        stride += per_line;
+    return stride;
+}
+
+/**
+ * Declarations of the allocator aware matrix types, the default
+ * allocator is declared here once
+ */
+template <typename ValueType, typename Allocator = aligned_allocator<ValueType>>
+class matrix;
+
+template <typename ValueType, typename Allocator = aligned_allocator<ValueType>>
+class lu_factorization;
+
+template <typename ValueType>
+class matrix_view;
+
+/**
+ * Non owning reference to a row of a matrix.
+ * It behaves like a fixed size array: elements are accessed with
+ * <code>[]</code>, it can be iterated, assigned from / converted to
+ * an STL vector, and assigning a row to another copies the elements.
+ */
+template <typename ValueType>
+class matrix_row
+{
+public:
+  using value_type = typename std::remove_const<ValueType>::type;
+  using iterator = ValueType *;
+
+  matrix_row(ValueType *data, int size) : ptr(data), len(size) {}
+
+  matrix_row(const matrix_row &row) = default;
+
+  /**
+     * Copies the elements of another row into this one
+     * @throw length_error if the sizes are not the same
+     * @bigoh O(size)
+     */
+  matrix_row &operator=(const matrix_row &row)
+  {
+    if (row.len != len)
+      throw std::length_error("matrix_row -> rows must be the same size");
+    std::copy(row.ptr, row.ptr + len, ptr);
+    return *this;
+  }
+
+  /**
+     * Copies the elements of a read only row into this one
+     * @throw length_error if the sizes are not the same
+     * @bigoh O(size)
+     */
+  template <typename OtherType>
+  matrix_row &operator=(const matrix_row<OtherType> &row)
+  {
+    if (row.size() != len)
+      throw std::length_error("matrix_row -> rows must be the same size");
+    std::copy(row.begin(), row.end(), ptr);
+    return *this;
+  }
+
+  /**
+     * Copies the elements of an STL vector into the row
+     * @throw length_error if the sizes are not the same
+     * @bigoh O(size)
+     */
+  matrix_row &operator=(const vector<value_type> &vec)
+  {
+    if (vec.size() != static_cast<std::size_t>(len))
+      throw std::length_error("matrix_row -> vector.size() must be equal to row size");
+    std::copy(vec.begin(), vec.end(), ptr);
+    return *this;
+  }
+
+  /**
+     * @returns a copy of the row as an STL vector
+     * @bigoh O(size)
+     */
+  operator vector<value_type>() const
+  {
+    return vector<value_type>(ptr, ptr + len);
+  }
+
+  ValueType &operator[](int index) const { return ptr[index]; }
+
+  int size() const { return len; }
+
+  ValueType *data() const { return ptr; }
+
+  iterator begin() const { return ptr; }
+
+  iterator end() const { return ptr + len; }
+
+private:
+  ValueType *ptr;
+  int len;
+};
+
+#endif // End of the file
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_transpose.h
+ * @brief
+ *
+ * This file implements the transpose kernels used by
+ * <code>matrix::transpose</code> and <code>matrix::transpose_in_place</code>.
+ *
+ *  - out of place: cache-oblivious recursion that halves the longer side
+ *    until the block fits in L1, so reads and writes both stay local
+ *  - in place, square: tiles above the diagonal are swapped with their
+ *    mirror tiles below it, diagonal tiles are transposed on themselves
+ *  - in place, non-square: cycle-following on the packed (stride == cols)
+ *    buffer, using one bit per element to mark moved elements
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _MATRIX_TRANSPOSE_H_
+#define _MATRIX_TRANSPOSE_H_
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+#include "thread_pool.h"
+#include "matrix_arena.h"
+
+namespace matrix_kernels
+{
+    /**
+     * Side of the blocks transposed directly, a source and a destination
+     * block of doubles fit in L1 together
+     */
+    constexpr int transpose_tile = 32;
+
+    /**
+     * dst(j, i) = src(i, j) for a (rows x cols) block of src
+     */
+    template <typename ValueType>
+    void transpose_recursive(int rows, int cols, const ValueType *src, std::size_t lds,
+                             ValueType *dst, std::size_t ldd)
+    {
+        if (rows <= transpose_tile && cols <= transpose_tile)
+        {
+            for (int i = 0; i < rows; i++)
+                for (int j = 0; j < cols; j++)
+                    dst[j * ldd + i] = src[i * lds + j];
+            return;
+        }
+        if (rows >= cols)
+        {
+            const int half = rows / 2;
+            transpose_recursive(half, cols, src, lds, dst, ldd);
+            transpose_recursive(rows - half, cols, src + half * lds, lds, dst + half, ldd);
+        }
+        else
+        {
+            const int half = cols / 2;
+            transpose_recursive(rows, half, src, lds, dst, ldd);
+            transpose_recursive(rows, cols - half, src + half, lds, dst + half * ldd, ldd);
+        }
+    }
+
+    /**
+     * Writes the transpose of the (rows x cols) matrix src into dst,
+     * bands of source columns are shared between the threads
+     */
+    template <typename ValueType>
+    void transpose(int rows, int cols, const ValueType *src, std::size_t lds,
+                   ValueType *dst, std::size_t ldd)
+    {
+        constexpr int band = 4 * transpose_tile;
+        const int bands = (cols + band - 1) / band;
+        const std::size_t work = static_cast<std::size_t>(rows) * cols;
+        matrix_parallel::parallel_for(0, bands, work, [&](int first, int last) {
+            const int col = first * band;
+            const int width = std::min(cols, last * band) - col;
+            transpose_recursive(rows, width, src + col, lds, dst + col * ldd, ldd);
+        });
+    }
+
+    /**
+     * Transposes the (n x n) matrix a in place
+     */
+    template <typename ValueType>
+    void transpose_square_in_place(int n, ValueType *a, std::size_t lda)
+    {
+        constexpr int tile = transpose_tile;
+        const int tiles = (n + tile - 1) / tile;
+        const std::size_t work = static_cast<std::size_t>(n) * n;
+        matrix_parallel::parallel_for(0, tiles, work, [&](int first, int last) {
+            using std::swap;
+            for (int bi = first; bi < last; bi++)
+            {
+                const int i0 = bi * tile;
+                const int i1 = std::min(n, i0 + tile);
+                // the diagonal tile and the tiles on its right, swapped with
+                // their mirrors below the diagonal
+                for (int j0 = i0; j0 < n; j0 += tile)
+                {
+                    const int j1 = std::min(n, j0 + tile);
+                    for (int i = i0; i < i1; i++)
+                        for (int j = std::max(j0, i + 1); j < j1; j++)
+                            swap(a[i * lda + j], a[j * lda + i]);
+                }
+            }
+        });
+    }
+
+    /**
+     * Transposes the packed (rows x cols) matrix a in place, the result is
+     * packed (cols x rows). Element at position p moves to p * rows mod
+     * (rows * cols - 1), every cycle of that permutation is followed once.
+     * @bigoh O(rows x columns) time, rows x columns bits of extra memory
+     */
+    template <typename ValueType>
+    void transpose_cycles(int rows, int cols, ValueType *a)
+    {
+        const std::size_t size = static_cast<std::size_t>(rows) * cols;
+        if (rows <= 1 || cols <= 1)
+            return;
+        const std::size_t last = size - 1;
+        std::vector<bool, arena_allocator<bool>> moved(size);
+        for (std::size_t start = 1; start < last; start++)
+        {
+            if (moved[start])
+                continue;
+            ValueType val = std::move(a[start]);
+            std::size_t pos = start;
+            do
+            {
+                const std::size_t next = pos * rows % last;
+                std::swap(a[next], val);
+                moved[pos] = true;
+                pos = next;
+            } while (pos != start);
+        }
+    }
+}
+
+#endif // End of the file
@@ -0,0 +1,398 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_view.h
+ * @brief
+ *
+ * This file provides the <code>matrix_view</code> class, a non owning
+ * strided window over the elements of a <code>matrix</code>. Element
+ * (i, j) of a view lives at <code>data[i * row_stride + j * col_stride]</code>,
+ * which is enough to express a row, a column, a block or a transpose
+ * without copying. A view can also hide one row and one column, which
+ * gives the minors used by the cofactor expansion.
+ *
+ * Views are expressions: they mix with matrices in the element-wise
+ * operators, and <code>multiply</code> and the LU solvers accept them.
+ * A view does not keep the matrix alive, and resizing the matrix
+ * invalidates its views.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _MATRIX_VIEW_H_
+#define _MATRIX_VIEW_H_
+
+#include <limits>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+#include "matrix_def.h"
+#include "matrix_expr.h"
+#include "matrix_gemm.h"
+#include "matrix_arena.h"
+
+template <typename ValueType>
+class matrix_view : public matrix_expr<matrix_view<ValueType>>
+{
+public:
+  using value_type = typename std::remove_const<ValueType>::type;
+
+  /**
+     * View of rows x cols elements, element (i, j) at
+     * data[i * row_stride + j * col_stride]
+     */
+  matrix_view(ValueType *data, int rows, int cols, int row_stride, int col_stride = 1);
+
+  /**
+     * A view of modifiable elements is also a read only view
+     */
+  template <typename OtherType,
+            typename = typename std::enable_if<std::is_same<const OtherType, ValueType>::value>::type>
+  matrix_view(const matrix_view<OtherType> &view);
+
+  matrix_view(const matrix_view &view) = default;
+
+  /**
+     * Copies the elements of another view of the same dimensions
+     * into this one, the view itself is not rebound
+     * @throw length_error if the dimensions are not the same
+     * @bigoh O(rows x columns)
+     */
+  matrix_view &operator=(const matrix_view &view);
+
+  /**
+     * Evaluates an expression into the viewed elements. When the
+     * expression reads the same elements in another layout (e.g. a
+     * transpose of the destination), it is evaluated into a temporary first.
+     * @throw length_error if the dimensions are not the same
+     * @bigoh O(rows x columns)
+     */
+  template <typename Expr>
+  matrix_view &operator=(const matrix_expr<Expr> &expr);
+
+  /**
+     * Copies a matrix of the same dimensions into the viewed elements
+     * @throw length_error if the dimensions are not the same
+     * @bigoh O(rows x columns)
+     */
+  template <typename Allocator>
+  matrix_view &operator=(const matrix<value_type, Allocator> &mat);
+
+  /**
+     * @returns a reference to element (i, j), no bounds checking
+     */
+  ValueType &operator()(int i, int j) const;
+
+  value_type coeff(int i, int j) const;
+
+  /**
+     * @returns a view of row(index)
+     * @throw   out_of_range if index out of range
+     * @bigoh   O(1)
+     */
+  matrix_view row(int index) const;
+
+  /**
+     * @returns a view of col(index)
+     * @throw   out_of_range if index out of range
+     * @bigoh   O(1)
+     */
+  matrix_view col(int index) const;
+
+  /**
+     * @returns a view of the (num_rows x num_cols) block whose
+     *          top left element is (row, col)
+     * @throw   out_of_range if the block is not inside the view
+     * @bigoh   O(1)
+     */
+  matrix_view block(int row, int col, int num_rows, int num_cols) const;
+
+  /**
+     * @returns a view without the specified row and col
+     * @throw   out_of_range if row or col out of range, or if
+     *          the view already hides a row or a column
+     * @bigoh   O(1)
+     */
+  matrix_view minor(int row, int col) const;
+
+  /**
+     * @returns the transposed view, nothing is copied
+     * @bigoh   O(1)
+     */
+  matrix_view transpose() const;
+
+  /**
+     * Multiply the viewed matrix with another view or matrix
+     * @throw   length_error if columns != mat.rows
+     * @returns a new matrix results from multiplication
+     * @bigoh O(rows x columns x mat.columns)
+     */
+  template <typename OtherType>
+  matrix<value_type> multiply(const matrix_view<OtherType> &view) const;
+
+  template <typename Allocator>
+  matrix<value_type> multiply(const matrix<value_type, Allocator> &mat) const;
+
+  /**
+     * LU factorization of the viewed matrix
+     * @throw   length_error if columns != rows
+     * @bigoh O(rows^3)
+     */
+  lu_factorization<value_type> lu() const;
+
+  int get_rows() const { return rows; }
+
+  int get_cols() const { return cols; }
+
+  int get_row_stride() const { return row_stride; }
+
+  int get_col_stride() const { return col_stride; }
+
+  ValueType *data() const { return ptr; }
+
+  /**
+     * @returns true if the view hides a row or a column, such views
+     *          can't be described by strides alone
+     */
+  bool is_minor() const { return skip_row != no_skip || skip_col != no_skip; }
+
+  /**
+     * @returns true if writing through this view while reading src may read
+     *          elements already overwritten: the views overlap in memory
+     *          with a different layout
+     */
+  bool conflicts_with(const matrix_view<const value_type> &src) const;
+
+  /**
+     * @helper used by the expression nodes
+     */
+  template <typename View>
+  bool aliases(const View &dst) const { return dst.conflicts_with(*this); }
+
+private:
+  template <typename OtherType>
+  friend class matrix_view;
+
+  static constexpr int no_skip = std::numeric_limits<int>::max();
+
+  int physical_row(int i) const { return i + (i >= skip_row); }
+
+  int physical_col(int j) const { return j + (j >= skip_col); }
+
+  /**
+     * Calls fn(i, j, a[i][j]) on every element, a is a copy of this view
+     * when src conflicts with it
+     */
+  template <typename Expr, typename Function>
+  void evaluate(const Expr &expr, Function fn) const;
+
+  static void gemm_into(const matrix_view<const value_type> &a, const matrix_view<const value_type> &b,
+                        matrix<value_type> &res);
+
+  ValueType *ptr;
+  int rows;
+  int cols;
+  int row_stride;
+  int col_stride;
+  int skip_row;
+  int skip_col;
+};
+
+template <typename ValueType>
+matrix_view<ValueType>::matrix_view(ValueType *data, int rows, int cols, int row_stride, int col_stride)
+    : ptr(data), rows(rows), cols(cols), row_stride(row_stride), col_stride(col_stride),
+      skip_row(no_skip), skip_col(no_skip)
+{
+}
+
+template <typename ValueType>
+template <typename OtherType, typename>
+matrix_view<ValueType>::matrix_view(const matrix_view<OtherType> &view)
+    : ptr(view.ptr), rows(view.rows), cols(view.cols), row_stride(view.row_stride),
+      col_stride(view.col_stride), skip_row(view.skip_row), skip_col(view.skip_col)
+{
+}
+
+template <typename ValueType>
+inline ValueType &matrix_view<ValueType>::operator()(int i, int j) const
+{
+    return ptr[static_cast<std::ptrdiff_t>(physical_row(i)) * row_stride +
+               static_cast<std::ptrdiff_t>(physical_col(j)) * col_stride];
+}
+
+template <typename ValueType>
+inline typename matrix_view<ValueType>::value_type matrix_view<ValueType>::coeff(int i, int j) const
+{
+    return (*this)(i, j);
+}
+
+template <typename ValueType>
+matrix_view<ValueType> matrix_view<ValueType>::row(int index) const
+{
+    if (index < 0 || index >= rows)
+        throw std::out_of_range("matrix_view::row -> trying to acess non existing row");
+    matrix_view res(ptr + static_cast<std::ptrdiff_t>(physical_row(index)) * row_stride,
+                    1, cols, row_stride, col_stride);
+    res.skip_col = skip_col;
+    return res;
+}
+
+template <typename ValueType>
+matrix_view<ValueType> matrix_view<ValueType>::col(int index) const
+{
+    if (index < 0 || index >= cols)
+        throw std::out_of_range("matrix_view::col -> trying to acess non existing column");
+    matrix_view res(ptr + static_cast<std::ptrdiff_t>(physical_col(index)) * col_stride,
+                    rows, 1, row_stride, col_stride);
+    res.skip_row = skip_row;
+    return res;
+}
+
+template <typename ValueType>
+matrix_view<ValueType> matrix_view<ValueType>::block(int row, int col, int num_rows, int num_cols) const
+{
+    if (row < 0 || col < 0 || num_rows < 0 || num_cols < 0 || row + num_rows > rows || col + num_cols > cols)
+        throw std::out_of_range("matrix_view::block -> block out of range");
+    // a hidden row before the block shifts it, one inside it stays hidden
+    const int first_row = row < skip_row ? row : row + 1;
+    const int first_col = col < skip_col ? col : col + 1;
+    matrix_view res(ptr + static_cast<std::ptrdiff_t>(first_row) * row_stride +
+                        static_cast<std::ptrdiff_t>(first_col) * col_stride,
+                    num_rows, num_cols, row_stride, col_stride);
+    if (skip_row != no_skip && row < skip_row && skip_row - row < num_rows)
+        res.skip_row = skip_row - row;
+    if (skip_col != no_skip && col < skip_col && skip_col - col < num_cols)
+        res.skip_col = skip_col - col;
+    return res;
+}
+
+template <typename ValueType>
+matrix_view<ValueType> matrix_view<ValueType>::minor(int row, int col) const
+{
+    if (row < 0 || row >= rows || col < 0 || col >= cols)
+        throw std::out_of_range("matrix_view::minor -> trying to acess non existing row or column");
+    if (is_minor())
+        throw std::out_of_range("matrix_view::minor -> the view already hides a row or a column");
+    matrix_view res(ptr, rows - 1, cols - 1, row_stride, col_stride);
+    res.skip_row = row;
+    res.skip_col = col;
+    return res;
+}
+
+template <typename ValueType>
+matrix_view<ValueType> matrix_view<ValueType>::transpose() const
+{
+    matrix_view res(ptr, cols, rows, col_stride, row_stride);
+    res.skip_row = skip_col;
+    res.skip_col = skip_row;
+    return res;
+}
+
+template <typename ValueType>
+bool matrix_view<ValueType>::conflicts_with(const matrix_view<const value_type> &src) const
+{
+    if (rows == 0 || cols == 0 || src.rows == 0 || src.cols == 0)
+        return false;
+    if (src.ptr == ptr && src.rows == rows && src.cols == cols &&
+        src.row_stride == row_stride && src.col_stride == col_stride &&
+        src.skip_row == skip_row && src.skip_col == skip_col)
+        return false;
+    auto last = [](const auto &v) {
+        return v.ptr + static_cast<std::ptrdiff_t>(v.physical_row(v.rows - 1)) * v.row_stride +
+               static_cast<std::ptrdiff_t>(v.physical_col(v.cols - 1)) * v.col_stride;
+    };
+    return src.ptr <= last(*this) && ptr <= last(src);
+}
+
+template <typename ValueType>
+template <typename Expr, typename Function>
+void matrix_view<ValueType>::evaluate(const Expr &expr, Function fn) const
+{
+    if (rows != expr.get_rows() || cols != expr.get_cols())
+        throw std::length_error("matrix_view -> Matrices dimentions must be the same");
+    if (expr.aliases(*this))
+    {
+        const matrix<value_type, arena_allocator<value_type>> tmp(expr);
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                fn((*this)(i, j), tmp[i][j]);
+        return;
+    }
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            fn((*this)(i, j), expr.coeff(i, j));
+}
+
+template <typename ValueType>
+matrix_view<ValueType> &matrix_view<ValueType>::operator=(const matrix_view &view)
+{
+    evaluate(view, [](ValueType &dst, const value_type &val) { dst = val; });
+    return *this;
+}
+
+template <typename ValueType>
+template <typename Expr>
+matrix_view<ValueType> &matrix_view<ValueType>::operator=(const matrix_expr<Expr> &expr)
+{
+    evaluate(expr.derived(), [](ValueType &dst, const value_type &val) { dst = val; });
+    return *this;
+}
+
+template <typename ValueType>
+template <typename Allocator>
+matrix_view<ValueType> &matrix_view<ValueType>::operator=(const matrix<value_type, Allocator> &mat)
+{
+    return *this = matrix_leaf<value_type>(mat);
+}
+
+template <typename ValueType>
+void matrix_view<ValueType>::gemm_into(const matrix_view<const value_type> &a, const matrix_view<const value_type> &b,
+                                       matrix<value_type> &res)
+{
+    // minors can't be described by strides, they are copied once,
+    // which is cheap next to the product
+    if (a.is_minor())
+        return gemm_into(matrix<value_type, arena_allocator<value_type>>(a).view(), b, res);
+    if (b.is_minor())
+        return gemm_into(a, matrix<value_type, arena_allocator<value_type>>(b).view(), res);
+    matrix_kernels::gemm(a.rows, b.cols, a.cols, a.ptr, a.row_stride, a.col_stride,
+                         b.ptr, b.row_stride, b.col_stride, res.data(), res.get_stride());
+}
+
+template <typename ValueType>
+template <typename OtherType>
+matrix<typename matrix_view<ValueType>::value_type>
+matrix_view<ValueType>::multiply(const matrix_view<OtherType> &view) const
+{
+    static_assert(std::is_same<typename matrix_view<OtherType>::value_type, value_type>::value,
+                  "matrix_view::multiply -> value types must be the same");
+    if (cols != view.get_rows())
+        throw std::length_error("matrix::multiply -> check matrices dimentions");
+    matrix<value_type> res(rows, view.get_cols());
+    gemm_into(*this, view, res);
+    return res;
+}
+
+template <typename ValueType>
+template <typename Allocator>
+inline matrix<typename matrix_view<ValueType>::value_type>
+matrix_view<ValueType>::multiply(const matrix<value_type, Allocator> &mat) const
+{
+    return multiply(mat.view());
+}
+
+template <typename ValueType>
+inline lu_factorization<typename matrix_view<ValueType>::value_type> matrix_view<ValueType>::lu() const
+{
+    return lu_factorization<value_type>(*this);
+}
+
+#endif // End of the file
@@ -0,0 +1,652 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file sparse_matrix.h
+ * @brief
+ *
+ * This file provides the <code>sparse_matrix</code> class, a matrix stored
+ * in compressed sparse row (CSR) form: for every row the sorted column
+ * indices of its nonzeros and their values. Memory and the time of every
+ * operation grow with the number of nonzeros, not with rows x columns.
+ *
+ * The CSR arrays of the transpose are the compressed sparse column (CSC)
+ * arrays of the matrix, transpose() is the conversion between the two.
+ *
+ * Products and element-wise operations build their result in two passes
+ * over the rows, one counting the nonzeros of every row and one filling
+ * them in, both shared between the threads of the pool.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _SPARSE_MATRIX_H_
+#define _SPARSE_MATRIX_H_
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+#include "matrix_def.h"
+#include "thread_pool.h"
+#include "simd_kernels.h"
+
+/**
+ * One element of a sparse matrix, (row, col) = value
+ */
+template <typename ValueType>
+struct sparse_entry
+{
+  int row;
+  int col;
+  ValueType value;
+};
+
+template <typename ValueType>
+class sparse_matrix
+{
+public:
+  /**
+     * Constructs an empty (0 x 0) matrix
+     * @bigoh O(1)
+     */
+  sparse_matrix();
+
+  /**
+     * Constructs a (rows x cols) matrix of zeros
+     * @bigoh O(rows)
+     */
+  sparse_matrix(int rows, int cols);
+
+  /**
+     * Constructs the matrix from its nonzeros in any order,
+     * the values of repeated positions are added
+     * @throw out_of_range if an entry is outside the matrix
+     * @bigoh O(rows + entries x log(entries per row))
+     */
+  sparse_matrix(int rows, int cols, const vector<sparse_entry<ValueType>> &entries);
+
+  /**
+     * Keeps the nonzero elements of a dense matrix
+     * @bigoh O(rows x columns)
+     */
+  template <typename Allocator>
+  explicit sparse_matrix(const matrix<ValueType, Allocator> &mat);
+
+  /**
+     * @returns the (n x n) identity matrix
+     */
+  static sparse_matrix identity(int n);
+
+  /**
+     * @returns the dense matrix with the same elements
+     * @bigoh O(rows x columns)
+     */
+  matrix<ValueType> to_dense() const;
+
+  /**
+     * Compares the elements, a stored zero equals a missing one
+     * @bigoh O(nonzeros)
+     */
+  bool operator==(const sparse_matrix &mat) const;
+
+  bool operator!=(const sparse_matrix &mat) const;
+
+  /**
+     * @returns element (i, j), zero if it isn't stored
+     * @throw out_of_range if (i, j) is outside the matrix
+     * @bigoh O(log(nonzeros of row i))
+     */
+  ValueType get(int i, int j) const;
+
+  /**
+     * Element-wise operations with a matrix of the same dimensions,
+     * * keeps only the positions stored in both
+     * @throw length_error if the dimensions are not the same
+     * @bigoh O(nonzeros + mat.nonzeros)
+     */
+  sparse_matrix &operator+=(const sparse_matrix &mat);
+
+  sparse_matrix &operator-=(const sparse_matrix &mat);
+
+  sparse_matrix &operator*=(const sparse_matrix &mat);
+
+  /**
+     * Operations of every stored item with val
+     * @bigoh O(nonzeros)
+     */
+  sparse_matrix &operator*=(const ValueType &val);
+
+  sparse_matrix &operator/=(const ValueType &val);
+
+  /**
+     * Sparse matrix x dense vector
+     * @throw   length_error if vec.size() != columns
+     * @bigoh O(nonzeros)
+     */
+  vector<ValueType> multiply(const vector<ValueType> &vec) const;
+
+  /**
+     * Transposed sparse matrix x dense vector, without building the transpose
+     * @throw   length_error if vec.size() != rows
+     * @bigoh O(nonzeros)
+     */
+  vector<ValueType> multiply_transposed(const vector<ValueType> &vec) const;
+
+  /**
+     * Sparse matrix x dense matrix
+     * @throw   length_error if columns != mat.rows
+     * @bigoh O(nonzeros x mat.columns)
+     */
+  template <typename Allocator>
+  matrix<ValueType> multiply(const matrix<ValueType, Allocator> &mat) const;
+
+  /**
+     * Sparse matrix x sparse matrix (row by row Gustavson product)
+     * @throw   length_error if columns != mat.rows
+     * @bigoh O(multiplications + nonzeros of the result x log)
+     */
+  sparse_matrix multiply(const sparse_matrix &mat) const;
+
+  /**
+     * @returns the transposed matrix, i.e. the CSC form of this one
+     * @bigoh O(nonzeros + columns)
+     */
+  sparse_matrix transpose() const;
+
+  /**
+     * Removes the stored zeros (e.g. left by a subtraction)
+     * @bigoh O(nonzeros)
+     */
+  sparse_matrix &prune();
+
+  int get_rows() const { return rows; }
+
+  int get_cols() const { return cols; }
+
+  /**
+     * @returns the number of stored elements
+     */
+  std::size_t non_zeros() const { return vals.size(); }
+
+  /**
+     * CSR arrays: the elements of row i are at positions
+     * [row_offsets()[i], row_offsets()[i + 1]) of col_indices() and values()
+     */
+  const vector<std::size_t> &row_offsets() const { return offsets; }
+
+  const vector<int> &col_indices() const { return indices; }
+
+  const vector<ValueType> &values() const { return vals; }
+
+private:
+  /**
+     * Builds a (rows x cols) matrix row by row.
+     * count(first, last, nnz) stores in nnz[i] the number of elements of
+     * row i, fill(first, last, res) writes them into res.
+     */
+  template <typename Count, typename Fill>
+  static sparse_matrix build(int rows, int cols, std::size_t work, Count count, Fill fill);
+
+  /**
+     * Element-wise fn(a, b) over the union (or the intersection)
+     * of the stored positions, a missing element is zero
+     */
+  template <typename Function>
+  sparse_matrix combine(const sparse_matrix &mat, bool intersect, Function fn) const;
+
+  int rows;
+  int cols;
+  vector<std::size_t> offsets;
+  vector<int> indices;
+  vector<ValueType> vals;
+};
+
+template <typename ValueType>
+sparse_matrix<ValueType>::sparse_matrix() : sparse_matrix(0, 0)
+{
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType>::sparse_matrix(int rows, int cols)
+    : rows(rows), cols(cols), offsets(static_cast<std::size_t>(rows) + 1)
+{
+    if (rows < 0 || cols < 0)
+        throw std::length_error("sparse_matrix -> dimensions must not be negative");
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType>::sparse_matrix(int rows, int cols, const vector<sparse_entry<ValueType>> &entries)
+    : sparse_matrix(rows, cols)
+{
+    // bucket the entries by row, then sort every row by column
+    vector<std::size_t> start(static_cast<std::size_t>(rows) + 1);
+    for (const auto &e : entries)
+    {
+        if (e.row < 0 || e.row >= rows || e.col < 0 || e.col >= cols)
+            throw std::out_of_range("sparse_matrix -> entry out of range");
+        start[e.row + 1]++;
+    }
+    std::partial_sum(start.begin(), start.end(), start.begin());
+    vector<std::pair<int, ValueType>> sorted(entries.size());
+    vector<std::size_t> pos(start.begin(), start.end() - 1);
+    for (const auto &e : entries)
+        sorted[pos[e.row]++] = {e.col, e.value};
+
+    indices.reserve(entries.size());
+    vals.reserve(entries.size());
+    for (int i = 0; i < rows; i++)
+    {
+        const auto first = sorted.begin() + start[i];
+        const auto last = sorted.begin() + start[i + 1];
+        std::stable_sort(first, last, [](const auto &a, const auto &b) { return a.first < b.first; });
+        for (auto it = first; it != last; ++it)
+        {
+            if (indices.size() > offsets[i] && indices.back() == it->first)
+                vals.back() += it->second;
+            else
+            {
+                indices.push_back(it->first);
+                vals.push_back(it->second);
+            }
+        }
+        offsets[i + 1] = indices.size();
+    }
+}
+
+template <typename ValueType>
+template <typename Allocator>
+sparse_matrix<ValueType>::sparse_matrix(const matrix<ValueType, Allocator> &mat)
+    : sparse_matrix(mat.get_rows(), mat.get_cols())
+{
+    for (int i = 0; i < rows; i++)
+    {
+        const ValueType *row = mat[i].data();
+        for (int j = 0; j < cols; j++)
+        {
+            if (row[j] != static_cast<ValueType>(0))
+            {
+                indices.push_back(j);
+                vals.push_back(row[j]);
+            }
+        }
+        offsets[i + 1] = indices.size();
+    }
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType> sparse_matrix<ValueType>::identity(int n)
+{
+    sparse_matrix res(n, n);
+    res.indices.resize(n);
+    res.vals.assign(n, static_cast<ValueType>(1));
+    for (int i = 0; i < n; i++)
+    {
+        res.indices[i] = i;
+        res.offsets[i + 1] = i + 1;
+    }
+    return res;
+}
+
+template <typename ValueType>
+matrix<ValueType> sparse_matrix<ValueType>::to_dense() const
+{
+    matrix<ValueType> res(rows, cols);
+    for (int i = 0; i < rows; i++)
+    {
+        ValueType *row = res[i].data();
+        for (std::size_t p = offsets[i]; p < offsets[i + 1]; p++)
+            row[indices[p]] = vals[p];
+    }
+    return res;
+}
+
+template <typename ValueType>
+bool sparse_matrix<ValueType>::operator==(const sparse_matrix &mat) const
+{
+    if (rows != mat.rows || cols != mat.cols)
+        return false;
+    const ValueType zero = static_cast<ValueType>(0);
+    for (int i = 0; i < rows; i++)
+    {
+        std::size_t p = offsets[i], q = mat.offsets[i];
+        const std::size_t p_end = offsets[i + 1], q_end = mat.offsets[i + 1];
+        while (p < p_end || q < q_end)
+        {
+            if (q == q_end || (p < p_end && indices[p] < mat.indices[q]))
+            {
+                if (vals[p++] != zero)
+                    return false;
+            }
+            else if (p == p_end || mat.indices[q] < indices[p])
+            {
+                if (mat.vals[q++] != zero)
+                    return false;
+            }
+            else if (vals[p++] != mat.vals[q++])
+                return false;
+        }
+    }
+    return true;
+}
+
+template <typename ValueType>
+inline bool sparse_matrix<ValueType>::operator!=(const sparse_matrix &mat) const
+{
+    return !(*this == mat);
+}
+
+template <typename ValueType>
+ValueType sparse_matrix<ValueType>::get(int i, int j) const
+{
+    if (i < 0 || i >= rows || j < 0 || j >= cols)
+        throw std::out_of_range("sparse_matrix::get -> index out of range");
+    const auto first = indices.begin() + offsets[i];
+    const auto last = indices.begin() + offsets[i + 1];
+    const auto it = std::lower_bound(first, last, j);
+    if (it == last || *it != j)
+        return static_cast<ValueType>(0);
+    return vals[it - indices.begin()];
+}
+
+template <typename ValueType>
+template <typename Count, typename Fill>
+sparse_matrix<ValueType> sparse_matrix<ValueType>::build(int rows, int cols, std::size_t work,
+                                                         Count count, Fill fill)
+{
+    sparse_matrix res(rows, cols);
+    matrix_parallel::parallel_for(0, rows, work, [&](int first, int last) {
+        count(first, last, res.offsets.data() + 1);
+    });
+    std::partial_sum(res.offsets.begin(), res.offsets.end(), res.offsets.begin());
+    res.indices.resize(res.offsets.back());
+    res.vals.resize(res.offsets.back());
+    matrix_parallel::parallel_for(0, rows, work, [&](int first, int last) {
+        fill(first, last, res);
+    });
+    return res;
+}
+
+template <typename ValueType>
+template <typename Function>
+sparse_matrix<ValueType> sparse_matrix<ValueType>::combine(const sparse_matrix &mat, bool intersect,
+                                                           Function fn) const
+{
+    if (rows != mat.rows || cols != mat.cols)
+        throw std::length_error("sparse_matrix -> Matrices dimentions must be the same");
+    const ValueType zero = static_cast<ValueType>(0);
+    // walks row i of both matrices in column order,
+    // calls out(col, value) for every position of the result
+    auto merge_row = [&](int i, auto out) {
+        std::size_t p = offsets[i], q = mat.offsets[i];
+        const std::size_t p_end = offsets[i + 1], q_end = mat.offsets[i + 1];
+        while (p < p_end || q < q_end)
+        {
+            if (q == q_end || (p < p_end && indices[p] < mat.indices[q]))
+            {
+                if (!intersect)
+                    out(indices[p], fn(vals[p], zero));
+                p++;
+            }
+            else if (p == p_end || mat.indices[q] < indices[p])
+            {
+                if (!intersect)
+                    out(mat.indices[q], fn(zero, mat.vals[q]));
+                q++;
+            }
+            else
+            {
+                out(indices[p], fn(vals[p], mat.vals[q]));
+                p++, q++;
+            }
+        }
+    };
+    return build(
+        rows, cols, non_zeros() + mat.non_zeros(),
+        [&](int first, int last, std::size_t *nnz) {
+            for (int i = first; i < last; i++)
+            {
+                std::size_t n = 0;
+                merge_row(i, [&](int, const ValueType &) { n++; });
+                nnz[i] = n;
+            }
+        },
+        [&](int first, int last, sparse_matrix &res) {
+            for (int i = first; i < last; i++)
+            {
+                std::size_t pos = res.offsets[i];
+                merge_row(i, [&](int col, const ValueType &val) {
+                    res.indices[pos] = col;
+                    res.vals[pos++] = val;
+                });
+            }
+        });
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType> &sparse_matrix<ValueType>::operator+=(const sparse_matrix &mat)
+{
+    return *this = combine(mat, false, [](const ValueType &a, const ValueType &b) { return a + b; });
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType> &sparse_matrix<ValueType>::operator-=(const sparse_matrix &mat)
+{
+    return *this = combine(mat, false, [](const ValueType &a, const ValueType &b) { return a - b; });
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType> &sparse_matrix<ValueType>::operator*=(const sparse_matrix &mat)
+{
+    return *this = combine(mat, true, [](const ValueType &a, const ValueType &b) { return a * b; });
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType> &sparse_matrix<ValueType>::operator*=(const ValueType &val)
+{
+    for (auto &v : vals)
+        v *= val;
+    return *this;
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType> &sparse_matrix<ValueType>::operator/=(const ValueType &val)
+{
+    for (auto &v : vals)
+        v /= val;
+    return *this;
+}
+
+template <typename ValueType>
+vector<ValueType> sparse_matrix<ValueType>::multiply(const vector<ValueType> &vec) const
+{
+    if (vec.size() != static_cast<std::size_t>(cols))
+        throw std::length_error("sparse_matrix::multiply -> vector.size() must be equal to matrix::cols");
+    vector<ValueType> res(rows);
+    matrix_parallel::parallel_for(0, rows, non_zeros(), [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            ValueType sum = ValueType();
+            for (std::size_t p = offsets[i]; p < offsets[i + 1]; p++)
+                sum += vals[p] * vec[indices[p]];
+            res[i] = sum;
+        }
+    });
+    return res;
+}
+
+template <typename ValueType>
+vector<ValueType> sparse_matrix<ValueType>::multiply_transposed(const vector<ValueType> &vec) const
+{
+    if (vec.size() != static_cast<std::size_t>(rows))
+        throw std::length_error("sparse_matrix::multiply_transposed -> vector.size() must be equal to matrix::rows");
+    // scattered writes, kept serial
+    vector<ValueType> res(cols);
+    for (int i = 0; i < rows; i++)
+        for (std::size_t p = offsets[i]; p < offsets[i + 1]; p++)
+            res[indices[p]] += vals[p] * vec[i];
+    return res;
+}
+
+template <typename ValueType>
+template <typename Allocator>
+matrix<ValueType> sparse_matrix<ValueType>::multiply(const matrix<ValueType, Allocator> &mat) const
+{
+    if (cols != mat.get_rows())
+        throw std::length_error("sparse_matrix::multiply -> check matrices dimentions");
+    const int n = mat.get_cols();
+    matrix<ValueType> res(rows, n);
+    matrix_parallel::parallel_for(0, rows, non_zeros() * n, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            ValueType *row = res[i].data();
+            for (std::size_t p = offsets[i]; p < offsets[i + 1]; p++)
+                matrix_kernels::vec_axpy(n, vals[p], mat[indices[p]].data(), row);
+        }
+    });
+    return res;
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType> sparse_matrix<ValueType>::multiply(const sparse_matrix &mat) const
+{
+    if (cols != mat.rows)
+        throw std::length_error("sparse_matrix::multiply -> check matrices dimentions");
+    std::size_t work = 0;
+    for (std::size_t p = 0; p < indices.size(); p++)
+        work += mat.offsets[indices[p] + 1] - mat.offsets[indices[p]];
+    const int n = mat.cols;
+    // marker[j] == i when column j of row i was already met
+    return build(
+        rows, n, work,
+        [&](int first, int last, std::size_t *nnz) {
+            vector<int> marker(n, -1);
+            for (int i = first; i < last; i++)
+            {
+                std::size_t count = 0;
+                for (std::size_t p = offsets[i]; p < offsets[i + 1]; p++)
+                {
+                    const int k = indices[p];
+                    for (std::size_t q = mat.offsets[k]; q < mat.offsets[k + 1]; q++)
+                        if (marker[mat.indices[q]] != i)
+                        {
+                            marker[mat.indices[q]] = i;
+                            count++;
+                        }
+                }
+                nnz[i] = count;
+            }
+        },
+        [&](int first, int last, sparse_matrix &res) {
+            vector<int> marker(n, -1);
+            vector<ValueType> acc(n);
+            for (int i = first; i < last; i++)
+            {
+                int *row_cols = res.indices.data() + res.offsets[i];
+                std::size_t count = 0;
+                for (std::size_t p = offsets[i]; p < offsets[i + 1]; p++)
+                {
+                    const int k = indices[p];
+                    const ValueType a = vals[p];
+                    for (std::size_t q = mat.offsets[k]; q < mat.offsets[k + 1]; q++)
+                    {
+                        const int j = mat.indices[q];
+                        if (marker[j] != i)
+                        {
+                            marker[j] = i;
+                            acc[j] = a * mat.vals[q];
+                            row_cols[count++] = j;
+                        }
+                        else
+                            acc[j] += a * mat.vals[q];
+                    }
+                }
+                std::sort(row_cols, row_cols + count);
+                ValueType *row_vals = res.vals.data() + res.offsets[i];
+                for (std::size_t t = 0; t < count; t++)
+                    row_vals[t] = acc[row_cols[t]];
+            }
+        });
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType> sparse_matrix<ValueType>::transpose() const
+{
+    sparse_matrix res(cols, rows);
+    for (int j : indices)
+        res.offsets[j + 1]++;
+    std::partial_sum(res.offsets.begin(), res.offsets.end(), res.offsets.begin());
+    res.indices.resize(indices.size());
+    res.vals.resize(vals.size());
+    // rows are visited in order, so every row of the result comes out sorted
+    vector<std::size_t> pos(res.offsets.begin(), res.offsets.end() - 1);
+    for (int i = 0; i < rows; i++)
+        for (std::size_t p = offsets[i]; p < offsets[i + 1]; p++)
+        {
+            const std::size_t dst = pos[indices[p]]++;
+            res.indices[dst] = i;
+            res.vals[dst] = vals[p];
+        }
+    return res;
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType> &sparse_matrix<ValueType>::prune()
+{
+    std::size_t dst = 0;
+    std::size_t p = 0;
+    for (int i = 0; i < rows; i++)
+    {
+        for (; p < offsets[i + 1]; p++)
+            if (vals[p] != static_cast<ValueType>(0))
+            {
+                indices[dst] = indices[p];
+                vals[dst++] = vals[p];
+            }
+        offsets[i + 1] = dst;
+    }
+    indices.resize(dst);
+    vals.resize(dst);
+    return *this;
+}
+
+template <typename T>
+inline sparse_matrix<T> operator+(sparse_matrix<T> lhs, const sparse_matrix<T> &rhs)
+{
+    return lhs += rhs;
+}
+
+template <typename T>
+inline sparse_matrix<T> operator-(sparse_matrix<T> lhs, const sparse_matrix<T> &rhs)
+{
+    return lhs -= rhs;
+}
+
+template <typename T>
+inline sparse_matrix<T> operator*(sparse_matrix<T> lhs, const sparse_matrix<T> &rhs)
+{
+    return lhs *= rhs;
+}
+
+template <typename T>
+inline sparse_matrix<T> operator*(sparse_matrix<T> lhs, const T &val)
+{
+    return lhs *= val;
+}
+
+template <typename T>
+inline sparse_matrix<T> operator/(sparse_matrix<T> lhs, const T &val)
+{
+    return lhs /= val;
+}
+
+#endif // End of the file
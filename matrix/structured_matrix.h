@@ -0,0 +1,116 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file structured_matrix.h
+ * @brief
+ *
+ * This file provides the common base of the square matrices that store
+ * only the entries their shape allows:
+ *
+ *  - <code>diagonal_matrix</code>   (diagonal_matrix.h)
+ *  - <code>triangular_matrix</code> (triangular_matrix.h)
+ *  - <code>symmetric_matrix</code>  (symmetric_matrix.h)
+ *  - <code>band_matrix</code>       (band_matrix.h)
+ *
+ * They share the interface of <code>matrix</code> where it makes sense
+ * (get_rows, multiply, det, invert, solve) with algorithms specialized for
+ * the shape, read element (i, j) with operator(), convert to a dense
+ * matrix with to_dense(), and are leaves of the element-wise expressions,
+ * so <code>matrix&lt;T&gt; sum = dense + diagonal;</code> works.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _STRUCTURED_MATRIX_H_
+#define _STRUCTURED_MATRIX_H_
+
+#include <ostream>
+#include <type_traits>
+
+#include "matrix_def.h"
+#include "matrix_expr.h"
+
+/**
+ * Base of the structured matrices, Derived provides get_rows()
+ * and operator()(i, j)
+ */
+template <typename Derived, typename ValueType>
+class structured_matrix
+{
+public:
+  using value_type = ValueType;
+
+  const Derived &derived() const
+  {
+    return static_cast<const Derived &>(*this);
+  }
+
+  /**
+     * @returns the dense matrix with the same elements
+     * @bigoh O(rows x columns)
+     */
+  matrix<ValueType> to_dense() const
+  {
+    const int n = derived().get_rows();
+    matrix<ValueType> res(n, n);
+    for (int i = 0; i < n; i++)
+      for (int j = 0; j < n; j++)
+        res[i][j] = derived()(i, j);
+    return res;
+  }
+};
+
+/**
+ * Leaf of an expression, reads the elements of a structured matrix
+ */
+template <typename Structured>
+class structured_leaf : public matrix_expr<structured_leaf<Structured>>
+{
+public:
+  using value_type = typename Structured::value_type;
+
+  explicit structured_leaf(const Structured &mat) : mat(&mat) {}
+
+  int get_rows() const { return mat->get_rows(); }
+
+  int get_cols() const { return mat->get_cols(); }
+
+  value_type coeff(int i, int j) const { return (*mat)(i, j); }
+
+  /**
+     * Structured matrices own their storage, a view never points into it
+     */
+  template <typename View>
+  bool aliases(const View &) const { return false; }
+
+private:
+  const Structured *mat;
+};
+
+template <typename Structured>
+struct matrix_operand<Structured, typename std::enable_if<std::is_base_of<
+                                      structured_matrix<Structured, typename Structured::value_type>,
+                                      Structured>::value>::type> : std::true_type
+{
+  using type = structured_leaf<Structured>;
+  using value_type = typename Structured::value_type;
+  static type wrap(const Structured &mat) { return type(mat); }
+};
+
+/**
+ * Overloads << operator to print a structured matrix like a dense one
+ */
+template <typename Derived, typename ValueType>
+std::ostream &operator<<(std::ostream &os, const structured_matrix<Derived, ValueType> &mat)
+{
+    return os << mat.to_dense();
+}
+
+#endif // End of the file
@@ -0,0 +1,235 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file symmetric_matrix.h
+ * @brief
+ *
+ * This file provides the <code>symmetric_matrix</code> class, a square
+ * matrix equal to its transpose. Only the lower triangle is stored,
+ * packed row by row, n(n+1)/2 elements; element (i, j) and (j, i) are
+ * the same storage.
+ *
+ * Products read every stored element once and use it for both of its
+ * positions. det, solve and invert go through the pivoted LU of the
+ * expanded matrix, pivoting doesn't keep the symmetry.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _SYMMETRIC_MATRIX_H_
+#define _SYMMETRIC_MATRIX_H_
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <stdexcept>
+
+#include "matrix_def.h"
+#include "simd_kernels.h"
+#include "lu_factorization.h"
+#include "structured_matrix.h"
+
+template <typename ValueType>
+class symmetric_matrix : public structured_matrix<symmetric_matrix<ValueType>, ValueType>
+{
+public:
+  /**
+     * Constructs an (n x n) matrix of zeros
+     * @bigoh O(n^2)
+     */
+  explicit symmetric_matrix(int n = 0);
+
+  /**
+     * Keeps the lower triangle of a square dense matrix,
+     * the upper one is assumed to mirror it
+     * @throw length_error if it's not a square matrix
+     * @bigoh O(n^2)
+     */
+  template <typename Allocator>
+  explicit symmetric_matrix(const matrix<ValueType, Allocator> &mat);
+
+  bool operator==(const symmetric_matrix &mat) const
+  {
+    return size == mat.size && elements == mat.elements;
+  }
+
+  bool operator!=(const symmetric_matrix &mat) const { return !(*this == mat); }
+
+  /**
+     * @returns element (i, j), no bounds checking
+     */
+  ValueType operator()(int i, int j) const
+  {
+    return i >= j ? elements[index(i, j)] : elements[index(j, i)];
+  }
+
+  /**
+     * @returns a reference to element (i, j), which is element (j, i) too
+     * @throw out_of_range if (i, j) is outside the matrix
+     */
+  ValueType &at(int i, int j);
+
+  /**
+     * Multiply with a vector or a dense matrix
+     * @throw   length_error if the dimensions don't match
+     * @bigoh O(n^2), O(n^2 x mat.columns) for a dense matrix
+     */
+  vector<ValueType> multiply(const vector<ValueType> &vec) const;
+
+  template <typename Allocator>
+  matrix<ValueType> multiply(const matrix<ValueType, Allocator> &mat) const;
+
+  /**
+     * @returns the determinant
+     * @bigoh O(n^3)
+     */
+  ValueType det() const;
+
+  /**
+     * @throw   out_of_range if determinant = zero
+     * @returns the inverse, which is symmetric too
+     * @bigoh O(n^3)
+     */
+  symmetric_matrix invert() const;
+
+  /**
+     * Solves A x = vec
+     * @throw   length_error if vec.size() != n
+     * @throw   out_of_range if determinant = zero
+     * @bigoh O(n^3)
+     */
+  vector<ValueType> solve(const vector<ValueType> &vec) const;
+
+  /**
+     * Solves A X = mat for every column of mat
+     * @throw   length_error if mat.rows != n
+     * @throw   out_of_range if determinant = zero
+     * @bigoh O(n^3 + n^2 x mat.columns)
+     */
+  template <typename Allocator>
+  matrix<ValueType> solve(const matrix<ValueType, Allocator> &mat) const;
+
+  int get_rows() const { return size; }
+
+  int get_cols() const { return size; }
+
+private:
+  /**
+     * Position of (i, j), i >= j, in the packed lower triangle
+     */
+  static std::size_t index(int i, int j)
+  {
+    return static_cast<std::size_t>(i) * (i + 1) / 2 + j;
+  }
+
+  lu_factorization<ValueType, arena_allocator<ValueType>> lu() const;
+
+  int size;
+  vector<ValueType> elements;
+};
+
+template <typename ValueType>
+symmetric_matrix<ValueType>::symmetric_matrix(int n)
+    : size(n), elements(static_cast<std::size_t>(n) * (n + 1) / 2)
+{
+}
+
+template <typename ValueType>
+template <typename Allocator>
+symmetric_matrix<ValueType>::symmetric_matrix(const matrix<ValueType, Allocator> &mat)
+    : symmetric_matrix(mat.get_rows())
+{
+    if (mat.get_rows() != mat.get_cols())
+        throw std::length_error("symmetric_matrix -> matrix must be square");
+    for (int i = 0; i < size; i++)
+        std::copy_n(mat[i].data(), i + 1, elements.data() + index(i, 0));
+}
+
+template <typename ValueType>
+ValueType &symmetric_matrix<ValueType>::at(int i, int j)
+{
+    if (i < 0 || i >= size || j < 0 || j >= size)
+        throw std::out_of_range("symmetric_matrix::at -> index out of range");
+    return i >= j ? elements[index(i, j)] : elements[index(j, i)];
+}
+
+template <typename ValueType>
+vector<ValueType> symmetric_matrix<ValueType>::multiply(const vector<ValueType> &vec) const
+{
+    if (vec.size() != static_cast<std::size_t>(size))
+        throw std::length_error("symmetric_matrix::multiply -> vector.size() must be equal to matrix::cols");
+    // stored row i is row i left of the diagonal and column i above it
+    vector<ValueType> res(size);
+    for (int i = 0; i < size; i++)
+    {
+        const ValueType *a = elements.data() + index(i, 0);
+        res[i] += matrix_kernels::vec_dot(i + 1, a, vec.data());
+        matrix_kernels::vec_axpy(i, vec[i], a, res.data());
+    }
+    return res;
+}
+
+template <typename ValueType>
+template <typename Allocator>
+matrix<ValueType> symmetric_matrix<ValueType>::multiply(const matrix<ValueType, Allocator> &mat) const
+{
+    if (mat.get_rows() != size)
+        throw std::length_error("symmetric_matrix::multiply -> check matrices dimentions");
+    const int cols = mat.get_cols();
+    matrix<ValueType> res(size, cols);
+    for (int i = 0; i < size; i++)
+    {
+        const ValueType *a = elements.data() + index(i, 0);
+        for (int j = 0; j < i; j++)
+        {
+            matrix_kernels::vec_axpy(cols, a[j], mat[j].data(), res[i].data());
+            matrix_kernels::vec_axpy(cols, a[j], mat[i].data(), res[j].data());
+        }
+        matrix_kernels::vec_axpy(cols, a[i], mat[i].data(), res[i].data());
+    }
+    return res;
+}
+
+template <typename ValueType>
+inline lu_factorization<ValueType, arena_allocator<ValueType>> symmetric_matrix<ValueType>::lu() const
+{
+    return lu_factorization<ValueType, arena_allocator<ValueType>>(this->to_dense());
+}
+
+template <typename ValueType>
+ValueType symmetric_matrix<ValueType>::det() const
+{
+    return lu().det();
+}
+
+template <typename ValueType>
+symmetric_matrix<ValueType> symmetric_matrix<ValueType>::invert() const
+{
+    return symmetric_matrix(lu().inverse());
+}
+
+template <typename ValueType>
+vector<ValueType> symmetric_matrix<ValueType>::solve(const vector<ValueType> &vec) const
+{
+    if (vec.size() != static_cast<std::size_t>(size))
+        throw std::length_error("symmetric_matrix::solve -> vector.size() must be equal to matrix::rows");
+    return lu().solve(vec);
+}
+
+template <typename ValueType>
+template <typename Allocator>
+matrix<ValueType> symmetric_matrix<ValueType>::solve(const matrix<ValueType, Allocator> &mat) const
+{
+    if (mat.get_rows() != size)
+        throw std::length_error("symmetric_matrix::solve -> check matrix dimentions");
+    return matrix<ValueType>(lu().solve(mat));
+}
+
+#endif // End of the file
@@ -0,0 +1,265 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file thread_pool.h
+ * @brief
+ *
+ * This file provides the thread pool shared by the <code>matrix</code>
+ * operations. The pool is owned by the library and started lazily on the
+ * first parallel operation. Its size defaults to the number of hardware
+ * threads, can be set with the MATRIX_NUM_THREADS environment variable or
+ * at runtime with <code>matrix_parallel::set_num_threads()</code>.
+ *
+ * Work smaller than <code>matrix_parallel::parallel_threshold</code> and
+ * work submitted from inside a pool thread runs serially on the caller.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <cstddef>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace matrix_parallel
+{
+    /**
+     * Operations touching fewer elements than this run serially
+     */
+    constexpr std::size_t parallel_threshold = 1 << 15;
+
+    class thread_pool
+    {
+    public:
+      /**
+         * @returns the pool shared by the library
+         */
+      static thread_pool &instance()
+      {
+        static thread_pool pool;
+        return pool;
+      }
+
+      /**
+         * @returns the number of threads used by parallel operations,
+         *          the calling thread included
+         */
+      int size()
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        return num_threads;
+      }
+
+      /**
+         * Sets the number of threads used by parallel operations
+         * Must not be called while a parallel operation is running
+         * @param n number of threads, values < 1 mean hardware concurrency
+         */
+      void resize(int n)
+      {
+        stop_workers();
+        std::lock_guard<std::mutex> lock(mtx);
+        num_threads = n < 1 ? default_threads() : n;
+      }
+
+      /**
+         * Runs task on a worker thread, starting the workers if needed
+         */
+      void submit(std::function<void()> task)
+      {
+        {
+          std::lock_guard<std::mutex> lock(mtx);
+          if (workers.empty())
+            start_workers();
+          tasks.push_back(std::move(task));
+        }
+        cv.notify_one();
+      }
+
+      /**
+         * @returns true if the calling thread is one of the pool workers
+         */
+      static bool in_worker()
+      {
+        return worker_flag();
+      }
+
+      ~thread_pool()
+      {
+        stop_workers();
+      }
+
+    private:
+      thread_pool() : num_threads(env_threads()), stopping(false) {}
+
+      static bool &worker_flag()
+      {
+        thread_local bool flag = false;
+        return flag;
+      }
+
+      static int default_threads()
+      {
+        int n = std::thread::hardware_concurrency();
+        return n < 1 ? 1 : n;
+      }
+
+      static int env_threads()
+      {
+        const char *env = std::getenv("MATRIX_NUM_THREADS");
+        int n = env ? std::atoi(env) : 0;
+        return n < 1 ? default_threads() : n;
+      }
+
+      // called with mtx held
+      void start_workers()
+      {
+        stopping = false;
+        for (int i = 1; i < num_threads; i++)
+          workers.emplace_back([this] {
+            worker_flag() = true;
+            while (true)
+            {
+              std::function<void()> task;
+              {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                  return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+              }
+              task();
+            }
+          });
+      }
+
+      void stop_workers()
+      {
+        std::vector<std::thread> old;
+        {
+          std::lock_guard<std::mutex> lock(mtx);
+          stopping = true;
+          old.swap(workers);
+        }
+        cv.notify_all();
+        for (auto &worker : old)
+          worker.join();
+      }
+
+      int num_threads;
+      bool stopping;
+      std::mutex mtx;
+      std::condition_variable cv;
+      std::deque<std::function<void()>> tasks;
+      std::vector<std::thread> workers;
+    };
+
+    /**
+     * Sets the number of threads used by the matrix operations
+     * values < 1 mean hardware concurrency
+     */
+    inline void set_num_threads(int n)
+    {
+        thread_pool::instance().resize(n);
+    }
+
+    /**
+     * @returns the number of threads used by the matrix operations
+     */
+    inline int get_num_threads()
+    {
+        return thread_pool::instance().size();
+    }
+
+    /**
+     * Calls fn(chunk_begin, chunk_end) on disjoint chunks covering
+     * [begin, end). The caller works on chunks too and returns when all of
+     * them are done. The first exception thrown by fn is rethrown.
+     *
+     * @param work total amount of work (e.g. elements touched), the loop
+     *             runs serially when it is below parallel_threshold
+     */
+    template <typename Function>
+    void parallel_for(int begin, int end, std::size_t work, Function fn)
+    {
+        if (end <= begin)
+            return;
+        const int threads = (work < parallel_threshold || thread_pool::in_worker())
+                                ? 1
+                                : get_num_threads();
+        const int count = end - begin;
+        if (threads <= 1 || count == 1)
+        {
+            fn(begin, end);
+            return;
+        }
+
+        struct shared_state
+        {
+            std::atomic<int> next{0};
+            std::atomic<int> done{0};
+            std::mutex mtx;
+            std::condition_variable cv;
+            std::exception_ptr error;
+        };
+        auto state = std::make_shared<shared_state>();
+        const int chunks = std::min(count, threads * 4);
+        const int chunk_size = (count + chunks - 1) / chunks;
+        const int num_chunks = (count + chunk_size - 1) / chunk_size;
+
+        auto work_loop = [state, begin, end, chunk_size, num_chunks, &fn] {
+            int chunk;
+            while ((chunk = state->next.fetch_add(1)) < num_chunks)
+            {
+                const int first = begin + chunk * chunk_size;
+                const int last = std::min(end, first + chunk_size);
+                try
+                {
+                    fn(first, last);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(state->mtx);
+                    if (!state->error)
+                        state->error = std::current_exception();
+                }
+                if (state->done.fetch_add(1) + 1 == num_chunks)
+                {
+                    std::lock_guard<std::mutex> lock(state->mtx);
+                    state->cv.notify_all();
+                }
+            }
+        };
+
+        const int helpers = std::min(threads, num_chunks) - 1;
+        for (int i = 0; i < helpers; i++)
+            thread_pool::instance().submit(work_loop);
+        work_loop();
+
+        std::unique_lock<std::mutex> lock(state->mtx);
+        state->cv.wait(lock, [&] { return state->done.load() == num_chunks; });
+        if (state->error)
+            std::rethrow_exception(state->error);
+    }
+}
+
+#endif // End of the file
@@ -0,0 +1,391 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file triangular_matrix.h
+ * @brief
+ *
+ * This file provides the <code>triangular_matrix</code> class, a lower or
+ * upper triangular square matrix packed row by row, n(n+1)/2 elements.
+ * The stored part of every row is contiguous, so products with vectors
+ * and dense matrices and the substitutions run on the SIMD kernels.
+ *
+ *  - det:              O(n), the product of the diagonal
+ *  - solve, multiply:  O(n^2) per vector
+ *  - invert, multiply by a triangular matrix: O(n^3 / 6), the result
+ *    is triangular too
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _TRIANGULAR_MATRIX_H_
+#define _TRIANGULAR_MATRIX_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+
+#include "matrix_def.h"
+#include "thread_pool.h"
+#include "simd_kernels.h"
+#include "structured_matrix.h"
+
+enum class matrix_triangle
+{
+  lower,
+  upper
+};
+
+template <typename ValueType>
+class triangular_matrix : public structured_matrix<triangular_matrix<ValueType>, ValueType>
+{
+public:
+  /**
+     * Constructs an (n x n) triangular matrix of zeros
+     * @bigoh O(n^2)
+     */
+  explicit triangular_matrix(int n = 0, matrix_triangle tri = matrix_triangle::lower);
+
+  /**
+     * Keeps the lower or upper triangle of a square dense matrix
+     * @throw length_error if it's not a square matrix
+     * @bigoh O(n^2)
+     */
+  template <typename Allocator>
+  triangular_matrix(const matrix<ValueType, Allocator> &mat, matrix_triangle tri);
+
+  bool operator==(const triangular_matrix &mat) const;
+
+  bool operator!=(const triangular_matrix &mat) const;
+
+  /**
+     * @returns element (i, j), zero outside the triangle, no bounds checking
+     */
+  ValueType operator()(int i, int j) const
+  {
+    return in_triangle(i, j) ? elements[offset(i) + (j - first_col(i))] : ValueType();
+  }
+
+  /**
+     * @returns a reference to the stored element (i, j)
+     * @throw out_of_range if (i, j) is outside the triangle
+     */
+  ValueType &at(int i, int j);
+
+  /**
+     * Multiply with a vector, a dense matrix or a triangular matrix
+     * of the same kind (lower or upper)
+     * @throw   length_error if the dimensions don't match, or the
+     *          triangles are not the same
+     * @bigoh O(n^2), O(n^2 x mat.columns) for a dense matrix,
+     *        O(n^3 / 6) for a triangular one
+     */
+  vector<ValueType> multiply(const vector<ValueType> &vec) const;
+
+  template <typename Allocator>
+  matrix<ValueType> multiply(const matrix<ValueType, Allocator> &mat) const;
+
+  triangular_matrix multiply(const triangular_matrix &mat) const;
+
+  /**
+     * @returns the determinant, the product of the diagonal
+     * @bigoh O(n)
+     */
+  ValueType det() const;
+
+  /**
+     * @throw   out_of_range if determinant = zero
+     * @returns the inverse, a triangular matrix of the same kind
+     * @bigoh O(n^3 / 6)
+     */
+  triangular_matrix invert() const;
+
+  /**
+     * Solves A x = vec by forward (lower) or back (upper) substitution
+     * @throw   length_error if vec.size() != n
+     * @throw   out_of_range if determinant = zero
+     * @bigoh O(n^2)
+     */
+  vector<ValueType> solve(const vector<ValueType> &vec) const;
+
+  /**
+     * Solves A X = mat for every column of mat
+     * @throw   length_error if mat.rows != n
+     * @throw   out_of_range if determinant = zero
+     * @bigoh O(n^2 x mat.columns)
+     */
+  template <typename Allocator>
+  matrix<ValueType> solve(const matrix<ValueType, Allocator> &mat) const;
+
+  int get_rows() const { return size; }
+
+  int get_cols() const { return size; }
+
+  matrix_triangle triangle() const { return tri; }
+
+  bool is_lower() const { return tri == matrix_triangle::lower; }
+
+private:
+  bool in_triangle(int i, int j) const { return is_lower() ? j <= i : j >= i; }
+
+  /**
+     * Row i holds columns [first_col(i), first_col(i) + row_length(i))
+     * starting at elements[offset(i)]
+     */
+  int first_col(int i) const { return is_lower() ? 0 : i; }
+
+  int row_length(int i) const { return is_lower() ? i + 1 : size - i; }
+
+  std::size_t offset(int i) const
+  {
+    const std::size_t r = i;
+    return is_lower() ? r * (r + 1) / 2 : r * size - r * (r - 1) / 2;
+  }
+
+  const ValueType *row(int i) const { return elements.data() + offset(i); }
+
+  ValueType *row(int i) { return elements.data() + offset(i); }
+
+  void check_singular(const char *name) const;
+
+  /**
+     * Substitution on one right hand side, x holds b on entry
+     */
+  void substitute(ValueType *x) const;
+
+  int size;
+  matrix_triangle tri;
+  vector<ValueType> elements;
+};
+
+template <typename ValueType>
+triangular_matrix<ValueType>::triangular_matrix(int n, matrix_triangle tri)
+    : size(n), tri(tri), elements(static_cast<std::size_t>(n) * (n + 1) / 2)
+{
+}
+
+template <typename ValueType>
+template <typename Allocator>
+triangular_matrix<ValueType>::triangular_matrix(const matrix<ValueType, Allocator> &mat, matrix_triangle tri)
+    : triangular_matrix(mat.get_rows(), tri)
+{
+    if (mat.get_rows() != mat.get_cols())
+        throw std::length_error("triangular_matrix -> matrix must be square");
+    for (int i = 0; i < size; i++)
+        std::copy_n(mat[i].data() + first_col(i), row_length(i), row(i));
+}
+
+template <typename ValueType>
+bool triangular_matrix<ValueType>::operator==(const triangular_matrix &mat) const
+{
+    if (size != mat.size)
+        return false;
+    if (tri == mat.tri)
+        return elements == mat.elements;
+    // a lower and an upper matrix are equal only if both are diagonal
+    for (int i = 0; i < size; i++)
+        for (int j = 0; j < size; j++)
+            if ((*this)(i, j) != mat(i, j))
+                return false;
+    return true;
+}
+
+template <typename ValueType>
+inline bool triangular_matrix<ValueType>::operator!=(const triangular_matrix &mat) const
+{
+    return !(*this == mat);
+}
+
+template <typename ValueType>
+ValueType &triangular_matrix<ValueType>::at(int i, int j)
+{
+    if (i < 0 || i >= size || j < 0 || j >= size || !in_triangle(i, j))
+        throw std::out_of_range("triangular_matrix::at -> index out of range");
+    return row(i)[j - first_col(i)];
+}
+
+template <typename ValueType>
+vector<ValueType> triangular_matrix<ValueType>::multiply(const vector<ValueType> &vec) const
+{
+    if (vec.size() != static_cast<std::size_t>(size))
+        throw std::length_error("triangular_matrix::multiply -> vector.size() must be equal to matrix::cols");
+    vector<ValueType> res(size);
+    const std::size_t work = elements.size();
+    matrix_parallel::parallel_for(0, size, work, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+            res[i] = matrix_kernels::vec_dot(row_length(i), row(i), vec.data() + first_col(i));
+    });
+    return res;
+}
+
+template <typename ValueType>
+template <typename Allocator>
+matrix<ValueType> triangular_matrix<ValueType>::multiply(const matrix<ValueType, Allocator> &mat) const
+{
+    if (mat.get_rows() != size)
+        throw std::length_error("triangular_matrix::multiply -> check matrices dimentions");
+    const int cols = mat.get_cols();
+    matrix<ValueType> res(size, cols);
+    const std::size_t work = elements.size() * cols;
+    matrix_parallel::parallel_for(0, size, work, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            const ValueType *a = row(i);
+            for (int t = 0; t < row_length(i); t++)
+                matrix_kernels::vec_axpy(cols, a[t], mat[first_col(i) + t].data(), res[i].data());
+        }
+    });
+    return res;
+}
+
+template <typename ValueType>
+triangular_matrix<ValueType> triangular_matrix<ValueType>::multiply(const triangular_matrix &mat) const
+{
+    if (mat.size != size)
+        throw std::length_error("triangular_matrix::multiply -> check matrices dimentions");
+    if (mat.tri != tri)
+        throw std::length_error("triangular_matrix::multiply -> both matrices must be lower or upper");
+    triangular_matrix res(size, tri);
+    const std::size_t work = elements.size() * size / 3;
+    matrix_parallel::parallel_for(0, size, work, [&](int first, int last) {
+        for (int i = first; i < last; i++)
+        {
+            // row i of the result is a combination of the rows k of mat
+            // that are in the triangle, their stored parts line up with
+            // the end (lower) or the start (upper) of row i
+            const ValueType *a = row(i);
+            ValueType *c = res.row(i);
+            for (int t = 0; t < row_length(i); t++)
+            {
+                const int k = first_col(i) + t;
+                if (is_lower())
+                    matrix_kernels::vec_axpy(k + 1, a[t], mat.row(k), c);
+                else
+                    matrix_kernels::vec_axpy(size - k, a[t], mat.row(k), c + t);
+            }
+        }
+    });
+    return res;
+}
+
+template <typename ValueType>
+ValueType triangular_matrix<ValueType>::det() const
+{
+    ValueType det_val = static_cast<ValueType>(1);
+    for (int i = 0; i < size; i++)
+        det_val *= (*this)(i, i);
+    return det_val;
+}
+
+template <typename ValueType>
+void triangular_matrix<ValueType>::check_singular(const char *name) const
+{
+    for (int i = 0; i < size; i++)
+        if ((*this)(i, i) == static_cast<ValueType>(0))
+            throw std::out_of_range(std::string(name) + " -> Determinant equal zero");
+}
+
+template <typename ValueType>
+triangular_matrix<ValueType> triangular_matrix<ValueType>::invert() const
+{
+    check_singular("triangular_matrix::invert");
+    triangular_matrix inv(size, tri);
+    if (is_lower())
+    {
+        // L X = I row by row: X(i, j) = -(sum L(i, k) X(k, j), j <= k < i) / L(i, i)
+        for (int i = 0; i < size; i++)
+        {
+            const ValueType *l = row(i);
+            ValueType *x = inv.row(i);
+            for (int k = 0; k < i; k++)
+                matrix_kernels::vec_axpy(k + 1, -l[k], inv.row(k), x);
+            x[i] = static_cast<ValueType>(1);
+            matrix_kernels::vec_div_scalar(i + 1, x, l[i]);
+        }
+    }
+    else
+    {
+        // U X = I from the last row up: X(i, j) = -(sum U(i, k) X(k, j), i < k <= j) / U(i, i)
+        for (int i = size - 1; i >= 0; i--)
+        {
+            const ValueType *u = row(i);
+            ValueType *x = inv.row(i);
+            x[0] = static_cast<ValueType>(1);
+            for (int t = 1; t < size - i; t++)
+                matrix_kernels::vec_axpy(size - i - t, -u[t], inv.row(i + t), x + t);
+            matrix_kernels::vec_div_scalar(size - i, x, u[0]);
+        }
+    }
+    return inv;
+}
+
+template <typename ValueType>
+void triangular_matrix<ValueType>::substitute(ValueType *x) const
+{
+    if (is_lower())
+    {
+        for (int i = 0; i < size; i++)
+            x[i] = (x[i] - matrix_kernels::vec_dot(i, row(i), x)) / row(i)[i];
+    }
+    else
+    {
+        for (int i = size - 1; i >= 0; i--)
+        {
+            const ValueType *u = row(i);
+            x[i] = (x[i] - matrix_kernels::vec_dot(size - i - 1, u + 1, x + i + 1)) / u[0];
+        }
+    }
+}
+
+template <typename ValueType>
+vector<ValueType> triangular_matrix<ValueType>::solve(const vector<ValueType> &vec) const
+{
+    if (vec.size() != static_cast<std::size_t>(size))
+        throw std::length_error("triangular_matrix::solve -> vector.size() must be equal to matrix::rows");
+    check_singular("triangular_matrix::solve");
+    vector<ValueType> x(vec);
+    substitute(x.data());
+    return x;
+}
+
+template <typename ValueType>
+template <typename Allocator>
+matrix<ValueType> triangular_matrix<ValueType>::solve(const matrix<ValueType, Allocator> &mat) const
+{
+    if (mat.get_rows() != size)
+        throw std::length_error("triangular_matrix::solve -> check matrix dimentions");
+    check_singular("triangular_matrix::solve");
+    const int cols = mat.get_cols();
+    matrix<ValueType> x(mat);
+    // the same substitution on rows of x, every step updates a whole row
+    if (is_lower())
+    {
+        for (int i = 0; i < size; i++)
+        {
+            const ValueType *l = row(i);
+            for (int k = 0; k < i; k++)
+                matrix_kernels::vec_axpy(cols, -l[k], x[k].data(), x[i].data());
+            matrix_kernels::vec_div_scalar(cols, x[i].data(), l[i]);
+        }
+    }
+    else
+    {
+        for (int i = size - 1; i >= 0; i--)
+        {
+            const ValueType *u = row(i);
+            for (int t = 1; t < size - i; t++)
+                matrix_kernels::vec_axpy(cols, -u[t], x[i + t].data(), x[i].data());
+            matrix_kernels::vec_div_scalar(cols, x[i].data(), u[0]);
+        }
+    }
+    return x;
+}
+
+#endif // End of the file
@@ -0,0 +1,413 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file calculator.cpp
+ * @brief
+ *
+ * This file implements the complex matrix calculator, serial and batch
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+#include "calculator.h"
+#include "matrix.h"
+#include "parsing.h"
+
+#include <mutex>
+#include <memory>
+#include <streambuf>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <condition_variable>
+
+using std::string;
+
+bool skip_to_start(std::istream &in)
+{
+    string s;
+    while (s != "start")
+    {
+        if (!std::getline(in, s))
+            return false;
+    }
+    return true;
+}
+
+bool read_block(std::istream &in, expression_graph &graph, calc_block &block)
+{
+    string s;
+    do
+    {
+        if (!std::getline(in, s) || s == "end")
+            return false;
+    } while (s.empty());
+    block.lhs = std::move(s);
+    block.op.clear();
+    block.rhs.clear();
+    block.power = 0;
+    block.is_statement = is_statement(block.lhs);
+    if (block.is_statement)
+    {
+        block.statement = graph.compile(block.lhs);
+        return true;
+    }
+    block.statement = calc_statement();
+    std::getline(in, block.op);
+    if (block.op == "+" || block.op == "-" || block.op == "*" || block.op == "/")
+        std::getline(in, block.rhs);
+    else if (block.op == "^")
+        in >> block.power;
+    return true;
+}
+
+bool evaluate_block(const calc_block &block, std::ostream &out, std::ostream &err, bool binary)
+{
+    // a result is printed on one line, or saved as a matrix record, then
+    // out holds records only and the messages go to err
+    auto emit = [&out, binary](auto &&result) {
+        if (binary)
+            result.save(out);
+        else
+            result.print_l(out);
+    };
+
+    try
+    {
+        if (block.is_statement)
+        {
+            const matrix<complex<float>> &value = evaluate_statement(block.statement);
+            if (!block.statement.name.empty())
+                return false;
+            emit(value);
+            if (!binary)
+                out << '\n';
+            return false;
+        }
+        matrix<complex<float>> matrix1 = parse_complex_input(block.lhs);
+        const string &op = block.op;
+        if (op == "+")
+            emit(matrix1 += parse_complex_input(block.rhs));
+        else if (op == "-")
+            emit(matrix1 -= parse_complex_input(block.rhs));
+        else if (op == "*")
+            emit(matrix1.multiply(parse_complex_input(block.rhs)));
+        else if (op == "^")
+            emit(matrix1.power(block.power));
+        else if (op == "T")
+            emit(matrix1.transpose());
+        else if (op == "D")
+        {
+            if (binary)
+            {
+                matrix<complex<float>> det(1, 1);
+                det[0][0] = determinant_recursive(matrix1);
+                emit(det);
+            }
+            else
+                out << determinant_recursive(matrix1);
+        }
+        else if (op == "I")
+            emit(matrix1.invert());
+        else if (op == "/")
+            emit(matrix1.multiply(parse_complex_input(block.rhs).invert()));
+        else
+        {
+            if (binary)
+                err << "Invalid opeartor\n";
+            else
+                out << "\nInvalid opeartor\n";
+            return true;
+        }
+    }
+    catch (...)
+    {
+        if (binary)
+            err << "ERROR\n";
+        else
+            out << "ERROR";
+        return true;
+    }
+    if (!binary)
+        out << '\n';
+    return false;
+}
+
+void run_serial(std::istream &in, std::ostream &out, std::ostream &err, bool binary)
+{
+    // scratch of every operation is taken from here and given back
+    // at the end of the block, after the first blocks nothing is allocated
+    matrix_arena arena;
+    expression_graph graph;
+    calc_block block;
+    while (read_block(in, graph, block))
+    {
+        scoped_arena scope(arena);
+        const bool stop = evaluate_block(block, out, err, binary);
+        out.flush();
+        if (stop)
+            return;
+    }
+}
+
+/**
+ * Stream buffer reading from another one, calls before_wait when the
+ * next read of the other one may wait for input
+ */
+class waiting_buf : public std::streambuf
+{
+public:
+  waiting_buf(std::streambuf *src, std::function<void()> before_wait)
+      : src(src), before_wait(std::move(before_wait))
+  {
+  }
+
+protected:
+  int_type underflow() override
+  {
+    if (src->in_avail() <= 0)
+      before_wait();
+    if (traits_type::eq_int_type(src->sgetc(), traits_type::eof()))
+      return traits_type::eof();
+    // what is buffered, at least the character sgetc waited for
+    const std::streamsize avail = std::max<std::streamsize>(1, src->in_avail());
+    const std::streamsize n = src->sgetn(buffer, std::min<std::streamsize>(sizeof(buffer), avail));
+    setg(buffer, buffer, buffer + n);
+    return traits_type::to_int_type(buffer[0]);
+  }
+
+private:
+  std::streambuf *src;
+  std::function<void()> before_wait;
+  char buffer[1 << 14];
+};
+
+/**
+ * The state shared by the stages of the batch mode. Block i is kept in
+ * slot i % slots.size() from the time it is read until its result is
+ * written, the reader waits for a free slot.
+ *
+ * Blocks are handed over in groups: the reader wakes the workers when a
+ * group is pending or before it waits for input, a worker claims a group
+ * of consecutive blocks and wakes the writer once they are done.
+ */
+class batch_pipeline
+{
+public:
+  batch_pipeline(int workers, bool binary)
+      : slots(group * (static_cast<std::size_t>(workers) + 1)), workers(workers), binary(binary)
+  {
+  }
+
+  /**
+     * Reads the blocks of in and puts them in the slots
+     */
+  void read(std::istream &in)
+  {
+    // the blocks read so far must be evaluated while the reader waits
+    waiting_buf buf(in.rdbuf(), [this] {
+      std::lock_guard<std::mutex> lock(mtx);
+      if (idle_workers && claimed < read_count)
+        work_cv.notify_all();
+    });
+    std::istream src(&buf);
+    calc_block block;
+    for (;;)
+    {
+      const bool more = read_block(src, graph, block);
+      std::unique_lock<std::mutex> lock(mtx);
+      if (!more)
+      {
+        input_done = true;
+        work_cv.notify_all();
+        write_cv.notify_one();
+        return;
+      }
+      if (!stopping && read_count == written + slots.size())
+      {
+        reader_waiting = true;
+        read_cv.wait(lock, [this] { return stopping || read_count < written + slots.size(); });
+        reader_waiting = false;
+      }
+      if (stopping)
+        return;
+      slot &s = slots[read_count % slots.size()];
+      s.block = std::move(block);
+      s.done = false;
+      read_count++;
+      if (idle_workers && (read_count - claimed >= group || read_count == written + slots.size()))
+        work_cv.notify_all();
+    }
+  }
+
+  /**
+     * Evaluates the blocks in groups, each block in its own arena scope
+     */
+  void work()
+  {
+    matrix_arena arena;
+    std::ostringstream result;
+    std::ostringstream message;
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;)
+    {
+      if (!stopping && claimed == read_count && !input_done)
+      {
+        idle_workers++;
+        work_cv.wait(lock, [this] { return stopping || claimed < read_count || input_done; });
+        idle_workers--;
+      }
+      if (stopping || claimed == read_count)
+        return;
+      // the slots belong to this worker until they are marked done
+      const std::size_t pending = read_count - claimed;
+      const std::size_t count = std::min(group, std::max<std::size_t>(1, pending / workers));
+      const std::size_t first = claimed;
+      claimed += count;
+      lock.unlock();
+
+      for (std::size_t i = first; i < first + count; i++)
+      {
+        slot &s = slots[i % slots.size()];
+        result.str(string());
+        message.str(string());
+        {
+          scoped_arena scope(arena);
+          s.last = evaluate_block(s.block, result, message, binary);
+        }
+        s.result = result.str();
+        s.message = message.str();
+        // the nodes of the statement are not needed by the writer
+        s.block.statement = calc_statement();
+      }
+
+      lock.lock();
+      for (std::size_t i = first; i < first + count; i++)
+        slots[i % slots.size()].done = true;
+      if (writer_waiting && first <= written)
+        write_cv.notify_one();
+    }
+  }
+
+  /**
+     * Writes the results in input order, the stream is flushed when
+     * everything read so far is written
+     * @returns false if a block stopped the calculator before the end of
+     *          the input, the reader may still be waiting for a line
+     */
+  bool write(std::ostream &out, std::ostream &err)
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;)
+    {
+      auto ready = [this] {
+        return (written < read_count && slots[written % slots.size()].done) ||
+               (input_done && written == read_count);
+      };
+      if (!ready())
+      {
+        // waiting for the input, what was written must be seen
+        if (written == read_count)
+        {
+          lock.unlock();
+          out.flush();
+          lock.lock();
+        }
+        writer_waiting = true;
+        write_cv.wait(lock, ready);
+        writer_waiting = false;
+      }
+      if (written == read_count)
+        break;
+      slot &s = slots[written % slots.size()];
+      const string text = std::move(s.result);
+      const string message = std::move(s.message);
+      const bool last = s.last;
+      lock.unlock();
+      out.write(text.data(), text.size());
+      if (!message.empty())
+      {
+        out.flush();
+        err.write(message.data(), message.size());
+      }
+      lock.lock();
+      written++;
+      if (reader_waiting)
+        read_cv.notify_one();
+      if (last)
+        break;
+    }
+    stopping = true;
+    const bool finished = input_done;
+    work_cv.notify_all();
+    read_cv.notify_all();
+    lock.unlock();
+    out.flush();
+    return finished;
+  }
+
+private:
+  /**
+     * blocks handed over at once
+     */
+  static constexpr std::size_t group = 16;
+
+  struct slot
+  {
+    calc_block block;
+    string result;
+    string message;
+    bool last = false;
+    bool done = false;
+  };
+
+  /**
+     * variables of the session, used by the reader only
+     */
+  expression_graph graph;
+  std::vector<slot> slots;
+  std::size_t workers;
+  bool binary;
+  std::mutex mtx;
+  std::condition_variable read_cv;
+  std::condition_variable work_cv;
+  std::condition_variable write_cv;
+  std::size_t read_count = 0;
+  std::size_t claimed = 0;
+  std::size_t written = 0;
+  int idle_workers = 0;
+  bool reader_waiting = false;
+  bool writer_waiting = false;
+  bool input_done = false;
+  bool stopping = false;
+};
+
+void run_batch(std::istream &in, std::ostream &out, std::ostream &err, bool binary, int workers)
+{
+    workers = std::max(workers, 1);
+    // shared with the reader, which can outlive this call
+    auto pipeline = std::make_shared<batch_pipeline>(workers, binary);
+    std::thread reader([pipeline, &in] { pipeline->read(in); });
+    std::vector<std::thread> pool;
+    for (int i = 0; i < workers; i++)
+        pool.emplace_back([&pipeline] { pipeline->work(); });
+    const bool finished = pipeline->write(out, err);
+    for (auto &worker : pool)
+        worker.join();
+    if (finished)
+        reader.join();
+    else
+    {
+        // stopped early, the reader may be blocked on a pipe or a terminal
+        // that stays open, it returns after its next read
+        reader.detach();
+    }
+}
@@ -0,0 +1,560 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file expression_graph.cpp
+ * @brief
+ *
+ * This file implements the statement compiler and the evaluation of the
+ * expression DAG of the calculator
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+#include "expression_graph.h"
+#include "parsing.h"
+
+#include <mutex>
+#include <vector>
+#include <cctype>
+#include <utility>
+#include <charconv>
+#include <algorithm>
+#include <condition_variable>
+
+using std::string;
+using std::complex;
+
+using value_matrix = matrix<complex<float>>;
+
+enum expr_op
+{
+    op_literal,
+    op_add,
+    op_sub,
+    op_mul,
+    op_div,
+    op_neg,
+    op_power,
+    op_transpose,
+    op_invert,
+    op_det
+};
+
+/**
+ * A node of the DAG. op, power, id and text don't change after the node
+ * is made, the rest is guarded by mtx.
+ */
+struct expr_node
+{
+    enum node_state
+    {
+        pending,
+        running,
+        done
+    };
+
+    expr_op op = op_literal;
+    int power = 0;
+    std::uint64_t id = 0;
+    /**
+     * text of a literal
+     */
+    string text;
+    /**
+     * operands, released once the node is evaluated
+     */
+    std::shared_ptr<expr_node> args[2];
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    node_state state = pending;
+    value_matrix value;
+    std::exception_ptr error;
+};
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static bool is_name_start(char c)
+{
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+static bool is_name_char(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool is_statement(std::string_view line)
+{
+    std::size_t p = 0;
+    while (p < line.size() && is_space(line[p]))
+        p++;
+    if (p == line.size() || line[p] != '[')
+        return true;
+    // a malformed literal is reported by the operator block
+    const std::size_t close = line.find(']', p);
+    if (close == std::string_view::npos)
+        return false;
+    for (p = close + 1; p < line.size(); p++)
+    {
+        if (!is_space(line[p]))
+            return true;
+    }
+    return false;
+}
+
+/***************************************************************************
+ *************************  compiling statements  **************************
+ ***************************************************************************/
+
+bool expression_graph::node_key::operator==(const node_key &key) const
+{
+    return op == key.op && power == key.power && lhs == key.lhs && rhs == key.rhs && text == key.text;
+}
+
+std::size_t expression_graph::node_hash::operator()(const node_key &key) const
+{
+    std::size_t h = std::hash<string>()(key.text);
+    for (std::uint64_t v : {static_cast<std::uint64_t>(key.op), static_cast<std::uint64_t>(key.power), key.lhs, key.rhs})
+        h ^= std::hash<std::uint64_t>()(v) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+std::shared_ptr<expr_node> expression_graph::make_node(node_key key, std::shared_ptr<expr_node> lhs,
+                                                       std::shared_ptr<expr_node> rhs)
+{
+    // the operands of + commute, A + B and B + A are one node
+    if (key.op == op_add && key.lhs > key.rhs)
+    {
+        std::swap(key.lhs, key.rhs);
+        std::swap(lhs, rhs);
+    }
+    auto found = nodes.find(key);
+    if (found != nodes.end())
+    {
+        if (auto node = found->second.lock())
+            return node;
+    }
+    auto node = std::make_shared<expr_node>();
+    node->op = static_cast<expr_op>(key.op);
+    node->power = key.power;
+    node->id = next_id++;
+    node->text = key.text;
+    node->args[0] = std::move(lhs);
+    node->args[1] = std::move(rhs);
+    nodes.insert_or_assign(std::move(key), node);
+    return node;
+}
+
+/**
+ * Recursive descent over one statement line:
+ *
+ *     statement  := [name '='] expression
+ *     expression := term { ('+' | '-') term }
+ *     term       := unary { ('*' | '/') unary }
+ *     unary      := '-' unary | postfix
+ *     postfix    := primary { '^' integer | '\'' }
+ *     primary    := literal | name | function '(' expression ')' | '(' expression ')'
+ */
+class expression_graph::parser
+{
+public:
+  parser(expression_graph &graph, std::string_view line) : graph(graph), line(line) {}
+
+  calc_statement statement()
+  {
+    calc_statement res;
+    skip();
+    if (pos < line.size() && is_name_start(line[pos]))
+    {
+      const std::size_t start = pos;
+      const std::size_t end = name_end();
+      skip();
+      if (pos < line.size() && line[pos] == '=')
+      {
+        res.name = string(line.substr(start, end - start));
+        pos++;
+      }
+      else
+        pos = start;
+    }
+    res.root = expression();
+    skip();
+    if (pos != line.size())
+      fail("unexpected '" + string(1, line[pos]) + "'");
+    return res;
+  }
+
+private:
+  std::shared_ptr<expr_node> expression()
+  {
+    std::shared_ptr<expr_node> lhs = term();
+    for (;;)
+    {
+      if (accept('+'))
+        lhs = binary(op_add, std::move(lhs), term());
+      else if (accept('-'))
+        lhs = binary(op_sub, std::move(lhs), term());
+      else
+        return lhs;
+    }
+  }
+
+  std::shared_ptr<expr_node> term()
+  {
+    std::shared_ptr<expr_node> lhs = unary();
+    for (;;)
+    {
+      if (accept('*'))
+        lhs = binary(op_mul, std::move(lhs), unary());
+      else if (accept('/'))
+        lhs = binary(op_div, std::move(lhs), unary());
+      else
+        return lhs;
+    }
+  }
+
+  std::shared_ptr<expr_node> unary()
+  {
+    if (accept('-'))
+      return binary(op_neg, unary(), nullptr);
+    return postfix();
+  }
+
+  std::shared_ptr<expr_node> postfix()
+  {
+    std::shared_ptr<expr_node> operand = primary();
+    for (;;)
+    {
+      if (accept('\''))
+        operand = binary(op_transpose, std::move(operand), nullptr);
+      else if (accept('^'))
+      {
+        skip();
+        int n = 0;
+        const char *first = line.data() + pos;
+        const auto res = std::from_chars(first, line.data() + line.size(), n);
+        if (res.ec != std::errc())
+          fail("expected an integer power");
+        pos += res.ptr - first;
+        node_key key{op_power, n, operand->id, 0, string()};
+        operand = graph.make_node(std::move(key), std::move(operand), nullptr);
+      }
+      else
+        return operand;
+    }
+  }
+
+  std::shared_ptr<expr_node> primary()
+  {
+    skip();
+    if (pos == line.size())
+      fail("expected an operand");
+    const char c = line[pos];
+    if (c == '[')
+    {
+      const std::size_t close = line.find(']', pos);
+      if (close == std::string_view::npos)
+        fail("missing ']'");
+      string text(line.substr(pos, close + 1 - pos));
+      pos = close + 1;
+      return graph.make_node({op_literal, 0, 0, 0, std::move(text)}, nullptr, nullptr);
+    }
+    if (c == '(')
+    {
+      pos++;
+      std::shared_ptr<expr_node> res = expression();
+      expect(')');
+      return res;
+    }
+    if (!is_name_start(c))
+      fail("expected an operand");
+
+    const std::size_t start = pos;
+    const string name(line.substr(start, name_end() - start));
+    if (accept('('))
+    {
+      expr_op op;
+      if (name == "inv")
+        op = op_invert;
+      else if (name == "det")
+        op = op_det;
+      else if (name == "trans")
+        op = op_transpose;
+      else
+        fail_at(start, "unknown function '" + name + "'");
+      std::shared_ptr<expr_node> arg = expression();
+      expect(')');
+      return binary(op, std::move(arg), nullptr);
+    }
+    auto found = graph.variables.find(name);
+    if (found == graph.variables.end())
+      fail_at(start, "unknown variable '" + name + "'");
+    return found->second;
+  }
+
+  std::shared_ptr<expr_node> binary(expr_op op, std::shared_ptr<expr_node> lhs, std::shared_ptr<expr_node> rhs)
+  {
+    node_key key{op, 0, lhs->id, rhs ? rhs->id : 0, string()};
+    return graph.make_node(std::move(key), std::move(lhs), std::move(rhs));
+  }
+
+  std::size_t name_end()
+  {
+    while (pos < line.size() && is_name_char(line[pos]))
+      pos++;
+    return pos;
+  }
+
+  void skip()
+  {
+    while (pos < line.size() && is_space(line[pos]))
+      pos++;
+  }
+
+  bool accept(char c)
+  {
+    skip();
+    if (pos < line.size() && line[pos] == c)
+    {
+      pos++;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c)
+  {
+    if (!accept(c))
+      fail(string("expected '") + c + "'");
+  }
+
+  [[noreturn]] void fail(const string &msg) { fail_at(pos, msg); }
+
+  [[noreturn]] void fail_at(std::size_t at, const string &msg) { throw parse_error(at + 1, msg); }
+
+  expression_graph &graph;
+  std::string_view line;
+  std::size_t pos = 0;
+};
+
+calc_statement expression_graph::compile(std::string_view line)
+{
+    calc_statement res;
+    try
+    {
+        res = parser(*this, line).statement();
+        if (!res.name.empty())
+            variables[res.name] = res.root;
+    }
+    catch (...)
+    {
+        res.root.reset();
+        res.error = std::current_exception();
+    }
+    // forget the nodes nobody refers to anymore
+    if (nodes.size() > 2 * swept_size + 64)
+    {
+        for (auto it = nodes.begin(); it != nodes.end();)
+        {
+            if (it->second.expired())
+                it = nodes.erase(it);
+            else
+                ++it;
+        }
+        swept_size = nodes.size();
+    }
+    return res;
+}
+
+/***************************************************************************
+ ***************************  evaluating nodes  ****************************
+ ***************************************************************************/
+
+/**
+ * value of a node from the values of its operands
+ */
+static value_matrix apply(const expr_node &node, value_matrix *lhs, value_matrix *rhs)
+{
+    switch (node.op)
+    {
+    case op_literal:
+        return parse_complex_input(node.text);
+    case op_add:
+    {
+        value_matrix res = *lhs;
+        return std::move(res += *rhs);
+    }
+    case op_sub:
+    {
+        value_matrix res = *lhs;
+        return std::move(res -= *rhs);
+    }
+    case op_mul:
+        return lhs->multiply(*rhs);
+    case op_div:
+        return lhs->multiply(rhs->invert());
+    case op_neg:
+    {
+        // 0 - x, -x would print the zeros as -0
+        value_matrix res(lhs->get_rows(), lhs->get_cols());
+        return std::move(res -= *lhs);
+    }
+    case op_power:
+        return lhs->power(node.power);
+    case op_transpose:
+        return lhs->transpose();
+    case op_invert:
+        return lhs->invert();
+    case op_det:
+        return std::move(value_matrix(1, 1) += determinant_recursive(*lhs));
+    }
+    throw std::logic_error("expression_graph -> unknown operation");
+}
+
+/**
+ * Evaluates a node whose operands are evaluated, or waits for the
+ * thread evaluating it
+ */
+static void compute(expr_node &node)
+{
+    std::shared_ptr<expr_node> lhs, rhs;
+    {
+        std::unique_lock<std::mutex> lock(node.mtx);
+        if (node.state == expr_node::running)
+            node.cv.wait(lock, [&node] { return node.state == expr_node::done; });
+        if (node.state == expr_node::done)
+            return;
+        node.state = expr_node::running;
+        lhs = node.args[0];
+        rhs = node.args[1];
+    }
+
+    value_matrix value;
+    std::exception_ptr error;
+    try
+    {
+        for (expr_node *arg : {lhs.get(), rhs.get()})
+        {
+            if (arg && arg->error)
+                std::rethrow_exception(arg->error);
+        }
+        value = apply(node, lhs ? &lhs->value : nullptr, rhs ? &rhs->value : nullptr);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(node.mtx);
+        node.value = std::move(value);
+        node.error = error;
+        node.state = expr_node::done;
+        node.args[0].reset();
+        node.args[1].reset();
+    }
+    node.cv.notify_all();
+}
+
+/**
+ * Elements touched by the evaluation of a node whose operands are
+ * evaluated, tells whether a level is worth the thread pool
+ */
+static std::size_t cost(expr_node &node)
+{
+    std::shared_ptr<expr_node> lhs, rhs;
+    {
+        std::lock_guard<std::mutex> lock(node.mtx);
+        if (node.state != expr_node::pending)
+            return 0;
+        lhs = node.args[0];
+        rhs = node.args[1];
+    }
+    if (!lhs)
+        return node.text.size();
+    const std::size_t rows = lhs->value.get_rows();
+    const std::size_t cols = lhs->value.get_cols();
+    switch (node.op)
+    {
+    case op_mul:
+    case op_div:
+        return rows * cols * rhs->value.get_cols();
+    case op_power:
+    case op_invert:
+    case op_det:
+        return rows * rows * cols;
+    default:
+        return rows * cols;
+    }
+}
+
+/**
+ * Puts the pending nodes under node in levels, a node after its operands
+ * @returns the level of node, -1 if it is evaluated
+ */
+static int collect(const std::shared_ptr<expr_node> &node, std::unordered_map<const expr_node *, int> &level,
+                   std::vector<std::vector<std::shared_ptr<expr_node>>> &levels)
+{
+    auto found = level.find(node.get());
+    if (found != level.end())
+        return found->second;
+    std::shared_ptr<expr_node> args[2];
+    {
+        std::lock_guard<std::mutex> lock(node->mtx);
+        if (node->state == expr_node::done)
+            return level[node.get()] = -1;
+        args[0] = node->args[0];
+        args[1] = node->args[1];
+    }
+    int res = 0;
+    for (const auto &arg : args)
+    {
+        if (arg)
+            res = std::max(res, collect(arg, level, levels) + 1);
+    }
+    if (levels.size() <= static_cast<std::size_t>(res))
+        levels.resize(res + 1);
+    levels[res].push_back(node);
+    return level[node.get()] = res;
+}
+
+const value_matrix &evaluate_statement(const calc_statement &statement)
+{
+    if (statement.error)
+        std::rethrow_exception(statement.error);
+
+    std::unordered_map<const expr_node *, int> level;
+    std::vector<std::vector<std::shared_ptr<expr_node>>> levels;
+    collect(statement.root, level, levels);
+    for (const auto &nodes : levels)
+    {
+        if (nodes.size() == 1)
+        {
+            compute(*nodes[0]);
+            continue;
+        }
+        std::size_t work = 0;
+        for (const auto &node : nodes)
+            work += cost(*node);
+        matrix_parallel::parallel_for(0, static_cast<int>(nodes.size()), work, [&nodes](int first, int last) {
+            for (int i = first; i < last; i++)
+                compute(*nodes[i]);
+        });
+    }
+
+    expr_node &root = *statement.root;
+    std::lock_guard<std::mutex> lock(root.mtx);
+    if (root.error)
+        std::rethrow_exception(root.error);
+    return root.value;
+}
@@ -11,103 +11,63 @@
  * 
  * This file implements complex matrix calculator using <code>matrix</code> class
  * the input must start with "start" line and ends with "end" line
- * the input can be from a file of the standard input
- * the output is to the standard output
+ * the input can be from a file of the standard input, its blocks and
+ * statements with variables are described in calculator.h
+ * the output is to the standard output, as text or with -b as binary
+ * matrix records (see matrix_file.h), one per result, with the error
+ * messages to the standard error
+ *
+ *     main.out [-b] [-j] [input file]
+ *
+ * -j evaluates the blocks in parallel (see calculator.h), with
+ * MATRIX_NUM_THREADS workers or one per hardware thread
+ *
+ * MATRIX_CACHE_BYTES and MATRIX_CACHE_DIR keep the inverses, powers and
+ * determinants for the next blocks and the next runs (see matrix_cache.h)
+ *
+ * built with make PROFILE=1, MATRIX_PROFILE_REPORT prints the time spent in
+ * every matrix operation and MATRIX_PROFILE_TRACE writes a Chrome trace of
+ * the calls (see matrix_profile.h)
  *
  * @author Hassan El-shazly
- * @date Last Edit Jul-2020
+ * @date Last Edit Oct-2026
  *
  */
 
 #include <iostream>
-#include <vector>
+#include <string>
 
 #include "matrix.h"
-#include "parsing.h"
+#include "calculator.h"
 
 using namespace std;
 
 
 int main(int argc, char ** argv)
 {
-    if(argc > 1) 
-    {
-        freopen(argv[1], "r", stdin);
-    }
-    try
+    bool binary = false;
+    bool batch = false;
+    for(int i = 1; i < argc; i++)
     {
-        matrix<complex<float>> matrix1, matrix2;
-        string s = ""; 
-        
-        while(s != "start") {
-            getline(cin, s);
-        }
-        while(true) {
-            getline(cin, s);
-            if(s == "end") {
-                break;
-            }
-            if(s == "") {
-                continue;
-            }
-            matrix1 = parse_complex_input(s);
-            string op; getline(cin, op);
-            
-            if(op == "+")
-            {
-                getline(cin, s);
-                matrix2 = parse_complex_input(s) ;
-                (matrix1 += matrix2).print_l() ;
-            }
-            else if(op == "-")
-            {
-                getline(cin, s);
-                matrix2 = parse_complex_input(s) ;
-                (matrix1 -= matrix2).print_l() ;
-            }
-            else if(op == "*")
-            {
-                getline(cin, s);
-                matrix2 = parse_complex_input(s) ;
-                matrix1.multiply(matrix2).print_l() ;
-            }
-            else if(op == "^")
-            {
-                int n; cin >> n ;
-                matrix1.power(n).print_l();
-            }
-            else if(op == "T")
-            {
-                matrix1.transpose().print_l();
-            }
-            else if(op == "D")
-            {
-                cout << determinant_recursive(matrix1);
-            }
-            else if(op == "I")
-            {
-                matrix1.invert().print_l();
-            }
-            else if(op == "/")
-            {
-                getline(cin, s);
-                matrix2 = parse_complex_input(s);
-                matrix2 = matrix2.invert();
-                matrix1.multiply(matrix2).print_l();
-            }
-            else 
-            {
-                cout << "\nInvalid opeartor\n";
-                return 0;
-            }
-            cout << std::endl;
-        }
+        const string arg = argv[i];
+        if(arg == "-b")
+            binary = true;
+        else if(arg == "-j")
+            batch = true;
+        else
+            freopen(argv[i], "r", stdin);
     }
-    catch(...)
-    {
-        cout << "ERROR" ;
-        return 0 ;
-    }
-     
-}
 
+    // the reader of the batch mode needs to see what is buffered,
+    // this must come before anything is read
+    if(batch)
+        ios::sync_with_stdio(false);
+
+    if(!skip_to_start(cin))
+        return 0;
+    if(batch)
+        run_batch(cin, cout, cerr, binary, matrix_parallel::get_num_threads());
+    else
+        run_serial(cin, cout, cerr, binary);
+    return 0;
+}
@@ -0,0 +1,663 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file matrix_readers.cpp
+ * @brief
+ *
+ * This file implements the streaming CSV and Matrix Market readers
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+#include "matrix_readers.h"
+#include "number_lexer.h"
+
+#include <vector>
+#include <cctype>
+#include <limits>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <charconv>
+#include <algorithm>
+
+using std::complex;
+using std::string;
+using std::vector;
+
+read_error::read_error(const string &path, std::size_t line, const string &msg)
+    : std::runtime_error(path + ":" + (line ? std::to_string(line) + ":" : "") + " " + msg), line_number(line)
+{
+}
+
+/**
+ * Error in a line of a piece, it becomes a read_error once the
+ * line number in the file is known
+ */
+struct line_error
+{
+    string msg;
+};
+
+/**
+ * Chunks smaller than this are parsed by one thread
+ */
+static constexpr std::size_t min_piece_size = 1 << 16;
+
+static bool is_blank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+static const char *skip_blanks(const char *p, const char *last)
+{
+    while (p < last && is_blank(*p))
+        p++;
+    return p;
+}
+
+/**
+ * Reads the next blank separated token of [p, last) into [first, end)
+ * @returns false if there is none
+ */
+static bool next_token(const char *&p, const char *last, const char *&first, const char *&end)
+{
+    first = skip_blanks(p, last);
+    end = first;
+    while (end < last && !is_blank(*end))
+        end++;
+    p = end;
+    return first != end;
+}
+
+/**
+ * Streams the file from the current position of in, line is the number
+ * of the next line. The file is read in chunks of whole lines, every chunk
+ * is split in pieces parsed in parallel: parse_line(piece, first, last, n)
+ * gets every line of a piece without its line break, n counting the lines
+ * from the beginning of the piece. Then merge(piece, line) gets the pieces
+ * in file order with the number of their first line.
+ */
+template <typename Piece, typename ParseLine, typename Merge>
+static void read_lines(std::ifstream &in, const string &path, std::size_t line, const read_options &options,
+                       ParseLine parse_line, Merge merge)
+{
+    struct piece_state
+    {
+        Piece piece;
+        const char *first = nullptr;
+        const char *last = nullptr;
+        std::size_t lines = 0;
+        bool failed = false;
+        string error;
+    };
+
+    vector<char> buffer(std::max<std::size_t>(options.chunk_size, 64));
+    std::size_t kept = 0;
+    bool done = false;
+    while (!done)
+    {
+        in.read(buffer.data() + kept, buffer.size() - kept);
+        if (in.bad())
+            throw read_error(path, 0, "cannot read the file");
+        const std::size_t size = kept + static_cast<std::size_t>(in.gcount());
+        done = in.eof();
+
+        // the chunk ends after its last line break, the rest waits for the next one
+        std::size_t end = size;
+        if (!done)
+        {
+            while (end > 0 && buffer[end - 1] != '\n')
+                end--;
+            if (end == 0)
+            {
+                // a line longer than the chunk
+                kept = size;
+                buffer.resize(buffer.size() * 2);
+                continue;
+            }
+        }
+
+        const char *chunk = buffer.data();
+        const int count = static_cast<int>(std::min<std::size_t>(
+            std::max<std::size_t>(end / min_piece_size, 1), matrix_parallel::get_num_threads()));
+        vector<piece_state> pieces(count);
+        const char *p = chunk;
+        for (int k = 0; k < count; k++)
+        {
+            pieces[k].first = p;
+            const char *target = std::max(p, chunk + end / count * (k + 1));
+            const void *nl = k + 1 < count ? std::memchr(target, '\n', chunk + end - target) : nullptr;
+            p = nl ? static_cast<const char *>(nl) + 1 : chunk + end;
+            pieces[k].last = p;
+        }
+
+        matrix_parallel::parallel_for(0, count, end, [&](int first, int last) {
+            for (int k = first; k < last; k++)
+            {
+                piece_state &state = pieces[k];
+                const char *q = state.first;
+                try
+                {
+                    while (q < state.last)
+                    {
+                        const char *eol = static_cast<const char *>(std::memchr(q, '\n', state.last - q));
+                        const char *line_last = eol ? eol : state.last;
+                        if (line_last > q && line_last[-1] == '\r')
+                            line_last--;
+                        parse_line(state.piece, q, line_last, state.lines);
+                        state.lines++;
+                        q = eol ? eol + 1 : state.last;
+                    }
+                }
+                catch (const line_error &e)
+                {
+                    state.failed = true;
+                    state.error = e.msg;
+                }
+            }
+        });
+
+        for (piece_state &state : pieces)
+        {
+            if (state.failed)
+                throw read_error(path, line + state.lines, state.error);
+            merge(state.piece, line);
+            line += state.lines;
+        }
+
+        kept = size - end;
+        std::memmove(buffer.data(), buffer.data() + end, kept);
+    }
+}
+
+static std::ifstream open_file(const string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw read_error(path, 0, "cannot open the file");
+    return in;
+}
+
+/**************************************************************************
+ ********************************  CSV  ***********************************
+ **************************************************************************/
+
+template <typename ValueType>
+struct csv_piece
+{
+    vector<ValueType> values;
+    vector<sparse_entry<ValueType>> entries;
+    int rows = 0;
+    int cols = -1;
+    std::size_t first_row = 0;
+};
+
+/**
+ * Counts the lines of in that are not blank, from its current position,
+ * then goes back to it. Reading the file twice is cheaper than holding
+ * its values twice.
+ */
+static std::size_t count_rows(std::ifstream &in, const string &path, std::size_t chunk_size)
+{
+    const std::streampos start = in.tellg();
+    vector<char> buffer(std::max<std::size_t>(chunk_size, 64));
+    std::size_t count = 0;
+    bool blank = true;
+    while (in)
+    {
+        in.read(buffer.data(), buffer.size());
+        const char *last = buffer.data() + in.gcount();
+        for (const char *p = buffer.data(); p < last; p++)
+        {
+            if (*p == '\n')
+            {
+                count += !blank;
+                blank = true;
+            }
+            else if (!is_blank(*p) && *p != '\r')
+                blank = false;
+        }
+    }
+    if (in.bad())
+        throw read_error(path, 0, "cannot read the file");
+    in.clear();
+    in.seekg(start);
+    return count + !blank;
+}
+
+/**
+ * Reads the rows of a CSV file, dense pieces keep every field in values,
+ * sparse ones the nonzero fields in entries with rows counted from the
+ * beginning of the piece. merge(piece) is called in file order. If rows
+ * is not null, it's set to the number of rows before the first merge.
+ * @returns the number of columns
+ */
+template <typename ValueType, typename Merge>
+static int read_csv_rows(const string &path, const read_options &options, bool sparse, std::size_t *rows,
+                         Merge merge)
+{
+    std::ifstream in = open_file(path);
+    std::size_t line = 1;
+    if (options.header)
+    {
+        string names;
+        std::getline(in, names);
+        line++;
+    }
+    if (rows)
+        *rows = count_rows(in, path, options.chunk_size);
+
+    const char delimiter = options.delimiter;
+    const bool blank_delimiter = is_blank(delimiter);
+    auto parse_line = [delimiter, blank_delimiter, sparse](csv_piece<ValueType> &piece, const char *first,
+                                                          const char *last, std::size_t n) {
+        const char *p = skip_blanks(first, last);
+        if (p == last)
+            return;
+        int count = 0;
+        for (;;)
+        {
+            const char *field = skip_blanks(p, last);
+            p = field;
+            while (p < last && *p != delimiter && !(blank_delimiter && is_blank(*p)))
+                p++;
+            const char *field_last = p;
+            while (field_last > field && is_blank(field_last[-1]))
+                field_last--;
+            ValueType val;
+            if (field == field_last || lex_number(field, field_last, val) != field_last)
+                throw line_error{"invalid number '" + string(field, field_last) + "' in field " +
+                                 std::to_string(count + 1)};
+            if (!sparse)
+                piece.values.push_back(val);
+            else if (val != ValueType())
+                piece.entries.push_back({piece.rows, count, val});
+            count++;
+            if (blank_delimiter)
+                p = skip_blanks(p, last);
+            if (p == last)
+                break;
+            if (!blank_delimiter)
+                p++;
+        }
+        if (piece.cols < 0)
+        {
+            piece.cols = count;
+            piece.first_row = n;
+        }
+        else if (count != piece.cols)
+            throw line_error{"row has " + std::to_string(count) + " fields, expected " + std::to_string(piece.cols)};
+        piece.rows++;
+    };
+
+    int cols = -1;
+    read_lines<csv_piece<ValueType>>(in, path, line, options, parse_line,
+                                     [&](csv_piece<ValueType> &piece, std::size_t piece_line) {
+                                         if (piece.rows == 0)
+                                             return;
+                                         if (cols < 0)
+                                             cols = piece.cols;
+                                         else if (piece.cols != cols)
+                                             throw read_error(path, piece_line + piece.first_row,
+                                                              "row has " + std::to_string(piece.cols) +
+                                                                  " fields, expected " + std::to_string(cols));
+                                         merge(piece);
+                                     });
+    return std::max(cols, 0);
+}
+
+template <typename ValueType>
+matrix<ValueType> read_csv(const string &path, const read_options &options)
+{
+    // the rows of the pieces are copied to their place, only one chunk of
+    // them is held besides the result
+    std::size_t count = 0;
+    matrix<ValueType> res;
+    int rows = 0;
+    read_csv_rows<ValueType>(path, options, false, &count, [&](csv_piece<ValueType> &piece) {
+        if (rows == 0)
+            res = matrix<ValueType>(static_cast<int>(count), piece.cols);
+        if (rows + piece.rows > res.get_rows())
+            throw read_error(path, 0, "the file changed while read");
+        for (int i = 0; i < piece.rows; i++)
+            std::copy_n(piece.values.data() + static_cast<std::size_t>(i) * piece.cols, piece.cols,
+                        res[rows + i].data());
+        rows += piece.rows;
+    });
+
+    if (rows != res.get_rows())
+        throw read_error(path, 0, "the file changed while read");
+    return res;
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType> read_csv_sparse(const string &path, const read_options &options)
+{
+    vector<sparse_entry<ValueType>> entries;
+    int rows = 0;
+    const int cols = read_csv_rows<ValueType>(path, options, true, nullptr, [&](csv_piece<ValueType> &piece) {
+        for (sparse_entry<ValueType> &e : piece.entries)
+        {
+            e.row += rows;
+            entries.push_back(e);
+        }
+        rows += piece.rows;
+    });
+    return sparse_matrix<ValueType>(rows, cols, entries);
+}
+
+/**************************************************************************
+ ****************************  Matrix Market  *****************************
+ **************************************************************************/
+
+enum class mm_field
+{
+    real,
+    complex,
+    pattern
+};
+
+enum class mm_symmetry
+{
+    general,
+    symmetric,
+    skew,
+    hermitian
+};
+
+struct mm_header
+{
+    bool coordinate;
+    mm_field field;
+    mm_symmetry symmetry;
+    int rows;
+    int cols;
+    std::size_t entries;
+};
+
+template <typename ValueType>
+struct mm_scalar
+{
+    static constexpr bool is_complex = false;
+    static ValueType make(ValueType re, ValueType) { return re; }
+    static ValueType conj(ValueType val) { return val; }
+};
+
+template <typename ValueType>
+struct mm_scalar<complex<ValueType>>
+{
+    static constexpr bool is_complex = true;
+    static complex<ValueType> make(ValueType re, ValueType im) { return complex<ValueType>(re, im); }
+    static complex<ValueType> conj(complex<ValueType> val) { return std::conj(val); }
+};
+
+static string lower(string s)
+{
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+    return s;
+}
+
+/**
+ * Reads the banner, the comments and the size line
+ * @param line set to the number of the size line
+ */
+template <typename ValueType>
+static mm_header read_mm_header(std::ifstream &in, const string &path, std::size_t &line)
+{
+    string text;
+    line = 1;
+    if (!std::getline(in, text))
+        throw read_error(path, 1, "empty file");
+    std::istringstream banner(text);
+    string tag, object, format, field, symmetry;
+    banner >> tag >> object >> format >> field >> symmetry;
+    if (lower(tag) != "%%matrixmarket")
+        throw read_error(path, 1, "not a Matrix Market file");
+    if (lower(object) != "matrix")
+        throw read_error(path, 1, "unsupported object '" + object + "'");
+
+    mm_header header;
+    format = lower(format);
+    if (format != "coordinate" && format != "array")
+        throw read_error(path, 1, "unsupported format '" + format + "'");
+    header.coordinate = format == "coordinate";
+
+    field = lower(field);
+    if (field == "real" || field == "double" || field == "integer")
+        header.field = mm_field::real;
+    else if (field == "complex")
+        header.field = mm_field::complex;
+    else if (field == "pattern" && header.coordinate)
+        header.field = mm_field::pattern;
+    else
+        throw read_error(path, 1, "unsupported field '" + field + "'");
+    if (header.field == mm_field::complex && !mm_scalar<ValueType>::is_complex)
+        throw read_error(path, 1, "complex file read into a real matrix");
+
+    symmetry = lower(symmetry);
+    if (symmetry == "general")
+        header.symmetry = mm_symmetry::general;
+    else if (symmetry == "symmetric")
+        header.symmetry = mm_symmetry::symmetric;
+    else if (symmetry == "skew-symmetric")
+        header.symmetry = mm_symmetry::skew;
+    else if (symmetry == "hermitian")
+        header.symmetry = mm_symmetry::hermitian;
+    else
+        throw read_error(path, 1, "unsupported symmetry '" + symmetry + "'");
+
+    // comments up to the size line
+    while (std::getline(in, text))
+    {
+        line++;
+        const std::size_t first = text.find_first_not_of(" \t\r");
+        if (first != string::npos && text[first] != '%')
+            break;
+        text.clear();
+    }
+    std::istringstream sizes(text);
+    long long rows = -1, cols = -1, entries = 0;
+    sizes >> rows >> cols;
+    if (header.coordinate)
+        sizes >> entries;
+    if (!sizes || rows < 0 || cols < 0 || entries < 0 || rows > std::numeric_limits<int>::max() ||
+        cols > std::numeric_limits<int>::max())
+        throw read_error(path, line, "invalid size line");
+    if (header.symmetry != mm_symmetry::general && rows != cols)
+        throw read_error(path, line, "a symmetric matrix must be square");
+    header.rows = static_cast<int>(rows);
+    header.cols = static_cast<int>(cols);
+    header.entries = static_cast<std::size_t>(entries);
+    return header;
+}
+
+/**
+ * Reads the value at p, one or two numbers depending on the field
+ */
+template <typename ValueType>
+static ValueType read_mm_value(const char *&p, const char *last, mm_field field)
+{
+    using real_type = decltype(std::real(ValueType()));
+    if (field == mm_field::pattern)
+        return ValueType(1);
+    real_type re = 0, im = 0;
+    const char *first, *end;
+    if (!next_token(p, last, first, end) || lex_real(first, end, re) != end)
+        throw line_error{"invalid value '" + string(first, end) + "'"};
+    if (field == mm_field::complex && (!next_token(p, last, first, end) || lex_real(first, end, im) != end))
+        throw line_error{"invalid imaginary part '" + string(first, end) + "'"};
+    return mm_scalar<ValueType>::make(re, im);
+}
+
+/**
+ * @returns the element mirrored by a symmetric storage
+ */
+template <typename ValueType>
+static ValueType mirror(ValueType val, mm_symmetry symmetry)
+{
+    if (symmetry == mm_symmetry::skew)
+        return -val;
+    if (symmetry == mm_symmetry::hermitian)
+        return mm_scalar<ValueType>::conj(val);
+    return val;
+}
+
+static bool is_mm_blank_line(const char *first, const char *last)
+{
+    first = skip_blanks(first, last);
+    return first == last || *first == '%';
+}
+
+template <typename ValueType>
+struct mm_piece
+{
+    vector<sparse_entry<ValueType>> entries;
+    vector<ValueType> values;
+    std::size_t count = 0;
+};
+
+/**
+ * Reads the entries of a coordinate file, symmetric entries are expanded,
+ * merge(entries) gets them piece by piece in file order
+ */
+template <typename ValueType, typename Merge>
+static void read_mm_coordinates(std::ifstream &in, const string &path, std::size_t line, const mm_header &header,
+                                const read_options &options, Merge merge)
+{
+    auto parse_line = [&header](mm_piece<ValueType> &piece, const char *first, const char *last, std::size_t) {
+        if (is_mm_blank_line(first, last))
+            return;
+        int index[2];
+        const int limit[2] = {header.rows, header.cols};
+        const char *p = first;
+        for (int k = 0; k < 2; k++)
+        {
+            const char *token, *end;
+            if (!next_token(p, last, token, end) || std::from_chars(token, end, index[k]).ptr != end)
+                throw line_error{"invalid index '" + string(token, end) + "'"};
+            if (index[k] < 1 || index[k] > limit[k])
+                throw line_error{"index " + std::to_string(index[k]) + " out of range"};
+        }
+        const ValueType val = read_mm_value<ValueType>(p, last, header.field);
+        const char *token, *end;
+        if (next_token(p, last, token, end))
+            throw line_error{"unexpected '" + string(token, end) + "'"};
+        piece.entries.push_back({index[0] - 1, index[1] - 1, val});
+        if (header.symmetry != mm_symmetry::general && index[0] != index[1])
+            piece.entries.push_back({index[1] - 1, index[0] - 1, mirror(val, header.symmetry)});
+        piece.count++;
+    };
+
+    std::size_t count = 0;
+    read_lines<mm_piece<ValueType>>(in, path, line, options, parse_line,
+                                    [&](mm_piece<ValueType> &piece, std::size_t) {
+                                        count += piece.count;
+                                        if (count > header.entries)
+                                            throw read_error(path, 0, "more entries than the size line says");
+                                        merge(piece.entries);
+                                    });
+    if (count != header.entries)
+        throw read_error(path, 0, "fewer entries than the size line says");
+}
+
+/**
+ * Reads the column-major values of an array file into a matrix,
+ * symmetric files list the lower triangle only
+ */
+template <typename ValueType>
+static matrix<ValueType> read_mm_array(std::ifstream &in, const string &path, std::size_t line,
+                                       const mm_header &header, const read_options &options)
+{
+    auto parse_line = [&header](mm_piece<ValueType> &piece, const char *first, const char *last, std::size_t) {
+        if (is_mm_blank_line(first, last))
+            return;
+        const char *p = first;
+        piece.values.push_back(read_mm_value<ValueType>(p, last, header.field));
+        const char *token, *end;
+        if (next_token(p, last, token, end))
+            throw line_error{"unexpected '" + string(token, end) + "'"};
+    };
+
+    matrix<ValueType> res(header.rows, header.cols);
+    const bool general = header.symmetry == mm_symmetry::general;
+    const int skip = header.symmetry == mm_symmetry::skew ? 1 : 0;
+    const std::size_t n = header.rows;
+    const std::size_t expected = general ? n * header.cols : skip ? n * (n - 1) / 2 : n * (n + 1) / 2;
+    // next element (i, j), symmetric columns start at the diagonal
+    std::size_t count = 0;
+    int i = general ? 0 : skip, j = 0;
+    read_lines<mm_piece<ValueType>>(in, path, line, options, parse_line,
+                                    [&](mm_piece<ValueType> &piece, std::size_t) {
+                                        count += piece.values.size();
+                                        if (count > expected)
+                                            throw read_error(path, 0, "more entries than the size line says");
+                                        for (const ValueType &val : piece.values)
+                                        {
+                                            res[i][j] = val;
+                                            if (!general && i != j)
+                                                res[j][i] = mirror(val, header.symmetry);
+                                            if (++i == header.rows)
+                                            {
+                                                j++;
+                                                i = general ? 0 : j + skip;
+                                            }
+                                        }
+                                    });
+    if (count != expected)
+        throw read_error(path, 0, "fewer entries than the size line says");
+    return res;
+}
+
+template <typename ValueType>
+matrix<ValueType> read_matrix_market(const string &path, const read_options &options)
+{
+    std::ifstream in = open_file(path);
+    std::size_t line;
+    const mm_header header = read_mm_header<ValueType>(in, path, line);
+    if (!header.coordinate)
+        return read_mm_array<ValueType>(in, path, line + 1, header, options);
+
+    matrix<ValueType> res(header.rows, header.cols);
+    read_mm_coordinates<ValueType>(in, path, line + 1, header, options,
+                                   [&res](const vector<sparse_entry<ValueType>> &entries) {
+                                       for (const sparse_entry<ValueType> &e : entries)
+                                           res[e.row][e.col] += e.value;
+                                   });
+    return res;
+}
+
+template <typename ValueType>
+sparse_matrix<ValueType> read_matrix_market_sparse(const string &path, const read_options &options)
+{
+    std::ifstream in = open_file(path);
+    std::size_t line;
+    const mm_header header = read_mm_header<ValueType>(in, path, line);
+    if (!header.coordinate)
+        return sparse_matrix<ValueType>(read_mm_array<ValueType>(in, path, line + 1, header, options));
+
+    vector<sparse_entry<ValueType>> all;
+    all.reserve(header.symmetry == mm_symmetry::general ? header.entries : 2 * header.entries);
+    read_mm_coordinates<ValueType>(in, path, line + 1, header, options,
+                                   [&all](const vector<sparse_entry<ValueType>> &entries) {
+                                       all.insert(all.end(), entries.begin(), entries.end());
+                                   });
+    return sparse_matrix<ValueType>(header.rows, header.cols, all);
+}
+
+#define INSTANTIATE_READERS(ValueType)                                                          \
+    template matrix<ValueType> read_csv<ValueType>(const string &, const read_options &);       \
+    template sparse_matrix<ValueType> read_csv_sparse<ValueType>(const string &, const read_options &); \
+    template matrix<ValueType> read_matrix_market<ValueType>(const string &, const read_options &); \
+    template sparse_matrix<ValueType> read_matrix_market_sparse<ValueType>(const string &, const read_options &);
+
+INSTANTIATE_READERS(float)
+INSTANTIATE_READERS(double)
+INSTANTIATE_READERS(complex<float>)
+INSTANTIATE_READERS(complex<double>)
@@ -7,71 +7,184 @@
  *****************************************************************************/
 /**
  * @file parsing.cpp
- * @brief 
- * 
+ * @brief
+ *
  * This file implements helper funtions to parse matrices in C++
  *
  * @author Hassan El-shazly
- * @date Last Edit Jul-2020
+ * @date Last Edit Oct-2026
  *
  */
 #include "parsing.h"
+#include "number_lexer.h"
 
-vector<string> strip(const vector<string>& input)
-{   
-    vector<string> v = input;
-    for(string& s : v) 
-    {
-        while(s[0] == ' ') 
-            s.erase(0, 1) ;
-        while(s[s.length()-1] == ' ') 
-            s.erase(s.length()-1, 1);
-    }
-    return v; 
+#include <algorithm>
+
+parse_error::parse_error(std::size_t column, const string &msg)
+    : std::runtime_error("parse error at column " + std::to_string(column) + ": " + msg), col(column)
+{
 }
 
-string strip(const string& input)
-{   
-    string s = input;
-    while(s[0] == ' ') 
-        s.erase(0, 1) ;
-    while(s[s.length()-1] == ' ') 
-        s.erase(s.length()-1, 1);
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
 
-    return s; 
+/**
+ * true for the characters that end an element
+ */
+static bool is_delimiter(char c)
+{
+    return is_space(c) || c == ';' || c == '[' || c == ']';
 }
 
-vector<string> split(const string& s, char b)
+/**
+ * converts the element [first, last) to a real number,
+ * the whole element must be read by the lexer
+ */
+template <typename ValueType>
+static void convert(const char *first, const char *last, const char *origin, ValueType &val)
 {
-    vector<string> v ;
-    int j = 0 ;
-    int n = s.length() ;
-    string m ;
-    for(int i = 0 ; i < n ; i++)
+    if (lex_real(first, last, val) != last)
+        throw parse_error(first - origin + 1, "invalid number '" + string(first, last) + "'");
+}
+
+/**
+ * converts the element [first, last) to a complex number
+ */
+template <typename ValueType>
+static void convert(const char *first, const char *last, const char *origin, complex<ValueType> &val)
+{
+    if (lex_complex(first, last, val) != last)
+        throw parse_error(first - origin + 1, "invalid number '" + string(first, last) + "'");
+}
+
+/**
+ * One pass over the input, every element is converted as soon as its
+ * end is found. The elements are gathered in a buffer reused
+ * by the next calls of the thread and copied into the matrix at the end.
+ */
+template <typename ValueType>
+matrix<ValueType> parse_input(std::string_view input)
+{
+    thread_local vector<ValueType> elements;
+    elements.clear();
+
+    const char *origin = input.data();
+    const char *p = origin;
+    const char *end = origin + input.size();
+    while (p < end && is_space(*p))
+        p++;
+    while (end > p && is_space(end[-1]))
+        end--;
+    if (p == end)
+        return matrix<ValueType>();
+    if (*p != '[')
+        throw parse_error(p - origin + 1, "expected '['");
+    if (end - p < 2 || end[-1] != ']')
+        throw parse_error(end - origin + 1, "expected ']'");
+    const char *close = end - 1;
+    p++;
+
+    int rows = 0;
+    int cols = 0;
+    while (p < close)
     {
-        if (s[i] == b)
+        const char *row_first = nullptr;
+        int count = 0;
+        while (p < close && *p != ';')
         {
-            m = s.substr(j,i-j) ;
-            if(m != "") v.push_back(m);
-            j = i+1 ;
+            if (is_space(*p))
+            {
+                p++;
+                continue;
+            }
+            if (*p == '[' || *p == ']')
+                throw parse_error(p - origin + 1, string("unexpected '") + *p + "'");
+            const char *first = p;
+            while (p < close && !is_delimiter(*p))
+                p++;
+            elements.emplace_back();
+            convert(first, p, origin, elements.back());
+            if (!row_first)
+                row_first = first;
+            count++;
         }
+        // empty rows are skipped
+        if (count > 0)
+        {
+            if (rows == 0)
+                cols = count;
+            else if (count != cols)
+                throw parse_error(row_first - origin + 1, "row " + std::to_string(rows + 1) + " has " +
+                                                              std::to_string(count) + " elements, expected " +
+                                                              std::to_string(cols));
+            rows++;
+        }
+        if (p < close)
+            p++;
     }
-    v.push_back(s.substr(j,n-j));
-    return v ;
+
+    if (rows == 0)
+        return matrix<ValueType>();
+    matrix<ValueType> res(rows, cols);
+    for (int i = 0; i < rows; i++)
+        std::copy_n(elements.data() + static_cast<std::size_t>(i) * cols, cols, res[i].data());
+    return res;
 }
 
-string clear_spaces(const string& s)
+template matrix<float> parse_input<float>(std::string_view);
+template matrix<double> parse_input<double>(std::string_view);
+template matrix<complex<float>> parse_input<complex<float>>(std::string_view);
+template matrix<complex<double>> parse_input<complex<double>>(std::string_view);
+
+matrix<float> parse_float_input(std::string_view input)
+{
+    return parse_input<float>(input);
+}
+
+matrix<complex<float>> parse_complex_input(std::string_view input)
 {
-    string input = s;
-    string::iterator new_end = unique(input.begin(), input.end(), [] (const char &x, const char &y) {
-       return x == y and x == ' ';
-    });
-    input.erase(new_end, input.end());
-    return input;
+    return parse_input<complex<float>>(input);
 }
 
 ostream& operator<<(ostream& os, complex<float> c)
 {
+    // the text is built in a buffer and written at once
+    const int precision = static_cast<int>(os.precision());
+    if (matrix_format::has_default_format(os) && precision <= 32)
+    {
+        char buf[96];
+        char *p = buf;
+        char *const last = buf + sizeof(buf);
+        const float re = real(c);
+        const float im = imag(c);
+        if (re != 0)
+            p = matrix_format::to_text(p, last, re, precision);
+        if (im == 1 && re == 0)
+            *p++ = 'i';
+        else if (im == 1 && re != 0)
+        {
+            *p++ = '+';
+            *p++ = 'i';
+        }
+        else if (im == -1)
+        {
+            *p++ = '-';
+            *p++ = 'i';
+        }
+        else if (im > 0 || im < 0)
+        {
+            if (im > 0 && re != 0)
+                *p++ = '+';
+            p = matrix_format::to_text(p, last, im, precision);
+            *p++ = 'i';
+        }
+        if (re == 0 && im == 0)
+            *p++ = '0';
+        return os.write(buf, p - buf);
+    }
+
     if(real(c) != 0) os << real(c) ;
     if(imag(c) == 1 && real(c) == 0) os << "i" ;
     else if(imag(c) == 1 && real(c) != 0) os << "+i" ;
@@ -86,67 +199,3 @@ ostream& operator<<(ostream& os, complex<float> c)
     if(real(c) == 0 && imag(c) == 0) os << "0" ;
     return os;
 }
-
-vector<float> to_float(const vector<string>& input)
-{
-    vector<float> vec;
-    for(const auto& s: input)
-        vec.push_back(atof(s.c_str()));
-    return vec;
-}
-
-vector<complex<float>> to_complex(const vector<string>& input)
-{
-    vector<complex<float>> vec;
-    for(string s: input)
-        if(s.find("i") != string::npos)
-            if(s.find("+") != string::npos || s.find("-",1) != string::npos)
-            {
-                float r = atof(s.c_str()) ;
-                ostringstream os ; os << r ;
-                s.replace(0, os.str().length() ,"");
-                float i = atof(s.c_str()) ;
-                if(i == 0 && s.find("+") != string::npos) i = 1 ;
-                if(i == 0 && s.find("-") != string::npos) i = -1 ;
-                vec.push_back(complex<float>(r, i));
-            }
-            else
-            {
-                float i = atof(s.c_str()) ;
-                if(i == 0 && s.length() == 1) i = 1 ;
-                if(i == 0 && s.length() == 2) i = -1 ;
-                vec.push_back(complex<float>(0, i));
-            }
-        else
-            vec.push_back(complex<float>(atof(s.c_str()), 0));
-    return vec;
-}
-
-
-vector<vector<float>> parse_float_input(string& input)
-{   
-    vector<vector<float>> vec;
-    if(input.size() < 2)
-        return vec;
-    input.erase(input.begin()) ; 
-    input.erase(input.end()-1) ;
-    input = clear_spaces(input); 
-    vector<string> rows = split(input, ';');
-    for(const auto& row : rows)
-        vec.push_back(to_float(split(strip(row), ' ')));
-    return vec;
-}
-
-vector<vector<complex<float>>> parse_complex_input(string& input)
-{
-    vector<vector<complex<float>>> vec;
-    if(input.size() < 2)
-        return vec;
-    input.erase(input.begin()) ; 
-    input.erase(input.end()-1) ;
-    input = clear_spaces(input); 
-    vector<string> rows = split(input, ';');
-    for(const auto& row : rows)
-        vec.push_back(to_complex(split(strip(row), ' ')));
-    return vec;
-}
\ No newline at end of file
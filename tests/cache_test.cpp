@@ -0,0 +1,293 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file cache_test.cpp
+ * @brief
+ *
+ * This file checks the result cache of matrix_cache.h. The cache is set up
+ * by the environment, as in the calculator, and tests/check.sh runs:
+ *
+ *     MATRIX_CACHE_BYTES=N cache_test.out memory
+ *         hits, results equal to the computed ones, eviction when the
+ *         capacity shrinks, arena results and small matrices never
+ *         cached, and threads sharing the cache
+ *
+ *     MATRIX_CACHE_DIR=D cache_test.out spill-write
+ *     MATRIX_CACHE_DIR=D cache_test.out spill-read
+ *         results written to D by a process and read back by the next one
+ *
+ * The exit status is 1 if a check fails.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <complex>
+#include <cstdio>
+#include <cstring>
+
+#include "matrix.h"
+
+using std::complex;
+using std::string;
+using std::vector;
+
+static int failures = 0;
+
+static void check(bool cond, const string &what)
+{
+    if (!cond)
+    {
+        std::printf("FAIL: %s\n", what.c_str());
+        failures++;
+    }
+}
+
+/**
+ * n x n matrix of a fixed seed, diagonally dominant, it can be inverted
+ */
+template <typename ValueType, typename Allocator = aligned_allocator<ValueType>>
+static matrix<ValueType, Allocator> random_matrix(int n, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    matrix<ValueType, Allocator> mat(n, n);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+            mat[i][j] = static_cast<ValueType>(dist(gen));
+        mat[i][i] += static_cast<ValueType>(n);
+    }
+    return mat;
+}
+
+template <typename ValueType, typename Allocator>
+static bool same(const matrix<ValueType, Allocator> &a, const matrix<ValueType, Allocator> &b)
+{
+    if (a.get_rows() != b.get_rows() || a.get_cols() != b.get_cols())
+        return false;
+    for (int i = 0; i < a.get_rows(); i++)
+        if (std::memcmp(&a[i][0], &b[i][0], a.get_cols() * sizeof(ValueType)) != 0)
+            return false;
+    return true;
+}
+
+/**
+ * @returns inverse computed with the cache off
+ */
+template <typename ValueType>
+static matrix<ValueType> uncached_invert(matrix<ValueType> mat)
+{
+    return lu_factorization<ValueType, aligned_allocator<ValueType>>(mat).inverse();
+}
+
+static void test_hits()
+{
+    matrix_cache::clear();
+    matrix_cache::reset_stats();
+    matrix<double> a = random_matrix<double>(32, 1);
+    const matrix<double> inv = a.invert();
+    const double det = a.det();
+    const matrix<double> pow = a.power(3);
+    matrix_cache::cache_stats s = matrix_cache::get_stats();
+    check(s.misses == 3 && s.hits == 0, "memory: first calls are computed");
+    check(s.entries == 3, "memory: three results kept");
+
+    // a copy with the same elements shares the results
+    matrix<double> b = a;
+    check(same(b.invert(), inv), "memory: cached inverse equal");
+    check(b.det() == det, "memory: cached det equal");
+    check(same(b.power(3), pow), "memory: cached power equal");
+    check(same(inv, uncached_invert(a)), "memory: inverse equal to the computed one");
+    s = matrix_cache::get_stats();
+    check(s.hits == 3 && s.misses == 3, "memory: second calls are hits");
+
+    // another power is another result
+    b.power(4);
+    check(matrix_cache::get_stats().misses == 4, "memory: the power is part of the key");
+
+    // one element changed, a new result
+    b[5][7] += 1;
+    check(!same(b.invert(), inv), "memory: changed matrix not answered from the cache");
+    check(matrix_cache::get_stats().misses == 5, "memory: changed matrix computed");
+}
+
+static void test_eviction()
+{
+    matrix_cache::clear();
+    matrix_cache::reset_stats();
+    const std::size_t capacity = matrix_cache::capacity();
+    vector<matrix<double>> mats;
+    for (unsigned i = 0; i < 8; i++)
+    {
+        mats.push_back(random_matrix<double>(64, 100 + i));
+        mats.back().invert();
+    }
+    matrix_cache::cache_stats s = matrix_cache::get_stats();
+    check(s.entries == 8 && s.evictions == 0, "eviction: eight inverses fit");
+
+    // room for two 64x64 inverses, the six least recently used go
+    const std::size_t one = s.bytes / 8;
+    matrix_cache::set_capacity(2 * one);
+    s = matrix_cache::get_stats();
+    check(s.entries == 2 && s.evictions == 6, "eviction: shrinking evicts");
+    check(s.bytes <= 2 * one, "eviction: bytes within the capacity");
+
+    // the most recent two are kept, the first one is computed again
+    matrix_cache::reset_stats();
+    check(same(mats[7].invert(), uncached_invert(mats[7])), "eviction: kept result equal");
+    check(matrix_cache::get_stats().hits == 1, "eviction: most recent result kept");
+    check(same(mats[0].invert(), uncached_invert(mats[0])), "eviction: evicted result computed again");
+    s = matrix_cache::get_stats();
+    check(s.misses == 1 && s.evictions == 1, "eviction: evicted result computed, the oldest evicted");
+
+    // a result larger than the capacity is not kept
+    matrix_cache::set_capacity(one / 2);
+    check(matrix_cache::get_stats().entries == 0, "eviction: nothing fits");
+    mats[1].invert();
+    check(matrix_cache::get_stats().entries == 0, "eviction: too large result not kept");
+    matrix_cache::set_capacity(capacity);
+}
+
+static void test_bypass()
+{
+    matrix_cache::clear();
+    matrix_cache::reset_stats();
+    matrix_arena arena;
+    {
+        scoped_arena scope(arena);
+        matrix<double, arena_allocator<double>> a = random_matrix<double, arena_allocator<double>>(32, 3);
+        a.invert();
+        a.invert();
+        a.power(2);
+        a.lu();
+    }
+    matrix_cache::cache_stats s = matrix_cache::get_stats();
+    check(s.entries == 0 && s.hits == 0 && s.misses == 0, "bypass: arena results never cached");
+
+    matrix<double> small = random_matrix<double>(matrix_cache::min_size - 1, 4);
+    small.invert();
+    small.invert();
+    s = matrix_cache::get_stats();
+    check(s.entries == 0 && s.hits == 0 && s.misses == 0, "bypass: small matrices never cached");
+
+    // no matrix file type for long double
+    matrix<long double> wide = random_matrix<long double>(32, 5);
+    wide.invert();
+    wide.det();
+    check(matrix_cache::get_stats().misses == 0, "bypass: long double results never cached");
+}
+
+static void test_threads()
+{
+    matrix_cache::clear();
+    matrix_cache::reset_stats();
+    vector<matrix<float>> mats;
+    vector<matrix<float>> expected;
+    for (unsigned i = 0; i < 6; i++)
+    {
+        mats.push_back(random_matrix<float>(24, 200 + i));
+        expected.push_back(uncached_invert(mats.back()));
+    }
+    vector<int> wrong(8, 0);
+    vector<std::thread> threads;
+    for (int t = 0; t < 8; t++)
+        threads.emplace_back([&, t] {
+            for (int k = 0; k < 60; k++)
+            {
+                const int i = (t + k) % mats.size();
+                matrix<float> a = mats[i];
+                if (!same(a.invert(), expected[i]))
+                    wrong[t]++;
+                if (k % 7 == 0)
+                    matrix_cache::set_capacity(k % 2 ? 1 << 20 : 1 << 12);
+            }
+        });
+    for (auto &thread : threads)
+        thread.join();
+    int total = 0;
+    for (int w : wrong)
+        total += w;
+    check(total == 0, "threads: results equal to the computed ones");
+    const matrix_cache::cache_stats s = matrix_cache::get_stats();
+    check(s.hits + s.misses == 8 * 60, "threads: every call counted");
+}
+
+/**
+ * The results written by spill-write and read back by spill-read
+ */
+static void spill_results(vector<matrix<complex<float>>> &inverses, vector<complex<float>> &dets,
+                          vector<matrix<complex<float>>> &powers)
+{
+    for (unsigned i = 0; i < 4; i++)
+    {
+        matrix<complex<float>> a = random_matrix<complex<float>>(20 + i, 300 + i);
+        inverses.push_back(a.invert());
+        dets.push_back(a.det());
+        powers.push_back(a.power(-2));
+    }
+}
+
+static void test_spill(bool write)
+{
+    check(!matrix_cache::spill_dir().empty(), "spill: MATRIX_CACHE_DIR set");
+    check(matrix_cache::capacity() == 0, "spill: nothing kept in memory");
+    vector<matrix<complex<float>>> inverses, powers;
+    vector<complex<float>> dets;
+    spill_results(inverses, dets, powers);
+    matrix_cache::cache_stats s = matrix_cache::get_stats();
+    if (write)
+    {
+        // power(-2) computes the inverse, found in the directory
+        check(s.misses == 12 && s.disk_hits == 4, "spill-write: results computed and written");
+        return;
+    }
+    check(s.misses == 0 && s.disk_hits == 12, "spill-read: results read from the directory");
+
+    // computed again with the cache off, bit for bit the same
+    matrix_cache::set_spill_dir("");
+    vector<matrix<complex<float>>> inverses2, powers2;
+    vector<complex<float>> dets2;
+    spill_results(inverses2, dets2, powers2);
+    check(matrix_cache::get_stats().disk_hits == 12, "spill-read: cache off");
+    for (std::size_t i = 0; i < inverses.size(); i++)
+    {
+        check(same(inverses[i], inverses2[i]), "spill-read: inverse equal");
+        check(dets[i] == dets2[i], "spill-read: det equal");
+        check(same(powers[i], powers2[i]), "spill-read: power equal");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const string mode = argc > 1 ? argv[1] : "";
+    if (mode == "memory")
+    {
+        check(matrix_cache::capacity() >= (1 << 20), "memory: MATRIX_CACHE_BYTES of 1 MB at least");
+        check(matrix_cache::spill_dir().empty(), "memory: no MATRIX_CACHE_DIR");
+        test_hits();
+        test_eviction();
+        test_bypass();
+        test_threads();
+    }
+    else if (mode == "spill-write" || mode == "spill-read")
+        test_spill(mode == "spill-write");
+    else
+    {
+        std::printf("use: cache_test.out memory|spill-write|spill-read\n");
+        return 2;
+    }
+    if (failures)
+        return 1;
+    std::printf("cache_test %s: passed\n", mode.c_str());
+    return 0;
+}
@@ -0,0 +1,84 @@
+#!/bin/sh
+#------------------------------------------------------------------------------
+# Checks the calculator on the inputs of tests/
+#
+# Use: tests/check.sh [calculator, ./main.out by default]
+#
+#      testN.txt with a testN.out: the output of the serial and the batch
+#                                  (-j) modes must be testN.out
+#      gen_blocks.py inputs      : -j must write what the serial mode writes,
+#                                  as text and with -b, for every way the
+#                                  input can end
+#      -b with a stopping block  : the standard output must hold the records
+#                                  of the blocks before it only, the message
+#                                  goes to the standard error
+#      stopping blocks           : with the input still open, both modes must
+#                                  stop at the block, as they do at its end
+#      cache_test.out            : the result cache, in memory and spilled by
+#                                  a process then read by another one
+#
+#------------------------------------------------------------------------------
+CALC=${1:-./main.out}
+TESTS=$(dirname "$0")
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+FAILED=0
+
+fail()
+{
+    echo "FAIL: $*"
+    FAILED=1
+}
+
+for input in "$TESTS"/test*.txt; do
+    expected=${input%.txt}.out
+    [ -f "$expected" ] || continue
+    for mode in "" -j; do
+        "$CALC" $mode "$input" > "$TMP/out"
+        cmp -s "$TMP/out" "$expected" || fail "$input $mode"
+    done
+done
+
+for end in valid eof error invalid singular; do
+    python3 "$TESTS/gen_blocks.py" -n 3000 -s 7 -e $end > "$TMP/in"
+    for binary in "" -b; do
+        "$CALC" $binary "$TMP/in" > "$TMP/serial"
+        "$CALC" $binary -j "$TMP/in" > "$TMP/batch"
+        cmp -s "$TMP/serial" "$TMP/batch" || fail "gen_blocks.py -e $end $binary -j"
+    done
+done
+
+python3 "$TESTS/gen_blocks.py" -n 500 -s 11 -e eof > "$TMP/in"
+"$CALC" -b "$TMP/in" > "$TMP/expected"
+for end in error invalid singular; do
+    python3 "$TESTS/gen_blocks.py" -n 500 -s 11 -e $end > "$TMP/in"
+    for mode in "" -j; do
+        "$CALC" -b $mode "$TMP/in" > "$TMP/out" 2> "$TMP/err"
+        cmp -s "$TMP/out" "$TMP/expected" || fail "-b $mode, $end, records"
+        [ -s "$TMP/err" ] || fail "-b $mode, $end, no message"
+    done
+done
+
+# the input stays open 6 s after the stopping block, 3 s are allowed
+for end in error invalid singular; do
+    python3 "$TESTS/gen_blocks.py" -n 100 -s 7 -e $end -t 0 | sed '/^end$/d' > "$TMP/in"
+    "$CALC" "$TMP/in" > "$TMP/expected"
+    for mode in "" -j; do
+        (cat "$TMP/in"; sleep 6) | timeout 3 "$CALC" $mode > "$TMP/out"
+        status=$?
+        [ $status -eq 0 ] || fail "open input, $end $mode, exit status $status"
+        cmp -s "$TMP/out" "$TMP/expected" || fail "open input, $end $mode"
+    done
+done
+
+if [ -x "$TESTS/cache_test.out" ]; then
+    MATRIX_CACHE_BYTES=4000000 "$TESTS/cache_test.out" memory || fail "cache_test.out memory"
+    mkdir "$TMP/spill"
+    MATRIX_CACHE_DIR="$TMP/spill" "$TESTS/cache_test.out" spill-write || fail "cache_test.out spill-write"
+    MATRIX_CACHE_DIR="$TMP/spill" "$TESTS/cache_test.out" spill-read || fail "cache_test.out spill-read"
+else
+    fail "$TESTS/cache_test.out not built"
+fi
+
+[ $FAILED -eq 0 ] && echo "all passed"
+exit $FAILED
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+#
+# Generates a calculator input of random blocks, the same for a given seed,
+# to compare the outputs of the serial and the batch (-j) modes.
+#
+# Use: gen_blocks.py [-n BLOCKS] [-s SEED] [-e END] [-t TAIL] > input.txt
+#
+# END is how the input ends:
+#      valid   : an "end" line
+#      eof     : no "end" line
+#      error   : a block failing with ERROR, then blocks never evaluated
+#      invalid : a block with an invalid operator, then blocks never evaluated
+#      singular: the inverse of a singular matrix, then blocks never evaluated
+#
+# TAIL is the number of blocks never evaluated, 50 by default
+#
+import argparse
+import random
+
+
+def value(rng):
+    re = rng.randint(-9, 9)
+    im = rng.randint(-9, 9)
+    if im == 0:
+        return str(re)
+    return "%d%+di" % (re, im)
+
+
+def literal(rng, rows, cols):
+    # diagonally dominant, square ones can be inverted
+    lines = []
+    for i in range(rows):
+        row = []
+        for j in range(cols):
+            row.append("40" if i == j else value(rng))
+        lines.append(" ".join(row))
+    return "[" + "; ".join(lines) + "]"
+
+
+def block(rng, variables):
+    n = rng.randint(1, 6)
+    kind = rng.randrange(11)
+    if kind == 0:
+        return ["%s\n+\n%s" % (literal(rng, n, n + 1), literal(rng, n, n + 1))]
+    if kind == 1:
+        return ["%s\n-\n%s" % (literal(rng, n, n), literal(rng, n, n))]
+    if kind == 2:
+        return ["%s\n*\n%s" % (literal(rng, n, n + 1), literal(rng, n + 1, 2))]
+    if kind == 3:
+        return ["%s\n/\n%s" % (literal(rng, n, n), literal(rng, n, n))]
+    if kind == 4:
+        return ["%s\n^\n%d" % (literal(rng, n, n), rng.randint(-2, 4))]
+    if kind == 5:
+        return ["%s\n%s" % (literal(rng, n, n), rng.choice("TDI"))]
+    # statements, a variable keeps the size of its first assignment
+    name = rng.choice("ABCD")
+    if kind <= 7 or not variables:
+        size = variables.setdefault(name, rng.randint(1, 5))
+        return ["%s = %s" % (name, literal(rng, size, size))]
+    a = rng.choice(sorted(variables))
+    size = variables[a]
+    b = rng.choice([v for v in sorted(variables) if variables[v] == size])
+    if variables.get(name, size) != size:
+        name = a
+    statement = rng.choice(["%s + %s'" % (a, b),
+                            "inv(%s) * %s" % (a, b),
+                            "%s ^ 2 - -%s" % (a, b),
+                            "trans(%s) / %s" % (a, b),
+                            "det(%s)" % a,
+                            "%s = %s * %s + %s" % (name, a, b, a)])
+    if statement.startswith(name + " ="):
+        variables[name] = size
+    return [statement]
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-n", type=int, default=2000)
+    parser.add_argument("-s", type=int, default=1)
+    parser.add_argument("-e", default="valid",
+                        choices=["valid", "eof", "error", "invalid", "singular"])
+    parser.add_argument("-t", type=int, default=50)
+    args = parser.parse_args()
+
+    rng = random.Random(args.s)
+    variables = {}
+    lines = ["start"]
+    for _ in range(args.n):
+        lines += block(rng, variables)
+        lines.append("")
+    if args.e == "error":
+        lines += ["[1 2]\n+\n[1 2 3]", ""]
+    elif args.e == "invalid":
+        lines += ["[1 2; 3 4]\nQ", ""]
+    elif args.e == "singular":
+        lines += ["[1 2; 2 4]\nI", ""]
+    if args.e != "valid" and args.e != "eof":
+        for _ in range(args.t):
+            lines += block(rng, variables)
+            lines.append("")
+    if args.e != "eof":
+        lines.append("end")
+    print("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
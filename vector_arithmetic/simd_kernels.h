@@ -0,0 +1,512 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Hassan El-shazly
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright.
+ *
+ *****************************************************************************/
+/**
+ * @file simd_kernels.h
+ * @brief
+ *
+ * This file provides hand written SIMD kernels for the arithmetic hot loops
+ * (element-wise operations, scalar operations, axpy, dot product and sum)
+ * in SSE2, AVX2 and AVX-512 flavours. The best flavour supported by the
+ * host is detected once with CPUID at startup, so the same binary runs on
+ * every x86 machine. Non x86 builds and non float types use plain loops.
+ *
+ * Setting the environment variable MATRIX_SIMD to "scalar", "sse2" or
+ * "avx2" caps the detected level, which is useful for testing.
+ *
+ * @author Hassan El-shazly
+ * @date Last Edit Oct-2026
+ *
+ */
+
+#ifndef _SIMD_KERNELS_H_
+#define _SIMD_KERNELS_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <complex>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MATRIX_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace matrix_kernels
+{
+    enum class simd_level
+    {
+        scalar,
+        sse2,
+        avx2,
+        avx512
+    };
+
+    /**
+     * @returns the widest instruction set supported by the host,
+     *          capped by the MATRIX_SIMD environment variable if set
+     */
+    inline simd_level detect_simd_level()
+    {
+        simd_level level = simd_level::scalar;
+#ifdef MATRIX_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2"))
+            level = simd_level::sse2;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            level = simd_level::avx2;
+        if (__builtin_cpu_supports("avx512f"))
+            level = simd_level::avx512;
+#endif
+        const char *cap = std::getenv("MATRIX_SIMD");
+        if (cap)
+        {
+            simd_level max_level = simd_level::avx512;
+            if (!std::strcmp(cap, "scalar"))
+                max_level = simd_level::scalar;
+            else if (!std::strcmp(cap, "sse2"))
+                max_level = simd_level::sse2;
+            else if (!std::strcmp(cap, "avx2"))
+                max_level = simd_level::avx2;
+            if (max_level < level)
+                level = max_level;
+        }
+        return level;
+    }
+
+    /**
+     * Instruction set selected at startup
+     */
+    inline const simd_level active_simd_level = detect_simd_level();
+
+    /**
+     * Table of the vector kernels of one type, filled at startup with
+     * the implementations matching the active instruction set
+     */
+    template <typename ValueType>
+    struct simd_table
+    {
+        void (*add)(std::size_t, ValueType *, const ValueType *);
+        void (*sub)(std::size_t, ValueType *, const ValueType *);
+        void (*mul)(std::size_t, ValueType *, const ValueType *);
+        void (*div)(std::size_t, ValueType *, const ValueType *);
+        void (*add_scalar)(std::size_t, ValueType *, ValueType);
+        void (*mul_scalar)(std::size_t, ValueType *, ValueType);
+        void (*div_scalar)(std::size_t, ValueType *, ValueType);
+        void (*axpy)(std::size_t, ValueType, const ValueType *, ValueType *);
+        ValueType (*dot)(std::size_t, const ValueType *, const ValueType *);
+        ValueType (*sum)(std::size_t, const ValueType *);
+    };
+
+    /**************************************************************************
+     ************************  Portable implementations  *********************
+     ************************************************************************/
+
+    namespace scalar
+    {
+        template <typename ValueType>
+        void add(std::size_t n, ValueType *dst, const ValueType *src)
+        {
+            for (std::size_t i = 0; i < n; i++)
+                dst[i] += src[i];
+        }
+
+        template <typename ValueType>
+        void sub(std::size_t n, ValueType *dst, const ValueType *src)
+        {
+            for (std::size_t i = 0; i < n; i++)
+                dst[i] -= src[i];
+        }
+
+        template <typename ValueType>
+        void mul(std::size_t n, ValueType *dst, const ValueType *src)
+        {
+            for (std::size_t i = 0; i < n; i++)
+                dst[i] *= src[i];
+        }
+
+        template <typename ValueType>
+        void div(std::size_t n, ValueType *dst, const ValueType *src)
+        {
+            for (std::size_t i = 0; i < n; i++)
+                dst[i] /= src[i];
+        }
+
+        template <typename ValueType>
+        void add_scalar(std::size_t n, ValueType *dst, ValueType val)
+        {
+            for (std::size_t i = 0; i < n; i++)
+                dst[i] += val;
+        }
+
+        template <typename ValueType>
+        void mul_scalar(std::size_t n, ValueType *dst, ValueType val)
+        {
+            for (std::size_t i = 0; i < n; i++)
+                dst[i] *= val;
+        }
+
+        template <typename ValueType>
+        void div_scalar(std::size_t n, ValueType *dst, ValueType val)
+        {
+            for (std::size_t i = 0; i < n; i++)
+                dst[i] /= val;
+        }
+
+        template <typename ValueType>
+        void axpy(std::size_t n, ValueType alpha, const ValueType *x, ValueType *y)
+        {
+            for (std::size_t i = 0; i < n; i++)
+                y[i] += alpha * x[i];
+        }
+
+        template <typename ValueType>
+        ValueType dot(std::size_t n, const ValueType *a, const ValueType *b)
+        {
+            ValueType res = ValueType();
+            for (std::size_t i = 0; i < n; i++)
+                res += a[i] * b[i];
+            return res;
+        }
+
+        template <typename ValueType>
+        ValueType sum(std::size_t n, const ValueType *a)
+        {
+            ValueType res = ValueType();
+            for (std::size_t i = 0; i < n; i++)
+                res += a[i];
+            return res;
+        }
+    }
+
+#ifdef MATRIX_SIMD_X86
+
+/**
+ * Generates the element-wise, scalar, axpy, dot and sum kernels of one
+ * instruction set. W is the number of lanes, the remaining arguments are
+ * the intrinsics of the register type.
+ */
+#define MATRIX_SIMD_KERNELS(NS, TARGET, T, W, VT, LOAD, STORE, SET1, ADD, SUB, MUL, DIV, FMA, REDUCE) \
+    namespace NS                                                                                       \
+    {                                                                                                  \
+        __attribute__((target(TARGET))) inline void add(std::size_t n, T *dst, const T *src)           \
+        {                                                                                              \
+            std::size_t i = 0;                                                                         \
+            for (; i + W <= n; i += W)                                                                 \
+                STORE(dst + i, ADD(LOAD(dst + i), LOAD(src + i)));                                     \
+            for (; i < n; i++)                                                                         \
+                dst[i] += src[i];                                                                      \
+        }                                                                                              \
+        __attribute__((target(TARGET))) inline void sub(std::size_t n, T *dst, const T *src)           \
+        {                                                                                              \
+            std::size_t i = 0;                                                                         \
+            for (; i + W <= n; i += W)                                                                 \
+                STORE(dst + i, SUB(LOAD(dst + i), LOAD(src + i)));                                     \
+            for (; i < n; i++)                                                                         \
+                dst[i] -= src[i];                                                                      \
+        }                                                                                              \
+        __attribute__((target(TARGET))) inline void mul(std::size_t n, T *dst, const T *src)           \
+        {                                                                                              \
+            std::size_t i = 0;                                                                         \
+            for (; i + W <= n; i += W)                                                                 \
+                STORE(dst + i, MUL(LOAD(dst + i), LOAD(src + i)));                                     \
+            for (; i < n; i++)                                                                         \
+                dst[i] *= src[i];                                                                      \
+        }                                                                                              \
+        __attribute__((target(TARGET))) inline void div(std::size_t n, T *dst, const T *src)           \
+        {                                                                                              \
+            std::size_t i = 0;                                                                         \
+            for (; i + W <= n; i += W)                                                                 \
+                STORE(dst + i, DIV(LOAD(dst + i), LOAD(src + i)));                                     \
+            for (; i < n; i++)                                                                         \
+                dst[i] /= src[i];                                                                      \
+        }                                                                                              \
+        __attribute__((target(TARGET))) inline void add_scalar(std::size_t n, T *dst, T val)           \
+        {                                                                                              \
+            const VT v = SET1(val);                                                                    \
+            std::size_t i = 0;                                                                         \
+            for (; i + W <= n; i += W)                                                                 \
+                STORE(dst + i, ADD(LOAD(dst + i), v));                                                 \
+            for (; i < n; i++)                                                                         \
+                dst[i] += val;                                                                         \
+        }                                                                                              \
+        __attribute__((target(TARGET))) inline void mul_scalar(std::size_t n, T *dst, T val)           \
+        {                                                                                              \
+            const VT v = SET1(val);                                                                    \
+            std::size_t i = 0;                                                                         \
+            for (; i + W <= n; i += W)                                                                 \
+                STORE(dst + i, MUL(LOAD(dst + i), v));                                                 \
+            for (; i < n; i++)                                                                         \
+                dst[i] *= val;                                                                         \
+        }                                                                                              \
+        __attribute__((target(TARGET))) inline void div_scalar(std::size_t n, T *dst, T val)           \
+        {                                                                                              \
+            const VT v = SET1(val);                                                                    \
+            std::size_t i = 0;                                                                         \
+            for (; i + W <= n; i += W)                                                                 \
+                STORE(dst + i, DIV(LOAD(dst + i), v));                                                 \
+            for (; i < n; i++)                                                                         \
+                dst[i] /= val;                                                                         \
+        }                                                                                              \
+        __attribute__((target(TARGET))) inline void axpy(std::size_t n, T alpha, const T *x, T *y)     \
+        {                                                                                              \
+            const VT a = SET1(alpha);                                                                  \
+            std::size_t i = 0;                                                                         \
+            for (; i + W <= n; i += W)                                                                 \
+                STORE(y + i, FMA(a, LOAD(x + i), LOAD(y + i)));                                        \
+            for (; i < n; i++)                                                                         \
+                y[i] += alpha * x[i];                                                                  \
+        }                                                                                              \
+        __attribute__((target(TARGET))) inline T dot(std::size_t n, const T *a, const T *b)            \
+        {                                                                                              \
+            VT acc0 = SET1(0), acc1 = SET1(0);                                                         \
+            std::size_t i = 0;                                                                         \
+            for (; i + 2 * W <= n; i += 2 * W)                                                         \
+            {                                                                                          \
+                acc0 = FMA(LOAD(a + i), LOAD(b + i), acc0);                                            \
+                acc1 = FMA(LOAD(a + i + W), LOAD(b + i + W), acc1);                                    \
+            }                                                                                          \
+            T res = REDUCE(ADD(acc0, acc1));                                                           \
+            for (; i < n; i++)                                                                         \
+                res += a[i] * b[i];                                                                    \
+            return res;                                                                                \
+        }                                                                                              \
+        __attribute__((target(TARGET))) inline T sum(std::size_t n, const T *a)                        \
+        {                                                                                              \
+            VT acc0 = SET1(0), acc1 = SET1(0);                                                         \
+            std::size_t i = 0;                                                                         \
+            for (; i + 2 * W <= n; i += 2 * W)                                                         \
+            {                                                                                          \
+                acc0 = ADD(LOAD(a + i), acc0);                                                         \
+                acc1 = ADD(LOAD(a + i + W), acc1);                                                     \
+            }                                                                                          \
+            T res = REDUCE(ADD(acc0, acc1));                                                           \
+            for (; i < n; i++)                                                                         \
+                res += a[i];                                                                           \
+            return res;                                                                                \
+        }                                                                                              \
+    }
+
+    /**
+     * Horizontal sums of a register
+     */
+    inline float hsum_sse2(__m128 v)
+    {
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, v);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    inline double hsum_sse2(__m128d v)
+    {
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, v);
+        return lanes[0] + lanes[1];
+    }
+
+    __attribute__((target("avx2"))) inline float hsum_avx2(__m256 v)
+    {
+        return hsum_sse2(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+    }
+
+    __attribute__((target("avx2"))) inline double hsum_avx2(__m256d v)
+    {
+        return hsum_sse2(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+    }
+
+    // the halves are extracted by the zero-masking form with every lane
+    // kept, the other forms and _mm512_reduce_add_* start from undefined
+    // registers, which GCC 12 warns about with -Wall
+    __attribute__((target("avx512f"))) inline double hsum_avx512(__m512d v)
+    {
+        return hsum_avx2(_mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xff, v, 0),
+                                       _mm512_maskz_extractf64x4_pd(0xff, v, 1)));
+    }
+
+    __attribute__((target("avx512f"))) inline float hsum_avx512(__m512 v)
+    {
+        const __m512d bits = _mm512_castps_pd(v);
+        return hsum_avx2(_mm256_add_ps(_mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xff, bits, 0)),
+                                       _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xff, bits, 1))));
+    }
+
+    inline __m128 fma_sse2(__m128 a, __m128 b, __m128 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+    inline __m128d fma_sse2(__m128d a, __m128d b, __m128d c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+
+    MATRIX_SIMD_KERNELS(sse2_f32, "sse2", float, 4, __m128, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps,
+                        _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _mm_div_ps, fma_sse2, hsum_sse2)
+    MATRIX_SIMD_KERNELS(sse2_f64, "sse2", double, 2, __m128d, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd,
+                        _mm_add_pd, _mm_sub_pd, _mm_mul_pd, _mm_div_pd, fma_sse2, hsum_sse2)
+    MATRIX_SIMD_KERNELS(avx2_f32, "avx2,fma", float, 8, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps,
+                        _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps, _mm256_div_ps, _mm256_fmadd_ps, hsum_avx2)
+    MATRIX_SIMD_KERNELS(avx2_f64, "avx2,fma", double, 4, __m256d, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd,
+                        _mm256_add_pd, _mm256_sub_pd, _mm256_mul_pd, _mm256_div_pd, _mm256_fmadd_pd, hsum_avx2)
+    MATRIX_SIMD_KERNELS(avx512_f32, "avx512f", float, 16, __m512, _mm512_loadu_ps, _mm512_storeu_ps, _mm512_set1_ps,
+                        _mm512_add_ps, _mm512_sub_ps, _mm512_mul_ps, _mm512_div_ps, _mm512_fmadd_ps, hsum_avx512)
+    MATRIX_SIMD_KERNELS(avx512_f64, "avx512f", double, 8, __m512d, _mm512_loadu_pd, _mm512_storeu_pd, _mm512_set1_pd,
+                        _mm512_add_pd, _mm512_sub_pd, _mm512_mul_pd, _mm512_div_pd, _mm512_fmadd_pd, hsum_avx512)
+
+#undef MATRIX_SIMD_KERNELS
+
+#define MATRIX_SIMD_TABLE(NS) \
+    {NS::add, NS::sub, NS::mul, NS::div, NS::add_scalar, NS::mul_scalar, NS::div_scalar, NS::axpy, NS::dot, NS::sum}
+
+#endif // MATRIX_SIMD_X86
+
+    /**
+     * @returns the kernel table of ValueType for the active instruction set
+     */
+    template <typename ValueType>
+    inline const simd_table<ValueType> &simd_dispatch();
+
+    template <>
+    inline const simd_table<float> &simd_dispatch<float>()
+    {
+        static const simd_table<float> table = [] {
+#ifdef MATRIX_SIMD_X86
+            switch (active_simd_level)
+            {
+            case simd_level::avx512:
+                return simd_table<float> MATRIX_SIMD_TABLE(avx512_f32);
+            case simd_level::avx2:
+                return simd_table<float> MATRIX_SIMD_TABLE(avx2_f32);
+            case simd_level::sse2:
+                return simd_table<float> MATRIX_SIMD_TABLE(sse2_f32);
+            default:
+                break;
+            }
+#endif
+            return simd_table<float> MATRIX_SIMD_TABLE(scalar);
+        }();
+        return table;
+    }
+
+    template <>
+    inline const simd_table<double> &simd_dispatch<double>()
+    {
+        static const simd_table<double> table = [] {
+#ifdef MATRIX_SIMD_X86
+            switch (active_simd_level)
+            {
+            case simd_level::avx512:
+                return simd_table<double> MATRIX_SIMD_TABLE(avx512_f64);
+            case simd_level::avx2:
+                return simd_table<double> MATRIX_SIMD_TABLE(avx2_f64);
+            case simd_level::sse2:
+                return simd_table<double> MATRIX_SIMD_TABLE(sse2_f64);
+            default:
+                break;
+            }
+#endif
+            return simd_table<double> MATRIX_SIMD_TABLE(scalar);
+        }();
+        return table;
+    }
+
+    /**************************************************************************
+     *****************************  Entry points  ****************************
+     ************************************************************************/
+
+    /**
+     * dst[i] (op)= src[i], dst[i] (op)= val, y[i] += alpha * x[i],
+     * sum(a[i] * b[i]) and sum(a[i]) over n elements.
+     * float and double go through the dispatched SIMD kernels, complex
+     * additions are done on the interleaved real/imaginary floats, every
+     * other type uses the portable loops.
+     */
+    template <typename ValueType>
+    inline void vec_add(std::size_t n, ValueType *dst, const ValueType *src) { scalar::add(n, dst, src); }
+
+    template <typename ValueType>
+    inline void vec_sub(std::size_t n, ValueType *dst, const ValueType *src) { scalar::sub(n, dst, src); }
+
+    template <typename ValueType>
+    inline void vec_mul(std::size_t n, ValueType *dst, const ValueType *src) { scalar::mul(n, dst, src); }
+
+    template <typename ValueType>
+    inline void vec_div(std::size_t n, ValueType *dst, const ValueType *src) { scalar::div(n, dst, src); }
+
+    template <typename ValueType>
+    inline void vec_add_scalar(std::size_t n, ValueType *dst, ValueType val) { scalar::add_scalar(n, dst, val); }
+
+    template <typename ValueType>
+    inline void vec_sub_scalar(std::size_t n, ValueType *dst, ValueType val)
+    {
+        for (std::size_t i = 0; i < n; i++)
+            dst[i] -= val;
+    }
+
+    template <typename ValueType>
+    inline void vec_mul_scalar(std::size_t n, ValueType *dst, ValueType val) { scalar::mul_scalar(n, dst, val); }
+
+    template <typename ValueType>
+    inline void vec_div_scalar(std::size_t n, ValueType *dst, ValueType val) { scalar::div_scalar(n, dst, val); }
+
+    template <typename ValueType>
+    inline void vec_axpy(std::size_t n, ValueType alpha, const ValueType *x, ValueType *y) { scalar::axpy(n, alpha, x, y); }
+
+    template <typename ValueType>
+    inline ValueType vec_dot(std::size_t n, const ValueType *a, const ValueType *b) { return scalar::dot(n, a, b); }
+
+    template <typename ValueType>
+    inline ValueType vec_sum(std::size_t n, const ValueType *a) { return scalar::sum(n, a); }
+
+#define MATRIX_SIMD_ENTRY_POINTS(T)                                                                                     \
+    inline void vec_add(std::size_t n, T *dst, const T *src) { simd_dispatch<T>().add(n, dst, src); }                  \
+    inline void vec_sub(std::size_t n, T *dst, const T *src) { simd_dispatch<T>().sub(n, dst, src); }                  \
+    inline void vec_mul(std::size_t n, T *dst, const T *src) { simd_dispatch<T>().mul(n, dst, src); }                  \
+    inline void vec_div(std::size_t n, T *dst, const T *src) { simd_dispatch<T>().div(n, dst, src); }                  \
+    inline void vec_add_scalar(std::size_t n, T *dst, T val) { simd_dispatch<T>().add_scalar(n, dst, val); }           \
+    inline void vec_sub_scalar(std::size_t n, T *dst, T val) { simd_dispatch<T>().add_scalar(n, dst, -val); }          \
+    inline void vec_mul_scalar(std::size_t n, T *dst, T val) { simd_dispatch<T>().mul_scalar(n, dst, val); }           \
+    inline void vec_div_scalar(std::size_t n, T *dst, T val) { simd_dispatch<T>().div_scalar(n, dst, val); }           \
+    inline void vec_axpy(std::size_t n, T alpha, const T *x, T *y) { simd_dispatch<T>().axpy(n, alpha, x, y); }        \
+    inline T vec_dot(std::size_t n, const T *a, const T *b) { return simd_dispatch<T>().dot(n, a, b); }                \
+    inline T vec_sum(std::size_t n, const T *a) { return simd_dispatch<T>().sum(n, a); }
+
+    MATRIX_SIMD_ENTRY_POINTS(float)
+    MATRIX_SIMD_ENTRY_POINTS(double)
+
+#undef MATRIX_SIMD_ENTRY_POINTS
+
+    template <typename FloatType>
+    inline void vec_add(std::size_t n, std::complex<FloatType> *dst, const std::complex<FloatType> *src)
+    {
+        vec_add(2 * n, reinterpret_cast<FloatType *>(dst), reinterpret_cast<const FloatType *>(src));
+    }
+
+    template <typename FloatType>
+    inline void vec_sub(std::size_t n, std::complex<FloatType> *dst, const std::complex<FloatType> *src)
+    {
+        vec_sub(2 * n, reinterpret_cast<FloatType *>(dst), reinterpret_cast<const FloatType *>(src));
+    }
+
+    template <typename FloatType>
+    inline std::complex<FloatType> vec_sum(std::size_t n, const std::complex<FloatType> *a)
+    {
+        const FloatType *p = reinterpret_cast<const FloatType *>(a);
+        FloatType re = FloatType(), im = FloatType();
+        for (std::size_t i = 0; i < n; i++)
+        {
+            re += p[2 * i];
+            im += p[2 * i + 1];
+        }
+        return std::complex<FloatType>(re, im);
+    }
+
+    template <typename FloatType>
+    inline void vec_mul_scalar(std::size_t n, std::complex<FloatType> *dst, std::complex<FloatType> val)
+    {
+        if (val.imag() == FloatType())
+            vec_mul_scalar(2 * n, reinterpret_cast<FloatType *>(dst), val.real());
+        else
+            scalar::mul_scalar(n, dst, val);
+    }
+}
+
+#endif // End of the file
@@ -1,7 +1,12 @@
 #ifndef _VECTOR_ARITHMETIC_
 #define _VECTOR_ARITHMETIC_
 
+#include <string>
 #include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+#include "simd_kernels.h"
 
 using std::vector ;
 
@@ -13,8 +18,7 @@ namespace vector_arithmetic_operations
         size_t size = vec1.size();
         if(size != vec2.size())
             throw std::length_error("vector_arithmetic::addition -> vectors must be the same size");
-        for(int i = 0; i < size; i++)
-            vec1[i] += vec2[i];
+        matrix_kernels::vec_add(size, vec1.data(), vec2.data());
         return vec1;
     }
 
@@ -24,8 +28,7 @@ namespace vector_arithmetic_operations
         size_t size = vec1.size();
         if(size != vec2.size())
             throw std::length_error("vector_arithmetic::subtraction -> vectors must be the same size");
-        for(int i = 0; i < size; i++)
-            vec1[i] -= vec2[i];
+        matrix_kernels::vec_sub(size, vec1.data(), vec2.data());
         return vec1;
     }
 
@@ -35,8 +38,7 @@ namespace vector_arithmetic_operations
         size_t size = vec1.size();
         if(size != vec2.size())
             throw std::length_error("vector_arithmetic::multiplication -> vectors must be the same size");
-        for(int i = 0; i < size; i++)
-            vec1[i] *= vec2[i];
+        matrix_kernels::vec_mul(size, vec1.data(), vec2.data());
         return vec1;
     }
 
@@ -46,138 +48,270 @@ namespace vector_arithmetic_operations
         size_t size = vec1.size();
         if(size != vec2.size())
             throw std::length_error("vector_arithmetic::devision -> vectors must be the same size");
-        for(int i = 0; i < size; i++)
-            vec1[i] /= vec2[i];
+        matrix_kernels::vec_div(size, vec1.data(), vec2.data());
         return vec1;
     }
 
+    /**
+     * Expression templates: the non-compound operators below don't compute
+     * anything, they return a node describing the operation. The tree is
+     * evaluated in one fused loop when converted to a vector, assigned with
+     * a compound operator, or reduced with sum / dot_product, so
+     * a + b * 2 - c makes a single pass and no temporary vectors.
+     * Nodes keep references to their operands, don't store them in auto.
+     */
+    template <typename Derived>
+    struct vector_expr
+    {
+        const Derived& derived() const
+        {
+            return static_cast<const Derived&>(*this);
+        }
+
+        template <typename ValueType>
+        operator vector<ValueType>() const
+        {
+            const Derived& expr = derived();
+            vector<ValueType> res(expr.size());
+            for(size_t i = 0; i < res.size(); i++)
+                res[i] = expr[i];
+            return res;
+        }
+    };
+
     template <typename ValueType>
-    vector<ValueType> operator+(const vector<ValueType>& vec1, const vector<ValueType>& vec2)
+    struct vector_leaf : vector_expr<vector_leaf<ValueType>>
     {
-        size_t size = vec1.size();
-        if(size != vec2.size())
-            throw std::length_error("vector_arithmetic::addition -> vectors must be the same size");
-        vector<ValueType> res(size);
-        for(int i = 0; i < size; i++)
-            res[i] = vec1[i] + vec2[i];
-        return res;
-    }
+        using value_type = ValueType;
+        explicit vector_leaf(const vector<ValueType>& vec) : ptr(vec.data()), len(vec.size()) {}
+        size_t size() const { return len; }
+        ValueType operator[](size_t i) const { return ptr[i]; }
+        const ValueType* ptr;
+        size_t len;
+    };
+
+    struct vector_add_op
+    {
+        static constexpr const char* name = "vector_arithmetic::addition";
+        template <typename T> static T apply(const T& a, const T& b) { return a + b; }
+    };
+
+    struct vector_sub_op
+    {
+        static constexpr const char* name = "vector_arithmetic::subtraction";
+        template <typename T> static T apply(const T& a, const T& b) { return a - b; }
+    };
+
+    struct vector_mul_op
+    {
+        static constexpr const char* name = "vector_arithmetic::multiplication";
+        template <typename T> static T apply(const T& a, const T& b) { return a * b; }
+    };
+
+    struct vector_div_op
+    {
+        static constexpr const char* name = "vector_arithmetic::devision";
+        template <typename T> static T apply(const T& a, const T& b) { return a / b; }
+    };
+
+    template <typename Op, typename Lhs, typename Rhs>
+    struct vector_binary_expr : vector_expr<vector_binary_expr<Op, Lhs, Rhs>>
+    {
+        using value_type = typename Lhs::value_type;
+        vector_binary_expr(const Lhs& l, const Rhs& r) : lhs(l), rhs(r)
+        {
+            if(lhs.size() != rhs.size())
+                throw std::length_error(std::string(Op::name) + " -> vectors must be the same size");
+        }
+        size_t size() const { return lhs.size(); }
+        value_type operator[](size_t i) const { return Op::apply(lhs[i], rhs[i]); }
+        Lhs lhs;
+        Rhs rhs;
+    };
+
+    template <typename Op, typename Expr>
+    struct vector_scalar_expr : vector_expr<vector_scalar_expr<Op, Expr>>
+    {
+        using value_type = typename Expr::value_type;
+        vector_scalar_expr(const Expr& e, const value_type& v) : expr(e), val(v) {}
+        size_t size() const { return expr.size(); }
+        value_type operator[](size_t i) const { return Op::apply(expr[i], val); }
+        Expr expr;
+        value_type val;
+    };
+
+    /**
+     * Operand traits: vectors become leaves, nodes are used as they are
+     */
+    template <typename T, typename = void>
+    struct vector_operand : std::false_type {};
 
     template <typename ValueType>
-    vector<ValueType> operator-(const vector<ValueType>& vec1, const vector<ValueType>& vec2)
+    struct vector_operand<vector<ValueType>> : std::true_type
     {
-        size_t size = vec1.size();
-        if(size != vec2.size())
-            throw std::length_error("vector_arithmetic::subtraction -> vectors must be the same size");
-        vector<ValueType> res(size);
-        for(int i = 0; i < size; i++)
-            res[i] = vec1[i] - vec2[i];
-        return res;
+        using type = vector_leaf<ValueType>;
+        using value_type = ValueType;
+        static type wrap(const vector<ValueType>& vec) { return type(vec); }
+    };
+
+    template <typename Expr>
+    struct vector_operand<Expr, typename std::enable_if<std::is_base_of<vector_expr<Expr>, Expr>::value>::type>
+        : std::true_type
+    {
+        using type = Expr;
+        using value_type = typename Expr::value_type;
+        static const type& wrap(const Expr& expr) { return expr; }
+    };
+
+    template <typename Lhs, typename Rhs>
+    using enable_if_vector_operands = typename std::enable_if<
+        vector_operand<Lhs>::value && vector_operand<Rhs>::value>::type;
+
+    template <typename Lhs>
+    using enable_if_vector_operand = typename std::enable_if<vector_operand<Lhs>::value>::type;
+
+    template <typename Op, typename Lhs, typename Rhs>
+    vector_binary_expr<Op, typename vector_operand<Lhs>::type, typename vector_operand<Rhs>::type>
+    make_vector_expr(const Lhs& lhs, const Rhs& rhs)
+    {
+        return {vector_operand<Lhs>::wrap(lhs), vector_operand<Rhs>::wrap(rhs)};
     }
 
-    template <typename ValueType>
-    vector<ValueType> operator*(const vector<ValueType>& vec1, const vector<ValueType>& vec2)
+    template <typename Op, typename Lhs>
+    vector_scalar_expr<Op, typename vector_operand<Lhs>::type>
+    make_vector_scalar_expr(const Lhs& lhs, const typename vector_operand<Lhs>::value_type& val)
     {
-        size_t size = vec1.size();
-        if(size != vec2.size())
-            throw std::length_error("vector_arithmetic::multiplication -> vectors must be the same size");
-        vector<ValueType> res(size);
-        for(int i = 0; i < size; i++)
-            res[i] = vec1[i] * vec2[i];
-        return res;
+        return {vector_operand<Lhs>::wrap(lhs), val};
     }
 
-    template <typename ValueType>
-    vector<ValueType> operator/(const vector<ValueType>& vec1, const vector<ValueType>& vec2)
+    template <typename Lhs, typename Rhs, typename = enable_if_vector_operands<Lhs, Rhs>>
+    auto operator+(const Lhs& vec1, const Rhs& vec2)
     {
-        size_t size = vec1.size();
-        if(size != vec2.size())
-            throw std::length_error("vector_arithmetic::devision -> vectors must be the same size");
-        vector<ValueType> res(size);
-        for(int i = 0; i < size; i++)
-            res[i] = vec1[i] / vec2[i];
-        return res;
+        return make_vector_expr<vector_add_op>(vec1, vec2);
     }
 
-    template <typename ValueType>
-    vector<ValueType>& operator+=(vector<ValueType>& vec, const ValueType& val)
+    template <typename Lhs, typename Rhs, typename = enable_if_vector_operands<Lhs, Rhs>>
+    auto operator-(const Lhs& vec1, const Rhs& vec2)
     {
-        for(auto& element : vec)
-            element += val;
-        return vec;
+        return make_vector_expr<vector_sub_op>(vec1, vec2);
     }
 
-    template <typename ValueType>
-    vector<ValueType>& operator-=(vector<ValueType>& vec, const ValueType& val)
+    template <typename Lhs, typename Rhs, typename = enable_if_vector_operands<Lhs, Rhs>>
+    auto operator*(const Lhs& vec1, const Rhs& vec2)
     {
-        for(auto& element : vec)
-            element -= val;
-        return vec;
+        return make_vector_expr<vector_mul_op>(vec1, vec2);
     }
 
-    template <typename ValueType>
-    vector<ValueType>& operator*=(vector<ValueType>& vec, const ValueType& val)
+    template <typename Lhs, typename Rhs, typename = enable_if_vector_operands<Lhs, Rhs>>
+    auto operator/(const Lhs& vec1, const Rhs& vec2)
     {
-        for(auto& element : vec)
-            element *= val;
-        return vec;
+        return make_vector_expr<vector_div_op>(vec1, vec2);
     }
 
-    template <typename ValueType>
-    vector<ValueType>& operator/=(vector<ValueType>& vec, const ValueType& val)
+    template <typename Lhs, typename = enable_if_vector_operand<Lhs>>
+    auto operator+(const Lhs& vec, const typename vector_operand<Lhs>::value_type& val)
     {
-        for(auto& element : vec)
-            element /= val;
+        return make_vector_scalar_expr<vector_add_op>(vec, val);
+    }
+
+    template <typename Lhs, typename = enable_if_vector_operand<Lhs>>
+    auto operator-(const Lhs& vec, const typename vector_operand<Lhs>::value_type& val)
+    {
+        return make_vector_scalar_expr<vector_sub_op>(vec, val);
+    }
+
+    template <typename Lhs, typename = enable_if_vector_operand<Lhs>>
+    auto operator*(const Lhs& vec, const typename vector_operand<Lhs>::value_type& val)
+    {
+        return make_vector_scalar_expr<vector_mul_op>(vec, val);
+    }
+
+    template <typename Lhs, typename = enable_if_vector_operand<Lhs>>
+    auto operator/(const Lhs& vec, const typename vector_operand<Lhs>::value_type& val)
+    {
+        return make_vector_scalar_expr<vector_div_op>(vec, val);
+    }
+
+    /**
+     * Compound assignments from expressions, evaluated in the same pass
+     */
+    template <typename ValueType, typename Expr, typename Assign>
+    vector<ValueType>& assign_vector_expr(vector<ValueType>& vec, const vector_expr<Expr>& expr,
+                                          Assign assign, const char* name)
+    {
+        const Expr& e = expr.derived();
+        if(vec.size() != e.size())
+            throw std::length_error(std::string(name) + " -> vectors must be the same size");
+        for(size_t i = 0; i < vec.size(); i++)
+            assign(vec[i], e[i]);
         return vec;
     }
 
+    template <typename ValueType, typename Expr>
+    vector<ValueType>& operator+=(vector<ValueType>& vec, const vector_expr<Expr>& expr)
+    {
+        return assign_vector_expr(vec, expr, [](ValueType& a, const ValueType& b) { a += b; }, vector_add_op::name);
+    }
+
+    template <typename ValueType, typename Expr>
+    vector<ValueType>& operator-=(vector<ValueType>& vec, const vector_expr<Expr>& expr)
+    {
+        return assign_vector_expr(vec, expr, [](ValueType& a, const ValueType& b) { a -= b; }, vector_sub_op::name);
+    }
+
+    template <typename ValueType, typename Expr>
+    vector<ValueType>& operator*=(vector<ValueType>& vec, const vector_expr<Expr>& expr)
+    {
+        return assign_vector_expr(vec, expr, [](ValueType& a, const ValueType& b) { a *= b; }, vector_mul_op::name);
+    }
+
+    template <typename ValueType, typename Expr>
+    vector<ValueType>& operator/=(vector<ValueType>& vec, const vector_expr<Expr>& expr)
+    {
+        return assign_vector_expr(vec, expr, [](ValueType& a, const ValueType& b) { a /= b; }, vector_div_op::name);
+    }
+
+    /**
+     * Evaluates an expression into a vector
+     */
+    template <typename Expr>
+    vector<typename Expr::value_type> eval(const vector_expr<Expr>& expr)
+    {
+        return expr;
+    }
+
     template <typename ValueType>
-    vector<ValueType> operator+(const vector<ValueType>& vec, const ValueType& val)
+    vector<ValueType>& operator+=(vector<ValueType>& vec, const ValueType& val)
     {
-        vector<ValueType> res(vec.size());
-        size_t i = 0 ;
-        for(auto& element : vec)
-            res[i++] = element + val;
-        return res;
+        matrix_kernels::vec_add_scalar(vec.size(), vec.data(), val);
+        return vec;
     }
 
     template <typename ValueType>
-    vector<ValueType> operator-(const vector<ValueType>& vec, const ValueType& val)
+    vector<ValueType>& operator-=(vector<ValueType>& vec, const ValueType& val)
     {
-        vector<ValueType> res(vec.size());
-        size_t i = 0 ;
-        for(auto& element : vec)
-            res[i++] = element - val;
-        return res;
+        matrix_kernels::vec_sub_scalar(vec.size(), vec.data(), val);
+        return vec;
     }
 
     template <typename ValueType>
-    vector<ValueType> operator*(const vector<ValueType>& vec, const ValueType& val)
+    vector<ValueType>& operator*=(vector<ValueType>& vec, const ValueType& val)
     {
-        vector<ValueType> res(vec.size());
-        size_t i = 0 ;
-        for(auto& element : vec)
-            res[i++] = element * val;
-        return res;
+        matrix_kernels::vec_mul_scalar(vec.size(), vec.data(), val);
+        return vec;
     }
 
     template <typename ValueType>
-    vector<ValueType> operator/(const vector<ValueType>& vec, const ValueType& val)
+    vector<ValueType>& operator/=(vector<ValueType>& vec, const ValueType& val)
     {
-        vector<ValueType> res(vec.size());
-        size_t i = 0 ;
-        for(auto& element : vec)
-            res[i++] = element / val;
-        return res;
+        matrix_kernels::vec_div_scalar(vec.size(), vec.data(), val);
+        return vec;
     }
 
     template <typename ValueType>
     ValueType sum(const vector<ValueType>& vec)
     {
-        ValueType res = ValueType();
-        for(const auto& element : vec)
-            res += element;
-        return res;
+        return matrix_kernels::vec_sum(vec.size(), vec.data());
     }
 
     template <typename ValueType>
@@ -186,12 +320,27 @@ namespace vector_arithmetic_operations
         size_t size = vec1.size();
         if(size != vec2.size())
             throw std::length_error("vector_arithmetic::dot_product -> vectors must be the same size");
-        ValueType res = ValueType();
-        for(int i = 0; i < size; i++)
-            res += vec1[i] * vec2[i] ;
+        return matrix_kernels::vec_dot(size, vec1.data(), vec2.data());
+    }
+
+    template <typename Expr>
+    typename Expr::value_type sum(const vector_expr<Expr>& expr)
+    {
+        const Expr& e = expr.derived();
+        typename Expr::value_type res = typename Expr::value_type();
+        for(size_t i = 0; i < e.size(); i++)
+            res += e[i];
         return res;
     }
 
+    template <typename Lhs, typename Rhs, typename = enable_if_vector_operands<Lhs, Rhs>,
+              typename = typename std::enable_if<!std::is_same<Lhs, vector<typename Lhs::value_type>>::value ||
+                                                 !std::is_same<Rhs, vector<typename Rhs::value_type>>::value>::type>
+    auto dot_product(const Lhs& vec1, const Rhs& vec2)
+    {
+        return sum(vec1 * vec2);
+    }
+
 }
 
 #endif
\ No newline at end of file